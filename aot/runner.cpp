@@ -0,0 +1,131 @@
+// Harness linked with a c8recomp generated translation unit (make aot ROM=<file>).
+//   verify: interpreter and compiled code run side by side from the same seed and the same
+//           scripted key presses, full machine state is compared after every compiled block;
+//           once with no quirks and once with every quirk set. make test runs it on
+//           tests/aot_mixed.ch8
+//   bench:  instructions per second of chip8::Run against AotRun
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "aot.h"
+#include "chip8.h"
+
+namespace
+{
+    // Deterministic key schedule: every frame's worth of instructions, one key (or none) is held.
+    void Keys(chip8 &c, uint64_t step, uint32_t seed)
+    {
+        uint32_t h = static_cast<uint32_t>(step) * 2654435761u ^ seed;
+        h ^= h >> 15;
+        memset(c.keypad, 0, sizeof(c.keypad));
+        if (h & 0x10u)
+        {
+            c.keypad[h & 0xFu] = 1;
+        }
+    }
+
+    bool Same(chip8 const &a, chip8 const &b)
+    {
+        static chip8::Snapshot sa, sb;
+        a.Save(sa);
+        b.Save(sb);
+        return memcmp(sa.memory, sb.memory, sizeof(sa.memory)) == 0 &&
+               memcmp(sa.v_registers, sb.v_registers, sizeof(sa.v_registers)) == 0 &&
+               memcmp(sa.stack, sb.stack, sizeof(sa.stack)) == 0 && sa.pc == sb.pc && sa.index == sb.index &&
+               sa.opcode == sb.opcode && sa.sp == sb.sp && sa.delay_timer == sb.delay_timer &&
+               sa.sound_timer == sb.sound_timer && memcmp(sa.video, sb.video, sizeof(sa.video)) == 0;
+    }
+
+    int Verify(uint64_t instructions, uint32_t seed, uint8_t quirks)
+    {
+        static chip8 interp(seed), compiled(seed);
+        interp.Reset(seed);
+        compiled.Reset(seed);
+        interp.quirks = compiled.quirks = quirks;
+        interp.LoadROM(aot_program.rom, aot_program.rom_size);
+        compiled.LoadROM(aot_program.rom, aot_program.rom_size);
+
+        uint64_t done = 0;
+        uint64_t blocks = 0;
+        while (done < instructions)
+        {
+            Keys(interp, done / chip8::INST_EXE, seed);
+            memcpy(compiled.keypad, interp.keypad, sizeof(interp.keypad));
+
+            uint16_t pc = compiled.pc;
+            uint32_t n = aot_program.run_block(compiled);
+            if (n == 0)
+            {
+                compiled.Cycle();
+                n = 1;
+            }
+            else
+            {
+                ++blocks;
+            }
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                interp.Cycle();
+            }
+            done += n;
+
+            if (!Same(interp, compiled))
+            {
+                printf("DIVERGED in block at %03X after %llu instructions (interpreter pc %03X, compiled pc %03X, "
+                       "quirks %02X)\n",
+                       pc, static_cast<unsigned long long>(done), interp.pc, compiled.pc, quirks);
+                return EXIT_FAILURE;
+            }
+        }
+        printf("OK: %llu instructions, %llu through compiled blocks, state identical (quirks %02X)\n",
+               static_cast<unsigned long long>(done), static_cast<unsigned long long>(blocks), quirks);
+        return EXIT_SUCCESS;
+    }
+
+    int Bench(uint64_t instructions, uint32_t seed)
+    {
+        static chip8 interp(seed), compiled(seed);
+        interp.LoadROM(aot_program.rom, aot_program.rom_size);
+        compiled.LoadROM(aot_program.rom, aot_program.rom_size);
+
+        auto start = std::chrono::steady_clock::now();
+        interp.Run(instructions);
+        auto middle = std::chrono::steady_clock::now();
+        uint64_t done = AotRun(aot_program, compiled, instructions);
+        auto end = std::chrono::steady_clock::now();
+
+        double a = std::chrono::duration<double>(middle - start).count();
+        double b = std::chrono::duration<double>(end - middle).count();
+        printf("interpreter %.1f M/s, compiled %.1f M/s (%.2fx)\n", instructions / a / 1e6, done / b / 1e6, (a / instructions) / (b / done));
+        return EXIT_SUCCESS;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4 || (strcmp(argv[1], "verify") != 0 && strcmp(argv[1], "bench") != 0))
+    {
+        fprintf(stderr, "Usage: %s verify|bench [instructions] [seed]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    uint64_t instructions = argc > 2 ? strtoull(argv[2], nullptr, 0) : 10000000;
+    uint32_t seed = argc > 3 ? static_cast<uint32_t>(strtoul(argv[3], nullptr, 0)) : 1;
+
+    printf("%u compiled blocks, %zu byte ROM\n", aot_program.block_count, aot_program.rom_size);
+    if (strcmp(argv[1], "bench") == 0)
+    {
+        return Bench(instructions, seed);
+    }
+    uint8_t const all = chip8::QUIRK_SHIFT | chip8::QUIRK_LOAD_STORE | chip8::QUIRK_JUMP | chip8::QUIRK_VF_RESET |
+                        chip8::QUIRK_WRAP;
+    for (uint8_t quirks : {uint8_t{0}, all})
+    {
+        if (Verify(instructions, seed, quirks) != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "chip8.h"
+
+// Static control flow recovery over a ROM image. Starting at DATA_START it follows 1nnn/2nnn/00EE
+// and skip edges, splits code into basic blocks, marks Annn referenced bytes drawn by Dxyn as
+// sprite data, and flags Bnnn indirect jumps and Fx55/Fx33 stores that may rewrite code.
+// The result can be written as Graphviz DOT for people or as a hints file for tools that
+// pre-decode or compile blocks (see ReadHints). c8recomp is the consumer; the interpreter's
+// dispatch tables already decode every opcode up front and it keeps no block cache to seed.
+struct RomAnalysis
+{
+    enum Flags : uint8_t
+    {
+        CODE = 1u << 0,        // byte belongs to a reachable instruction
+        INSTRUCTION = 1u << 1, // first byte of a reachable instruction
+        LEADER = 1u << 2,      // first instruction of a basic block
+        DATA = 1u << 3,        // read as sprite / table data through I
+        WRITTEN = 1u << 4,     // target of an Fx55 / Fx33 store with a known I
+        INDIRECT = 1u << 5     // Bnnn site, successors unknown
+    };
+
+    enum class Exit : uint8_t
+    {
+        Fallthrough, // ran into the next block's leader
+        Jump,        // 1nnn
+        Call,        // 2nnn, successors are the callee and the return site
+        Return,      // 00EE
+        Skip,        // 3xkk / 4xkk / 5xyN / 9xyN / Ex9E / ExA1
+        Indirect,    // Bnnn
+        Halt,        // 1nnn to itself
+        End          // ran off the end of memory
+    };
+
+    struct Block
+    {
+        uint16_t start;
+        uint16_t end; // one past the last instruction byte
+        Exit exit;
+        uint8_t successor_count;
+        uint16_t successors[2];
+        bool self_modifying; // a known store in the ROM writes into this block
+        bool unknown_store;  // the block stores through an I the analysis couldn't follow
+    };
+
+    uint8_t flags[chip8::MEM_SIZE] = {};
+    std::vector<Block> blocks; // sorted by start
+
+    // image is a full 4 KB memory image with the ROM at DATA_START (e.g. chip8::memory after
+    // LoadROM), rom_size bounds the walk.
+    static RomAnalysis Analyze(uint8_t const *image, size_t rom_size);
+
+    // Block starting at address, nullptr if address isn't a leader.
+    Block const *Find(uint16_t address) const;
+
+    // Pass the same image to label blocks with their disassembly, or nullptr for addresses only.
+    void WriteDot(FILE *out, uint8_t const *image) const;
+
+    // Line based, one record per line:
+    //   c8hints 1
+    //   block <start> <end> <exit> <successor count> <s0> <s1> <self_modifying> <unknown_store>
+    //   data <address> <length>
+    // Addresses are hex, everything else decimal. WRITTEN bytes aren't stored, self_modifying
+    // carries what consumers need.
+    void WriteHints(FILE *out) const;
+    static bool ReadHints(FILE *in, RomAnalysis &out);
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "chip8.h"
+
+// Interface between the runtime and a ROM statically recompiled by tools/c8recomp.
+// The generated translation unit defines aot_program; each compiled basic block is a function
+// over the same chip8 state the interpreter uses, with operands folded into constants.
+struct AotProgram
+{
+    uint8_t const *rom; // the bytes that were compiled, load these (LoadROM) before running
+    size_t rom_size;
+
+    // Executes the block at c.pc if one was compiled and its bytes in memory still match what
+    // was compiled. Returns instructions executed, 0 means the interpreter has to take this one.
+    uint32_t (*run_block)(chip8 &c);
+
+    uint32_t block_count;
+};
+
+extern AotProgram const aot_program;
+
+// Runs at least budget instructions (a block in flight is finished), compiled code where
+// possible and chip8::Cycle for indirect targets, self-modified code and anything not compiled.
+// Returns instructions executed.
+uint64_t AotRun(AotProgram const &program, chip8 &c, uint64_t budget);
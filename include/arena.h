@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Bump allocator over one anonymous mapping, for the long lived per-worker data of batch runs
+// (instances, snapshot buffers, trace rings). On Linux the mapping is bound to a NUMA node
+// (preferred, so it still works when the node is full) and pages are touched by the allocating
+// thread, so memory ends up next to the worker that uses it. Nothing is freed individually; the
+// whole arena goes at once and destructors are the caller's business.
+class Arena
+{
+public:
+    // node < 0 leaves placement to the kernel (first touch)
+    Arena(size_t capacity, int node = -1);
+    ~Arena();
+
+    Arena(Arena const &) = delete;
+    Arena &operator=(Arena const &) = delete;
+
+    // nullptr when the arena is full
+    void *Allocate(size_t size, size_t align = alignof(std::max_align_t));
+
+    template <typename T, typename... Args>
+    T *New(Args &&...args)
+    {
+        void *memory = Allocate(sizeof(T), alignof(T));
+        return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+    }
+
+    template <typename T>
+    T *Array(size_t count)
+    {
+        if (count > SIZE_MAX / sizeof(T))
+        {
+            return nullptr;
+        }
+        void *memory = Allocate(sizeof(T) * count, alignof(T));
+        return memory ? new (memory) T[count]() : nullptr;
+    }
+
+    // Forgets every allocation, the memory stays mapped and bound
+    void Reset()
+    {
+        used = 0;
+    }
+
+    size_t Used() const
+    {
+        return used;
+    }
+    size_t Capacity() const
+    {
+        return capacity;
+    }
+    // Node the mapping is bound to, -1 if unbound
+    int Node() const
+    {
+        return node;
+    }
+
+private:
+    uint8_t *base{};
+    size_t capacity = 0;
+    size_t used = 0;
+    int node = -1;
+};
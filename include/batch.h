@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Runs a large population of instances of one ROM across every allowed CPU, one pinned worker per
+// CPU. Each worker allocates its instances, their snapshot buffers and (optionally) trace rings
+// from its own Arena bound to its CPU's NUMA node, so a worker never touches another socket's
+// memory. Results are reported per node to make any remaining cross-node traffic visible as a
+// throughput gap between nodes or against the local = false baseline.
+class Batch
+{
+public:
+    struct Options
+    {
+        size_t instances = 4096;
+        int frames = 600;              // frames run by every instance
+        int instructions_per_frame = 16;
+        int snapshot_every = 60;       // frames between Save()s into each instance's buffer, 0 = never
+        size_t trace_capacity = 0;     // per instance trace ring entries, 0 = no tracing
+        int workers = 0;               // 0 = one per allowed CPU
+        bool pin = true;               // pin workers to their CPU
+        bool local = true;             // per-worker node-local arenas; false = everything allocated
+                                       // by the calling thread, the pre-NUMA behaviour
+        uint32_t seed = 1;
+    };
+
+    struct Node
+    {
+        int node = 0;
+        int workers = 0;
+        size_t instances = 0;
+        uint64_t instructions = 0;
+        double seconds = 0;            // slowest worker on the node
+        size_t arena_bytes = 0;        // node-local arena bytes used, 0 when local = false
+    };
+
+    struct Result
+    {
+        std::vector<Node> nodes;       // only nodes that ran workers
+        uint64_t instructions = 0;
+        double seconds = 0;            // slowest worker overall
+        bool pinned = false;           // every worker was pinned
+    };
+
+    // rom is copied into every instance; returns an empty result if it doesn't fit
+    static Result Run(uint8_t const *rom, size_t size, Options const &options);
+};
@@ -1,40 +1,130 @@
-#include <cstdint>  // unint8_t, uint16_t, etc..
-#include <fstream>  // opening files
-#include <iostream> // output to cli
-#include <chrono>   // timing and random seed
-#include <random>   // random functions
+#pragma once
 
-class chip8_tobias
+#include <array>
+#include <cstddef>
+#include <cstdint> // unint8_t, uint16_t, etc..
+#include <random>
+
+class PagedState;
+class TraceRing;
+
+
+#define DEFAULT_MEM_SIZE 4096 // bytes
+#define DEFAULT_WIDTH 64
+#define DEFAULT_HEIGHT 32
+#define DEFAULT_REGISTER_STACK_SIZE 16
+#define DEFAULT_EXE_SPEED 1 // MHZ
+#define DEFAULT_INST_EXE 16 // Instructions Fetch
+
+class chip8
 {
 private:
+    /* data */
+    std::default_random_engine rng;
+    std::uniform_int_distribution<uint8_t> randByte;
+
 public:
-    static constexpr uint16_t START = 0x200;
-    static constexpr uint16_t END = 0x1FF;
+    // static constexpr to avoid wasting memory, allocate to the class not the instance
+    
+    static constexpr int MEM_SIZE = DEFAULT_MEM_SIZE;
+    static constexpr int DISPLAY_WIDTH = DEFAULT_WIDTH;
+    static constexpr int DISPLAY_HEIGHT = DEFAULT_HEIGHT;
+    static constexpr int REGISTER_STACK_SIZE = DEFAULT_REGISTER_STACK_SIZE;
+    static constexpr int EXE_SPEED = DEFAULT_EXE_SPEED;
+    static constexpr int INST_EXE = DEFAULT_INST_EXE;
+    
+
+    static constexpr uint16_t RESERVED_START = 0x000; // Memory starting address, reserved for interpreter
+    static constexpr uint16_t RESERVED_END = 0x1FF;   // Memory ending address, reserved for interpreter
+
+    static constexpr uint16_t MEM_START = 0x000;
+    static constexpr uint16_t MEM_END = 0xFFF;
+
+    static constexpr uint16_t DATA_START = 0x200;     // Data space min
+    static constexpr uint16_t DATA_END = 0xFFF;       // Data space max
+    static constexpr uint16_t DATA_ETI_START = 0x600; // (alt.) Data space
+
     static constexpr uint16_t FONT_START = 0x050;
-    static constexpr uint16_t FONT_START = 0x09F;
-    static constexpr uint16_t START_SPACE = 0x000;
-    static constexpr uint16_t END_SPACE = 0xFFF;
-    // CHIP-8 has the following components:
-    // Memory: CHIP-8 has direct access to up to 4 kilobytes of RAM
-    static uint8_t memory[4096];
-    // Display: 64 x 32 pixels (or 128 x 64 for c8-CHIP) monochrome, ie. black or white
-    static uint32_t display[128 * 64];
-    // A program counter, often called just “PC”, which points at the current instruction in memory
-    static uint16_t pc;
-    // One 16-bit index register called “I” which is used to point at locations in memory
-    static uint16_t I;
-    // A stack for 16-bit addresses, which is used to call subroutines/functions and return from them
-    static u_int16_t stack[16]; // 16, 2 byte entries.
-                                // An 8-bit delay timer which is decremented at a rate of 60 Hz (60 times per second) until it reaches 0
-    static u_int8_t delay_timer;
-    // An 8-bit sound timer which functions like the delay timer, but which also gives off a beeping sound as long as it’s not 0
-    static u_int8_t sound_timer;
-    // 16 8-bit (one byte) general-purpose variable registers numbered 0 through F hexadecimal, ie. 0 through 15 in decimal, called V0 through VF
-    static u_int8_t registers[16];
-    // VF is also used as a flag register; many instructions will set it to either 1 or 0 based on some rule, for example using it as a carry flag
-    static char vf;
-
-    static constexpr uint8_t FONT[80] = {
+    static constexpr uint16_t FONT_END = 0x09F;
+
+    static constexpr uint16_t STORAGE_START = 0x050;
+    static constexpr uint16_t STORAGE_END = 0x0A0;
+
+    static constexpr int PAGE_SIZE = 64; // memory hashing granularity, bytes
+
+
+    uint8_t sp = 0;                // 8bit Stack pointer
+    uint8_t memory[MEM_SIZE] = {}; // Memory, RAM, array
+    uint8_t v_registers[16] = {};  // 8bit General purpose registers array, Vx
+    uint8_t delay_timer = 0;
+    uint8_t sound_timer = 0;
+    uint8_t keypad[16] = {};
+
+    uint16_t stack[REGISTER_STACK_SIZE] = {};
+    uint16_t pc = DATA_START; // Program counter
+    uint16_t index = {};      // "I", index, register stores memory address
+                              // 0000 0000 0000 0000 -> opcode, x, y, value - nibble
+    uint16_t opcode;
+
+    uint32_t video[DISPLAY_HEIGHT * DISPLAY_WIDTH] = {};
+
+    // How Frame() and Run() measure a frame. Flat: every instruction costs 1 and a frame is
+    // instructions_per_frame of them. Vip: every instruction costs what the COSMAC VIP
+    // interpreter roughly spent on it in machine cycles (VipCost, Dxyn by sprite height) and a
+    // frame ends once cycles_per_frame are spent, the overshoot carried into the next. Either
+    // way the work in a frame depends only on the program, never on the host.
+    enum class Timing : uint8_t
+    {
+        Flat,
+        Vip
+    };
+    // 1.7609 MHz / 8 clocks per machine cycle / 60 Hz = 3668 machine cycles a frame, less the
+    // 1024 the display DMA steals (32 rows of 8 bytes, each shown on 4 scan lines) and about 60
+    // for the interrupt routine
+    static constexpr int VIP_CYCLES_PER_FRAME = 3668 - 1024 - 60;
+
+    Timing timing = Timing::Flat;
+    int instructions_per_frame = INST_EXE;       // Frame length with Timing::Flat
+    int cycles_per_frame = VIP_CYCLES_PER_FRAME; // Frame length with Timing::Vip
+    int frame_cycle = 0;                         // Position inside the current frame, in
+                                                 // instructions or machine cycles, kept by Run()
+    uint64_t cycles = 0;                         // Instructions executed by Run()
+    uint64_t frames = 0;                         // Frame boundaries crossed by Run()
+    TraceRing *trace = nullptr;                  // When set, Run() records every instruction into it
+
+    // Behaviours that differ between interpreters, one bit each in quirks. Configuration like
+    // instructions_per_frame (Reset keeps them), honoured by both dispatch modes. None set is the
+    // behaviour this core always had.
+    enum Quirk : uint8_t
+    {
+        QUIRK_SHIFT = 1u << 0,     // 8xy6 / 8xyE shift Vx in place instead of Vy into Vx
+        QUIRK_LOAD_STORE = 1u << 1, // Fx55 / Fx65 leave I at I + x + 1
+        QUIRK_JUMP = 1u << 2,      // Bnnn jumps to Vx + nnn, x being the high nibble of nnn
+        QUIRK_VF_RESET = 1u << 3,  // 8xy1 / 8xy2 / 8xy3 clear VF
+        QUIRK_WRAP = 1u << 4       // sprites wrap around the edges instead of being clipped
+    };
+    uint8_t quirks = 0;
+
+    // How Cycle() and Run() find an opcode's handler
+    enum class Dispatch : uint8_t
+    {
+        Tables, // table by the high nibble, then table0/8/E/F, handlers decode their operands
+        Direct  // one 65536 entry table of handlers with their operands compiled in (dispatch_full.cpp)
+    };
+    Dispatch dispatch = Dispatch::Tables;
+    // Whether this build has the Direct handlers (make DIRECT=1). Without them Direct is the same
+    // 65536 entry table with every entry running the tables, slower but identical in behaviour.
+    static const bool direct_compiled;
+
+    // Incremental hashes, kept up to date by the only handlers that write memory (Fx33, Fx55) and
+    // video (00E0, Dxyn). Writing memory or video from outside needs a Rehash() afterwards.
+    uint64_t memory_digest = 0;                // XOR of one term per PAGE_SIZE page
+    uint64_t video_digest = 0;                 // XOR of one term per non-empty row
+    uint64_t video_rows[DISPLAY_HEIGHT] = {};  // video at 1 bit per pixel, bit 63 is x = 0
+    uint32_t dirty_pages = ~0u;                // PagedState pages written since the last Save/Restore
+    
+    static constexpr uint8_t FONT_SET[80] = {
+        // Fonts, 15 5bit characters
         0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
         0x20, 0x60, 0x20, 0x20, 0x70, // 1
         0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
@@ -53,11 +143,227 @@ public:
         0xF0, 0x80, 0xF0, 0x80, 0x80  // F
     };
 
-    static uint8_t keypad[16];
+    // Everything needed to resume a machine bit for bit. Plain data, so it can be memcpy'd,
+    // kept in arrays or written to disk by the same build. Video is stored packed (see PackVideo).
+    struct Snapshot
+    {
+        uint8_t memory[MEM_SIZE];
+        uint8_t v_registers[16];
+        uint16_t stack[REGISTER_STACK_SIZE];
+        uint16_t pc;
+        uint16_t index;
+        uint16_t opcode;
+        uint8_t sp;
+        uint8_t delay_timer;
+        uint8_t sound_timer;
+        uint8_t keypad[16];
+        uint8_t video[DISPLAY_WIDTH * DISPLAY_HEIGHT / 8];
+        std::default_random_engine rng;
+        uint64_t memory_digest; // cached so Restore doesn't hash memory again
+    };
+
+    // Why Run() returned
+    enum class StopReason : uint8_t
+    {
+        Budget,     // executed the whole budget
+        Frame,      // crossed a frame boundary (STOP_FRAME)
+        Breakpoint, // pc landed on a breakpoint, address = pc
+        Watchpoint, // Fx55/Fx33 wrote a watched byte, address = first watched byte written
+        Draw,       // Dxyn or 00E0 changed video (STOP_DRAW)
+        KeyWait     // Fx0A found no key held (STOP_KEY_WAIT), address = its pc, rerun once a key is down
+    };
+
+    enum StopOn : uint32_t
+    {
+        STOP_FRAME = 1u << 0,
+        STOP_DRAW = 1u << 1,
+        STOP_KEY_WAIT = 1u << 2
+    };
+
+    struct RunResult
+    {
+        StopReason reason;
+        uint16_t address;
+        uint64_t executed;
+    };
+
+    chip8();                     // seeded from the clock
+    explicit chip8(uint32_t seed); // reproducible runs
+    ~chip8();
+
+    // Prints pc, opcode and its disassembly
+    void rop();
+
+    // Back to power-on state (font loaded, pc = DATA_START), ROM must be loaded again.
+    void Reset(uint32_t seed);
+
+    // Fetch, Decode, Execute
+    void Cycle();
+    // Runs up to budget instructions without returning to the host, stopping early on the events
+    // in stop_on, on breakpoints, or on watchpoints. Breakpoints are tested after each instruction,
+    // so resuming from one always makes progress. Each combination of enabled checks (and tracing)
+    // is its own loop, so checks that aren't enabled cost nothing.
+    RunResult Run(uint64_t budget, uint32_t stop_on = 0);
+    // Runs to the next frame boundary, ignoring breakpoints and watchpoints
+    void Frame();
+
+    // One bit per address, so the hot loop test is a shift and a mask.
+    void SetBreakpoint(uint16_t address, bool enabled = true);
+    void SetWatchpoint(uint16_t start, uint16_t length, bool enabled = true);
+    void ClearBreakpoints();
+    void ClearWatchpoints();
+    // Read ROMs, returns bytes loaded or 0 if the file can't be read or doesn't fit.
+    size_t LoadROM(char const *filename);
+    size_t LoadROM(uint8_t const *data, size_t size);
+    // Pack video to 1 bit per pixel, MSB first, DISPLAY_WIDTH / 8 bytes per row (256 bytes total)
+    void PackVideo(uint8_t *out) const;
+
+    void Save(Snapshot &out) const;
+    void Restore(Snapshot const &in);
+    // Copy-on-write variants, see PagedState. Save shares every page of out the machine hasn't
+    // written since it was restored, so out must be empty or a copy (fork) of that state.
+    // Restore copies all of memory, or with loaded (the state the machine was last restored
+    // from or saved to, still alive) only the pages that differ from it or were written since.
+    void Save(PagedState &out);
+    void Restore(PagedState const &in, PagedState const *loaded = nullptr);
+    // 64-bit digest of memory, V registers, stack, sp, pc, I and timers, the state a search
+    // deduplicates on. Video, keypad and the random engine are not included. O(1), memory comes
+    // from memory_digest.
+    uint64_t Hash() const;
+    // Hash() combined with video_digest, the whole visible machine state in 64 bits. O(1).
+    uint64_t Digest() const;
+    // The random engine, part of a state's future that Hash() and Digest() leave out
+    std::default_random_engine const &Random() const
+    {
+        return rng;
+    }
+    // Recomputes memory_digest, video_rows and video_digest from memory and video.
+    void Rehash();
+
+    // OPCODES
+    void OP_00E0();
+    void OP_00EE();
+    void OP_1nnn();
+    void OP_2nnn();
+    void OP_3xkk();
+    void OP_4xkk();
+    void OP_5xy0();
+    void OP_6xkk();
+    void OP_7xkk();
+    void OP_8xy0();
+    void OP_8xy1();
+    void OP_8xy2();
+    void OP_8xy3();
+    void OP_8xy4();
+    void OP_8xy5();
+    void OP_8xy6();
+    void OP_8xy7();
+    void OP_8xyE();
+    void OP_9xy0();
+    void OP_Annn();
+    void OP_Bnnn();
+    void OP_Cxkk();
+    void OP_Dxyn();
+    void OP_Ex9E();
+    void OP_ExA1();
+    void OP_Fx07();
+    void OP_Fx0A();
+    void OP_Fx15();
+    void OP_Fx18();
+    void OP_Fx1E();
+    void OP_Fx29();
+    void OP_Fx33();
+    void OP_Fx55();
+    void OP_Fx65();
+    void OP_NULL();
+
+    // Dxyn with its operands decoded, shared by OP_Dxyn and the direct handlers
+    void Sprite(uint8_t x, uint8_t y, uint8_t height);
+
+    // Breakpoint / watchpoint bitmaps and how many bits are set in each
+    uint64_t breakpoints[MEM_SIZE / 64] = {};
+    uint64_t watchpoints[MEM_SIZE / 64] = {};
+    uint32_t breakpoint_count = 0;
+    uint32_t watchpoint_count = 0;
+
+    static bool Test(uint64_t const *bits, uint16_t address)
+    {
+        return (bits[(address & MEM_END) >> 6] >> (address & 63u)) & 1u;
+    }
+    static void Assign(uint64_t *bits, uint32_t &count, uint16_t address, bool enabled);
+
+    static uint64_t PageTerm(size_t page, uint8_t const *bytes);
+    // Copies size bytes to address (wrapping), updating memory_digest and dirty_pages for just the
+    // pages written
+    void Store(uint16_t address, uint8_t const *data, size_t size);
+    static uint64_t RowTerm(size_t row, uint64_t bits);
+    // XORs the terms of the pages holding first and last (one page if they share it) into
+    // memory_digest. Called before a store to take the old contents out and after to add the new.
+    // Also marks the PagedState pages holding them dirty.
+    void FlipPages(uint16_t first, uint16_t last);
+
+    // Fetch, execute and tick the timers, the body of Cycle() and of every Run() loop
+    template <bool DIRECT>
+    void Step();
+
+    template <bool BREAK, bool WATCH, bool DRAW, bool FRAME, bool TRACE, bool DIRECT, bool KEY, bool VIP>
+    RunResult RunLoop(uint64_t budget);
+    // Machine cycles of the opcode just executed from at (pc is already past it), Timing::Vip
+    int VipCost(uint16_t at) const;
+
+    // TABLES
+    typedef void (chip8::*chip8Func)();
+    // Sized to the full range of the index, unused entries are OP_NULL. Shared by every instance
+    // and built at compile time, so constructing a chip8 doesn't touch them.
+    static const std::array<chip8Func, 0x10> table; // Master table
+    static const std::array<chip8Func, 0x10> table0;
+    static const std::array<chip8Func, 0x10> table8;
+    static const std::array<chip8Func, 0x10> tableE;
+    static const std::array<chip8Func, 0x100> tableF;
+
+    // table0 / tableE are indexed by the low nibble only, the rest of the opcode must match too
+    // (0x0000 is not CLS, E0x1 is not SKNP).
+    void Table0()
+    {
+        if ((opcode & 0x0FF0u) != 0x00E0u)
+        {
+            OP_NULL();
+            return;
+        }
+        ((*this).*(table0[opcode & 0x000Fu]))();
+    }
+
+    void TableE()
+    {
+        if ((opcode & 0x00FFu) != 0x009Eu && (opcode & 0x00FFu) != 0x00A1u)
+        {
+            OP_NULL();
+            return;
+        }
+        ((*this).*(tableE[opcode & 0x000Fu]))();
+    }
+
+    void Table8()
+    {
+        ((*this).*(table8[opcode & 0x000Fu]))();
+    }
+
+    void TableF()
+    {
+        ((*this).*(tableF[opcode & 0x00FFu]))();
+    }
+
+    // Does nothing, dummy function for bad calls
+    void TableNULL();
 
-    chip8_tobias();
-    ~chip8_tobias();
+    // Dispatch::Direct, indexed by the whole opcode. Plain function pointers (half the size of
+    // member pointers) to Direct<OP>, every invalid opcode shares DirectNULL. 512 KB, so it only
+    // pays off when the opcodes a ROM uses stay cached, see tools/c8dispatch.cpp.
+    typedef void (*DirectFunc)(chip8 &);
+    static const std::array<DirectFunc, 0x10000> direct;
 
-    void fetch();
-    void decode();
-};
\ No newline at end of file
+    template <uint16_t OP>
+    static void Direct(chip8 &c);
+    static void DirectNULL(chip8 &c);
+    static void DirectTables(chip8 &c);
+};
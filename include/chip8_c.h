@@ -0,0 +1,97 @@
+#pragma once
+
+// Stable C ABI over the chip8 core for hosts that embed many machines in one process.
+// The host owns all memory: query chip8_vm_size / chip8_vm_align, hand a block to
+// chip8_create, and release it yourself after chip8_destroy. Nothing here allocates.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_WIN32)
+#define CHIP8_API __declspec(dllexport)
+#else
+#define CHIP8_API __attribute__((visibility("default")))
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    typedef struct chip8_vm chip8_vm;
+
+    enum
+    {
+        CHIP8_WIDTH = 64,
+        CHIP8_HEIGHT = 32,
+        CHIP8_PACKED_SIZE = CHIP8_WIDTH * CHIP8_HEIGHT / 8
+    };
+
+    // chip8_run stop reasons and stop_on flags, same values as chip8::StopReason / chip8::StopOn
+    enum
+    {
+        CHIP8_STOP_BUDGET = 0,
+        CHIP8_STOP_FRAME = 1,
+        CHIP8_STOP_BREAKPOINT = 2,
+        CHIP8_STOP_WATCHPOINT = 3,
+        CHIP8_STOP_DRAW = 4,
+        CHIP8_STOP_KEY_WAIT = 5
+    };
+    enum
+    {
+        CHIP8_ON_FRAME = 1u << 0,
+        CHIP8_ON_DRAW = 1u << 1,
+        CHIP8_ON_KEY_WAIT = 1u << 2
+    };
+    // chip8_set_timing modes, same values as chip8::Timing
+    enum
+    {
+        CHIP8_TIMING_FLAT = 0,
+        CHIP8_TIMING_VIP = 1
+    };
+
+    CHIP8_API size_t chip8_vm_size(void);
+    CHIP8_API size_t chip8_vm_align(void);
+
+    // Constructs a machine in mem, NULL if mem is too small or misaligned.
+    CHIP8_API chip8_vm *chip8_create(void *mem, size_t size, uint32_t seed);
+    // Runs the destructor, mem is still the caller's to free.
+    CHIP8_API void chip8_destroy(chip8_vm *vm);
+
+    CHIP8_API void chip8_reset(chip8_vm *vm, uint32_t seed);
+    // 0 on success, -1 if the ROM doesn't fit above 0x200.
+    CHIP8_API int chip8_load(chip8_vm *vm, uint8_t const *rom, size_t size);
+
+    CHIP8_API void chip8_step(chip8_vm *vm, uint32_t instructions);
+    CHIP8_API void chip8_step_frame(chip8_vm *vm);
+    // At least 1, smaller values are clamped.
+    CHIP8_API void chip8_set_instructions_per_frame(chip8_vm *vm, int instructions);
+    // CHIP8_TIMING_FLAT: frames are instructions_per_frame instructions. CHIP8_TIMING_VIP: frames
+    // are cycles_per_frame COSMAC VIP machine cycles (<= 0 keeps the current budget).
+    CHIP8_API void chip8_set_timing(chip8_vm *vm, int timing, int cycles_per_frame);
+
+    // Runs up to budget instructions, returns a CHIP8_STOP_* reason. executed and address
+    // (breakpoint pc / watched byte) may be NULL.
+    CHIP8_API int chip8_run(chip8_vm *vm, uint64_t budget, uint32_t stop_on, uint64_t *executed, uint16_t *address);
+    CHIP8_API void chip8_set_breakpoint(chip8_vm *vm, uint16_t address, int enabled);
+    CHIP8_API void chip8_set_watchpoint(chip8_vm *vm, uint16_t start, uint16_t length, int enabled);
+
+    // key 0x0-0xF
+    CHIP8_API void chip8_set_key(chip8_vm *vm, int key, int pressed);
+
+    // Snapshots are opaque, fixed size, and only valid for the library build that wrote them.
+    // Buffers must be at least pointer aligned.
+    CHIP8_API size_t chip8_snapshot_size(void);
+    CHIP8_API void chip8_snapshot(chip8_vm const *vm, void *out);
+    CHIP8_API void chip8_restore(chip8_vm *vm, void const *in);
+    // 64-bit digest of memory, registers, timers and video, kept incrementally so it's O(1).
+    CHIP8_API uint64_t chip8_digest(chip8_vm const *vm);
+
+    // CHIP8_WIDTH * CHIP8_HEIGHT RGBA8888 pixels, valid for the lifetime of vm.
+    CHIP8_API uint32_t const *chip8_framebuffer(chip8_vm const *vm);
+    // CHIP8_PACKED_SIZE bytes, 1 bit per pixel, MSB first.
+    CHIP8_API void chip8_framebuffer_packed(chip8_vm const *vm, uint8_t *out);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Table driven CHIP-8 disassembly, one row per chip8 OP_* handler.
+class Disassembler
+{
+public:
+    // Writes e.g. "ADD V3, V4" into out (always terminated), unknown opcodes become "DW 0x1234".
+    static void Format(uint16_t opcode, char *out, size_t size);
+
+    // Name of the handler chip8 dispatches the opcode to ("OP_8xy4"), "OP_NULL" if none.
+    static char const *Handler(uint16_t opcode);
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class Arena;
+class chip8;
+
+// Vectorized environment for training loops in another process. The server owns N machines and a
+// POSIX shared memory region; the client writes one action per machine into the region and sends
+// a step over a Unix socket, the server advances every machine in parallel and writes frames,
+// rewards and done flags straight into the region before replying. Nothing but the command and
+// reply bytes crosses the socket and no observation is copied on its way to the client.
+//
+// Region layout (EnvLayout), every array 64 byte aligned:
+//   header     magic "C8EV", version, instances, frame size, steps completed
+//   actions    uint16_t per machine, bit k = key k held for the whole step (client writes)
+//   frames     256 bytes per machine, video packed 1bpp as chip8::PackVideo
+//   rewards    float per machine, change of the byte at reward_address over the step
+//   dones      uint8_t per machine, set when the episode ended during the step; the machine is
+//              reset (new seed, ROM reloaded) at the start of its next step
+struct EnvLayout
+{
+    static constexpr uint32_t MAGIC = 0x56453843; // "C8EV" little endian
+    static constexpr uint32_t VERSION = 1;
+    static constexpr size_t FRAME_BYTES = 256;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t instances;
+        uint32_t frame_bytes;
+        uint64_t steps;
+    };
+
+    static size_t Align(size_t offset)
+    {
+        return (offset + 63) & ~size_t{63};
+    }
+
+    static size_t Actions(size_t)
+    {
+        return Align(sizeof(Header));
+    }
+
+    static size_t Frames(size_t instances)
+    {
+        return Align(Actions(instances) + instances * sizeof(uint16_t));
+    }
+
+    static size_t Rewards(size_t instances)
+    {
+        return Align(Frames(instances) + instances * FRAME_BYTES);
+    }
+
+    static size_t Dones(size_t instances)
+    {
+        return Align(Rewards(instances) + instances * sizeof(float));
+    }
+
+    static size_t Size(size_t instances)
+    {
+        return Align(Dones(instances) + instances);
+    }
+};
+
+// Control protocol, one byte each way: the client sends a command, the server answers REPLY once
+// the region is up to date (or ERROR for anything it doesn't understand).
+enum EnvCommand : uint8_t
+{
+    ENV_STEP = 'S',     // apply actions, run frames_per_step frames on every machine
+    ENV_RESET = 'R',    // reset every machine and clear rewards / dones, frames show power-on
+    ENV_SHUTDOWN = 'X', // server stops serving and Serve() returns
+    ENV_REPLY = 'K',
+    ENV_ERROR = 'E'
+};
+
+class EnvServer
+{
+public:
+    struct Options
+    {
+        size_t instances = 64;
+        int workers = 0;                // 0 = one per allowed CPU, never more than instances
+        bool pin = true;
+        int frames_per_step = 1;
+        int instructions_per_frame = 16;
+        int reward_address = -1;        // byte whose change over a step is the reward, < 0 = always 0
+        int done_address = -1;          // episode ends when this byte is non-zero, < 0 = never
+        uint32_t max_frames = 0;        // episode ends after this many frames, 0 = no limit
+        uint32_t seed = 1;
+    };
+
+    EnvServer();
+    ~EnvServer();
+
+    EnvServer(EnvServer const &) = delete;
+    EnvServer &operator=(EnvServer const &) = delete;
+
+    // Creates the shared region shm_name (e.g. "/c8env", replaced if it exists), the machines and
+    // the workers, and listens on socket_path. rom is copied.
+    bool Open(char const *socket_path, char const *shm_name, uint8_t const *rom, size_t size, Options const &options);
+    // Serves clients one at a time until one sends ENV_SHUTDOWN
+    void Serve();
+    // Workers stop, the socket and region are removed
+    void Close();
+
+    // The in-process equivalents of ENV_STEP / ENV_RESET
+    void Step();
+    void Reset();
+
+    uint8_t *Region() const
+    {
+        return region;
+    }
+
+private:
+    // One machine's episode bookkeeping, next to it in its worker's arena
+    struct Slot
+    {
+        chip8 *machine;
+        uint32_t episode;
+        uint32_t frames;
+        uint8_t score;
+        bool reset;
+    };
+
+    struct Worker
+    {
+        std::thread thread;
+        std::unique_ptr<Arena> arena;
+        size_t first = 0;
+        size_t count = 0;
+        Slot *slots = nullptr;
+    };
+
+    void Work(size_t w, int cpu);
+    void Run(size_t w, uint8_t command);
+    void StepOne(size_t instance, Slot &slot);
+    void ResetOne(size_t instance, Slot &slot);
+    void Dispatch(uint8_t command);
+
+    Options options;
+    std::vector<uint8_t> rom;
+    std::vector<Worker> workers;
+
+    // Commands reach the workers through generation: bumped once per command, workers spin on it
+    // briefly before sleeping on wake, the last one to finish a command notifies done.
+    std::atomic<uint64_t> generation{0};
+    std::atomic<uint8_t> command{0};
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> failed{false};
+    bool stop = false;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+
+    uint8_t *region = nullptr;
+    size_t region_size = 0;
+    char shm_name[64] = {};
+    char socket_path[108] = {};
+    int listener = -1;
+};
+
+class EnvClient
+{
+public:
+    EnvClient() = default;
+    ~EnvClient();
+
+    EnvClient(EnvClient const &) = delete;
+    EnvClient &operator=(EnvClient const &) = delete;
+
+    bool Connect(char const *socket_path, char const *shm_name);
+    void Disconnect();
+
+    size_t Instances() const
+    {
+        return header ? header->instances : 0;
+    }
+
+    // Views straight into the shared region
+    uint16_t *Actions() const
+    {
+        return actions;
+    }
+
+    uint8_t const *Frame(size_t instance) const
+    {
+        return frames + instance * EnvLayout::FRAME_BYTES;
+    }
+
+    float const *Rewards() const
+    {
+        return rewards;
+    }
+
+    uint8_t const *Dones() const
+    {
+        return dones;
+    }
+
+    // Block until the server replied, false if it failed or went away
+    bool Step();
+    bool Reset();
+    bool Shutdown();
+
+private:
+    bool Send(uint8_t command);
+
+    int socket_fd = -1;
+    uint8_t *region = nullptr;
+    size_t region_size = 0;
+    EnvLayout::Header const *header = nullptr;
+    uint16_t *actions = nullptr;
+    uint8_t const *frames = nullptr;
+    float const *rewards = nullptr;
+    uint8_t const *dones = nullptr;
+};
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "chip8.h"
+
+// Differential execution: two machines that should behave identically (two execution backends,
+// or two configurations) are stepped one instruction at a time with the same inputs, and the
+// first instruction after which their state differs is reported.
+class Lockstep
+{
+public:
+    struct Divergence
+    {
+        bool found;
+        uint64_t step;       // instructions executed when the difference showed up
+        uint16_t pc;         // where the offending instruction was fetched from
+        uint16_t opcode;     // and what it was
+        char const *field;   // first differing part of the state, e.g. "V3", "memory", "video"
+        uint16_t address;    // for memory / video / stack differences
+    };
+
+    // Ways of executing one instruction that must all agree with chip8::Cycle. All but Direct
+    // dispatch through the nibble tables.
+    enum class Backend
+    {
+        Cycle,   // chip8::Cycle
+        Run,     // chip8::Run(1) through the loop with every check enabled
+        Restore, // Cycle, then Save / Reset / Restore the whole machine
+        Direct,  // chip8::Cycle through Dispatch::Direct
+    };
+
+    static char const *Name(Backend backend)
+    {
+        switch (backend)
+        {
+            case Backend::Cycle: return "cycle";
+            case Backend::Run: return "run";
+            case Backend::Restore: return "restore";
+            case Backend::Direct: return "direct";
+        }
+        return "?";
+    }
+
+    // false if the name isn't a backend, otherwise writes it to out.
+    static bool Parse(char const *name, Backend &out)
+    {
+        for (Backend b : {Backend::Cycle, Backend::Run, Backend::Restore, Backend::Direct})
+        {
+            if (strcmp(name, Name(b)) == 0)
+            {
+                out = b;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static void Step(Backend backend, chip8 &c)
+    {
+        c.dispatch = backend == Backend::Direct ? chip8::Dispatch::Direct : chip8::Dispatch::Tables;
+        switch (backend)
+        {
+            case Backend::Cycle:
+            case Backend::Direct:
+                c.Cycle();
+                break;
+            case Backend::Run:
+                c.Run(1, chip8::STOP_DRAW | chip8::STOP_FRAME);
+                break;
+            case Backend::Restore:
+            {
+                static chip8::Snapshot snapshot;
+                c.Cycle();
+                c.Save(snapshot);
+                c.Reset(0);
+                c.Restore(snapshot);
+                break;
+            }
+        }
+    }
+
+    // nullptr when the architectural state and the digests kept over it match, else the first
+    // differing field. The digests are compared last, so "digest" means state that agrees under
+    // a hash that doesn't.
+    static char const *Compare(chip8 const &a, chip8 const &b, uint16_t &address)
+    {
+        static char const *const REGISTERS[16] = {"V0", "V1", "V2", "V3", "V4", "V5", "V6", "V7",
+                                                  "V8", "V9", "VA", "VB", "VC", "VD", "VE", "VF"};
+        address = 0;
+        if (a.pc != b.pc)
+            return "pc";
+        if (a.index != b.index)
+            return "I";
+        if (a.sp != b.sp)
+            return "sp";
+        if (a.opcode != b.opcode)
+            return "opcode";
+        for (int i = 0; i < 16; ++i)
+        {
+            if (a.v_registers[i] != b.v_registers[i])
+                return REGISTERS[i];
+        }
+        if (a.delay_timer != b.delay_timer)
+            return "delay_timer";
+        if (a.sound_timer != b.sound_timer)
+            return "sound_timer";
+        for (int i = 0; i < chip8::REGISTER_STACK_SIZE; ++i)
+        {
+            if (a.stack[i] != b.stack[i])
+            {
+                address = i;
+                return "stack";
+            }
+        }
+        // memcmp first, it runs every step; the loops only look for the address
+        if (memcmp(a.memory, b.memory, sizeof(a.memory)) != 0)
+        {
+            for (int i = 0; i < chip8::MEM_SIZE; ++i)
+            {
+                if (a.memory[i] != b.memory[i])
+                {
+                    address = i;
+                    return "memory";
+                }
+            }
+        }
+        if (memcmp(a.video, b.video, sizeof(a.video)) != 0)
+        {
+            for (int i = 0; i < chip8::DISPLAY_WIDTH * chip8::DISPLAY_HEIGHT; ++i)
+            {
+                if (a.video[i] != b.video[i])
+                {
+                    address = i;
+                    return "video";
+                }
+            }
+        }
+        if (a.Digest() != b.Digest() || a.memory_digest != b.memory_digest)
+            return "digest";
+        return nullptr;
+    }
+
+    // input(step, machine) sets up the keypad before each instruction; it is applied to a and
+    // copied to b so both always see identical input.
+    template <typename StepA, typename StepB, typename Input>
+    static Divergence Run(chip8 &a, chip8 &b, uint64_t steps, StepA &&step_a, StepB &&step_b, Input &&input)
+    {
+        Divergence result{};
+        uint16_t address = 0;
+        if (char const *field = Compare(a, b, address))
+        {
+            result = {true, 0, a.pc, 0, field, address};
+            return result;
+        }
+
+        for (uint64_t step = 0; step < steps; ++step)
+        {
+            input(step, a);
+            memcpy(b.keypad, a.keypad, sizeof(a.keypad));
+
+            uint16_t pc = a.pc;
+            uint16_t opcode = (a.memory[pc & chip8::MEM_END] << 8u) | a.memory[(pc + 1) & chip8::MEM_END];
+            step_a(a);
+            step_b(b);
+
+            // Every step: the digests don't cover everything, and a backend can leave them stale
+            if (char const *field = Compare(a, b, address))
+            {
+                result = {true, step + 1, pc, opcode, field, address};
+                return result;
+            }
+        }
+        return result;
+    }
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <vector>
+
+// CPU / NUMA node layout and thread pinning, read from sysfs and the affinity syscalls on Linux
+// so there's no libnuma dependency. Elsewhere every CPU is reported on node 0 and pinning is a
+// no-op that returns false.
+class Topology
+{
+public:
+    // CPUs this process may run on (respects taskset / cgroup limits), ascending
+    static std::vector<int> Cpus();
+    // Online node IDs, ascending. Not always 0..N-1 (offline or hot-plugged nodes), {0} when unknown
+    static std::vector<int> NodeIds();
+    // Node count, at least 1
+    static int Nodes();
+    // ID of the node owning cpu, 0 when unknown
+    static int NodeOf(int cpu);
+    // Pins the calling thread to cpu
+    static bool Pin(int cpu);
+
+    // Kernel cpulist / nodelist format, "0-3,8,10-11", to ascending IDs. Stops at anything else.
+    static std::vector<int> ParseList(char const *text);
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+
+#include "chip8.h"
+
+// Copy-on-write machine state for forking large populations (search frontiers, fuzzing corpora).
+// Registers and the packed screen are inline, memory is PAGES reference counted pages of
+// PAGE_SIZE bytes. Copying a PagedState is a fork: it shares every page and costs PAGES pointer
+// copies instead of a 4 KB memcpy. chip8 keeps running on its own flat memory and marks the
+// pages Fx33/Fx55 store to (chip8::dirty_pages); saving into a fork only copies those pages.
+//
+//     PagedState child = parent;      // fork
+//     machine.Restore(parent);
+//     ...run...
+//     machine.Save(child);            // replaces just the pages the machine wrote
+//
+// Pages are immutable once shared, so forks can be read and copied from any thread.
+class PagedState
+{
+public:
+    static constexpr int PAGE_SIZE = 256;
+    static constexpr int PAGES = chip8::MEM_SIZE / PAGE_SIZE;
+
+    struct Page
+    {
+        std::atomic<uint32_t> refs{1};
+        uint8_t bytes[PAGE_SIZE];
+    };
+
+    PagedState() = default;
+    PagedState(PagedState const &other);
+    PagedState(PagedState &&other) noexcept;
+    PagedState &operator=(PagedState const &other);
+    PagedState &operator=(PagedState &&other) noexcept;
+    ~PagedState();
+
+    uint8_t Read(uint16_t address) const
+    {
+        address &= chip8::MEM_END;
+        return pages[address / PAGE_SIZE] ? pages[address / PAGE_SIZE]->bytes[address % PAGE_SIZE] : 0;
+    }
+    // True when both states point at the same copy of page
+    bool Shares(PagedState const &other, int page) const
+    {
+        return pages[page] == other.pages[page];
+    }
+    // Replaces page with a private copy of bytes, dropping this state's reference to the old one
+    void Assign(int page, uint8_t const *bytes);
+
+    Page *pages[PAGES] = {};
+
+    uint8_t v_registers[16] = {};
+    uint16_t stack[chip8::REGISTER_STACK_SIZE] = {};
+    uint16_t pc = chip8::DATA_START;
+    uint16_t index = 0;
+    uint16_t opcode = 0;
+    uint8_t sp = 0;
+    uint8_t delay_timer = 0;
+    uint8_t sound_timer = 0;
+    uint8_t keypad[16] = {};
+    uint64_t video_rows[chip8::DISPLAY_HEIGHT] = {}; // same layout as chip8::video_rows
+    uint64_t memory_digest = 0;
+    uint64_t video_digest = 0;
+    std::default_random_engine rng;
+
+private:
+    static void Release(Page *page);
+    void Share(PagedState const &other);
+    void CopyRegisters(PagedState const &other);
+};
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Present time flicker reduction. XOR sprites are erased and redrawn, so any single sample of
+// video can catch a sprite mid-erase; combining the last few presented samples hides that.
+// Average: each of the last depth frames contributes 1/depth of full brightness.
+// Decay: a pixel shows the brightness of the most recent frame it was lit in, fading with age.
+// Everything is allocated up front, Apply only touches the ring and the output buffer. The inner
+// loops are plain byte loops over restrict pointers so -O3 -march=native vectorizes them
+// (SSE/AVX on x86, NEON on arm64).
+class Phosphor
+{
+public:
+	enum class Mode
+	{
+		Average,
+		Decay
+	};
+
+	Phosphor(int width, int height, int depth, Mode mode = Mode::Decay)
+		: pixels(width * height), frames(std::max(1, std::min(depth, MAX_DEPTH))), blend(mode)
+	{
+		history = new uint8_t[pixels * frames]();
+		intensity = new uint8_t[pixels];
+		out = new uint32_t[pixels];
+
+		for (int age = 0; age < frames; ++age)
+		{
+			levels[age] = (blend == Mode::Average)
+				? static_cast<uint8_t>(255 / frames)
+				: static_cast<uint8_t>(255 - (255 * age) / frames);
+		}
+	}
+
+	~Phosphor()
+	{
+		delete[] out;
+		delete[] intensity;
+		delete[] history;
+	}
+
+	Phosphor(Phosphor const&) = delete;
+	Phosphor& operator=(Phosphor const&) = delete;
+
+	// Records video (32bit, lit = non-zero) as the newest frame and returns the blended RGBA8888
+	// buffer, valid until the next call. Same width/pitch as the input.
+	uint32_t const* Apply(uint32_t const* video)
+	{
+		head = (head + 1) % frames;
+		Capture(video, history + head * pixels);
+
+		memset(intensity, 0, pixels);
+		for (int age = 0; age < frames; ++age)
+		{
+			uint8_t const* plane = history + ((head - age + frames) % frames) * pixels;
+			if (blend == Mode::Average)
+			{
+				Accumulate(plane, levels[age]);
+			}
+			else
+			{
+				Latest(plane, levels[age]);
+			}
+		}
+
+		Expand();
+		return out;
+	}
+
+private:
+	static constexpr int MAX_DEPTH = 16;
+
+	// 0x00 / 0xFF mask per pixel
+	void Capture(uint32_t const* __restrict video, uint8_t* __restrict plane)
+	{
+		for (int i = 0; i < pixels; ++i)
+		{
+			plane[i] = video[i] ? 0xFF : 0x00;
+		}
+	}
+
+	void Accumulate(uint8_t const* __restrict plane, uint8_t level)
+	{
+		uint8_t* __restrict acc = intensity;
+		for (int i = 0; i < pixels; ++i)
+		{
+			acc[i] += plane[i] & level;
+		}
+	}
+
+	void Latest(uint8_t const* __restrict plane, uint8_t level)
+	{
+		uint8_t* __restrict acc = intensity;
+		for (int i = 0; i < pixels; ++i)
+		{
+			acc[i] = std::max<uint8_t>(acc[i], plane[i] & level);
+		}
+	}
+
+	// Grey RGBA8888, opaque when lit so full brightness matches the 0xFFFFFFFF chip8 writes and
+	// dark stays 0 (frontends like Terminal treat any non-zero pixel as lit).
+	void Expand()
+	{
+		uint8_t const* __restrict acc = intensity;
+		uint32_t* __restrict dst = out;
+		for (int i = 0; i < pixels; ++i)
+		{
+			dst[i] = acc[i] * 0x01010100u | (acc[i] ? 0xFFu : 0x00u);
+		}
+	}
+
+	int pixels;
+	int frames;
+	Mode blend;
+	int head = 0;
+	uint8_t levels[MAX_DEPTH]{};
+
+	uint8_t* history{}; // frames planes of pixels bytes, ring indexed by head
+	uint8_t* intensity{};
+	uint32_t* out{};
+};
@@ -1,21 +1,99 @@
+#include <algorithm>
+#include <cstdint>
+
 #include "SDL.h"
+
+// How Update reaches the screen.
+// RGBA: the caller's 32bit framebuffer is uploaded every frame and stretched by SDL_RenderCopy.
+// Indexed: the caller hands over a packed 1bpp plane (256 bytes for 64x32). Palette lookup is baked
+// into a small static atlas texture, one RenderCopy per lit byte draws into a native resolution
+// render target, and that target is integer scaled to the window. Persistence (0-255) keeps that
+// fraction of the previous frame for a phosphor afterglow. Only uses render targets and blend
+// modes, so it runs on SDL's software renderer too.
+enum class PresentMode
+{
+	RGBA,
+	Indexed
+};
+
 class Platform
 {
 public:
-	Platform(char const* title, int windowWidth, int windowHeight, int textureWidth, int textureHeight)
+	// Only records the configuration, SDL is brought up by Open() (or lazily by the first
+	// Update / ProcessInput), so a caller can load the ROM while it happens and headless runs
+	// never touch SDL at all.
+	Platform(char const* title, int windowWidth, int windowHeight, int textureWidth, int textureHeight,
+		PresentMode presentMode = PresentMode::RGBA, uint8_t persistence = 0)
+		: mode(presentMode), persist(persistence), width(textureWidth), height(textureHeight),
+		  title(title), windowWidth(windowWidth), windowHeight(windowHeight)
+	{
+	}
+
+	// SDL init, window, renderer and textures. Must run on the main thread (macOS requires it).
+	void Open()
 	{
+		if (window)
+		{
+			return;
+		}
+
 		SDL_Init(SDL_INIT_VIDEO);
 
 		window = SDL_CreateWindow(title, 0, 0, windowWidth, windowHeight, SDL_WINDOW_SHOWN);
 
-		renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+		if (mode == PresentMode::RGBA)
+		{
+			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+
+			texture = SDL_CreateTexture(
+				renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, width, height);
+			return;
+		}
+
+		// Nearest filtering for the upscale, then fall back to software if there's no GPU.
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+		renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE);
+		if (!renderer)
+		{
+			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE | SDL_RENDERER_TARGETTEXTURE);
+		}
+
+		atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STATIC, 8, 256);
+		FillAtlas();
+		SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
 
 		texture = SDL_CreateTexture(
-			renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, textureWidth, textureHeight);
+			renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, width, height);
+
+		// Start from a cleared target, persistence blends against it from then on.
+		SDL_SetRenderTarget(renderer, texture);
+		SDL_SetRenderDrawColor(renderer, Red(background), Green(background), Blue(background), 255);
+		SDL_RenderClear(renderer);
+		SDL_SetRenderTarget(renderer, nullptr);
+	}
+
+	// PresentMode::Indexed only, lit and unlit colours as 0xRRGGBB (default white on black). Can
+	// be changed after Open, the atlas is rebuilt.
+	void SetPalette(uint32_t lit, uint32_t unlit)
+	{
+		foreground = lit << 8 | 0xFF;
+		background = unlit;
+		if (atlas)
+		{
+			FillAtlas();
+		}
 	}
 
 	~Platform()
 	{
+		if (!window)
+		{
+			return;
+		}
+		if (atlas)
+		{
+			SDL_DestroyTexture(atlas);
+		}
 		SDL_DestroyTexture(texture);
 		SDL_DestroyRenderer(renderer);
 		SDL_DestroyWindow(window);
@@ -24,14 +102,59 @@ public:
 
 	void Update(void const* buffer, int pitch)
 	{
+		Open();
 		SDL_UpdateTexture(texture, nullptr, buffer, pitch);
 		SDL_RenderClear(renderer);
 		SDL_RenderCopy(renderer, texture, nullptr, nullptr);
 		SDL_RenderPresent(renderer);
 	}
 
+	// PresentMode::Indexed only. bits is textureHeight rows of textureWidth / 8 bytes, MSB first.
+	void UpdateIndexed(uint8_t const* bits)
+	{
+		Open();
+		int stride = width / 8;
+
+		SDL_SetRenderTarget(renderer, texture);
+
+		// Fade (or with no persistence, clear) what's left of the previous frame.
+		SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_BLEND);
+		SDL_SetRenderDrawColor(renderer, Red(background), Green(background), Blue(background), 255 - persist);
+		SDL_RenderFillRect(renderer, nullptr);
+
+		for (int y = 0; y < height; ++y)
+		{
+			for (int bx = 0; bx < stride; ++bx)
+			{
+				uint8_t b = bits[y * stride + bx];
+				if (!b)
+				{
+					continue;
+				}
+				SDL_Rect src{0, b, 8, 1};
+				SDL_Rect dst{bx * 8, y, 8, 1};
+				SDL_RenderCopy(renderer, atlas, &src, &dst);
+			}
+		}
+
+		SDL_SetRenderTarget(renderer, nullptr);
+
+		// Largest integer multiple that fits, centered.
+		int outW = 0;
+		int outH = 0;
+		SDL_GetRendererOutputSize(renderer, &outW, &outH);
+		int scale = std::max(1, std::min(outW / width, outH / height));
+		SDL_Rect dst{(outW - width * scale) / 2, (outH - height * scale) / 2, width * scale, height * scale};
+
+		SDL_SetRenderDrawColor(renderer, Red(background), Green(background), Blue(background), 255);
+		SDL_RenderClear(renderer);
+		SDL_RenderCopy(renderer, texture, nullptr, &dst);
+		SDL_RenderPresent(renderer);
+	}
+
 	bool ProcessInput(uint8_t* keys)
 	{
+		Open();
 		bool quit = false;
 
 		SDL_Event event;
@@ -228,7 +351,37 @@ public:
 	}
 
 private:
+	// Row b of the atlas is the 8 pixels of byte value b, lit pixels opaque fg, unlit transparent.
+	void FillAtlas()
+	{
+		uint32_t atlasPixels[256 * 8];
+		for (int b = 0; b < 256; ++b)
+		{
+			for (int bit = 0; bit < 8; ++bit)
+			{
+				atlasPixels[b * 8 + bit] = (b & (0x80 >> bit)) ? foreground : 0x00000000;
+			}
+		}
+		SDL_UpdateTexture(atlas, nullptr, atlasPixels, 8 * sizeof(uint32_t));
+	}
+
+	static uint8_t Red(uint32_t rgb) { return (rgb >> 16) & 0xFF; }
+	static uint8_t Green(uint32_t rgb) { return (rgb >> 8) & 0xFF; }
+	static uint8_t Blue(uint32_t rgb) { return rgb & 0xFF; }
+
+	uint32_t foreground = 0xFFFFFFFF; // RGBA8888
+	uint32_t background = 0x000000;   // 0xRRGGBB
+
+	PresentMode mode;
+	uint8_t persist;
+	int width;
+	int height;
+	char const* title;
+	int windowWidth;
+	int windowHeight;
+
 	SDL_Window* window{};
 	SDL_Renderer* renderer{};
-	SDL_Texture* texture{};
+	SDL_Texture* texture{}; // streaming in RGBA mode, render target in Indexed mode
+	SDL_Texture* atlas{};
 };
\ No newline at end of file
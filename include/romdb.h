@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class chip8;
+
+// Per-game configuration looked up by the SHA-1 of the ROM bytes, so a library of ROMs runs at
+// the right speed, with the right quirks, colours and keys without any per-game arguments.
+// The database is a text file read once into a flat array of fixed-size entries sorted by hash;
+// a lookup is a binary search over it and nothing is allocated per entry but its name.
+//
+// One ROM per line, blank lines and lines starting with # are ignored:
+//
+//   <sha1, 40 hex digits> [ipf=<n>] [quirks=<q>,...|none] [palette=<RRGGBB>,<RRGGBB>] [keys=<16 hex>] [name=<rest of line>]
+//
+//   ipf      instructions per frame (60 frames a second), 1-10000
+//   quirks   shift, load_store, jump, vf_reset, wrap (chip8::Quirk)
+//   palette  foreground (lit) and background colours
+//   keys     digit p is the CHIP-8 key driven by the host key that gives key p by default
+//            (1234 / QWER / ASDF / ZXCV), 0123456789ABCDEF is the default layout
+//
+// A hash that appears more than once takes its last line, so local overrides can be appended.
+class RomDb
+{
+public:
+    static constexpr size_t DIGEST_SIZE = 20;
+
+    enum Flags : uint8_t
+    {
+        HAS_PALETTE = 1u << 0,
+        HAS_KEYS = 1u << 1
+    };
+
+    struct Entry
+    {
+        uint8_t sha1[DIGEST_SIZE];
+        uint16_t instructions_per_frame; // 0 = not given, keep the machine's
+        uint8_t quirks;                  // chip8::Quirk bits
+        uint8_t flags;
+        uint32_t foreground;             // 0xRRGGBB, with HAS_PALETTE
+        uint32_t background;
+        uint8_t keys[16];                // with HAS_KEYS, CHIP-8 key per default host key
+        uint32_t name;                   // offset into names, "" when not given
+    };
+
+    static void Sha1(uint8_t const *data, size_t size, uint8_t out[DIGEST_SIZE]);
+
+    // Replace the contents with the file / text. On a malformed line the contents stay as they were
+    // and error (when given) says which line and why.
+    bool Load(char const *path, std::string *error = nullptr);
+    bool Parse(char const *text, size_t size, std::string *error = nullptr);
+
+    Entry const *Find(uint8_t const sha1[DIGEST_SIZE]) const;
+    // Hashes the ROM first, data / size as given to chip8::LoadROM
+    Entry const *Find(uint8_t const *data, size_t size) const;
+
+    char const *Name(Entry const &entry) const
+    {
+        return names.c_str() + entry.name;
+    }
+
+    size_t Size() const
+    {
+        return entries.size();
+    }
+
+    // A quirks= value, "none" or names separated by commas, to chip8::Quirk bits. False on an
+    // unknown name.
+    static bool ParseQuirks(char const *text, size_t length, uint8_t &quirks);
+
+    // Speed and quirks, the parts of an entry that belong to the machine. Palette and keys are
+    // up to the frontend.
+    static void Apply(Entry const &entry, chip8 &machine);
+
+private:
+    std::vector<Entry> entries; // sorted by sha1, unique
+    std::string names;          // NUL separated, starts with the empty name
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class chip8;
+
+// Hosts many machines on a few threads. A machine already keeps all of its state in the object,
+// so a task is just a machine that runs to its next yield point (Run with STOP_FRAME |
+// STOP_KEY_WAIT) and returns; no stacks to switch, and a parked task is a pointer in a list:
+//   frame boundary   paced tasks sleep in their worker's timer heap until the next frame is due,
+//                    unpaced ones go to the back of the run queue
+//   Fx0A, no key     the task leaves every queue and costs nothing until SetKey wakes it
+// Each worker pops its own run queue from the front; an idle worker steals half of another
+// worker's queue from the back before it sleeps until its next timer.
+class Scheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Task = uint32_t;
+
+    struct Options
+    {
+        int workers = 0;  // 0 = one per allowed CPU
+        bool pin = true;
+        int frame_hz = 60; // frames per second per task, 0 = back to back
+    };
+
+    // Summed over workers
+    struct Stats
+    {
+        uint64_t frames = 0;    // slices that ended on a frame boundary
+        uint64_t key_waits = 0; // slices that ended blocked in Fx0A
+        uint64_t wakeups = 0;   // blocked tasks woken by SetKey
+        uint64_t steals = 0;    // tasks taken from another worker's queue
+        uint64_t sleeps = 0;    // times a worker found nothing to run and slept
+    };
+
+    explicit Scheduler(Options const &options);
+    ~Scheduler();
+
+    Scheduler(Scheduler const &) = delete;
+    Scheduler &operator=(Scheduler const &) = delete;
+
+    // The machine stays the caller's and must outlive the scheduler; it is only touched by
+    // workers between Start and Stop. Queued on worker (task % workers) unless one is given.
+    // Safe to call while running.
+    Task Add(chip8 *machine, int worker = -1);
+
+    void Start();
+    // Workers finish their current slice and exit, tasks keep their place for the next Start
+    void Stop();
+
+    // Thread safe. Keys reach the machine at the start of its next slice; any key down wakes a
+    // task blocked in Fx0A.
+    void SetKey(Task task, int key, bool pressed);
+
+    Stats Totals() const;
+    size_t Tasks() const;
+
+private:
+    enum State : uint8_t
+    {
+        Queued,
+        Running,
+        Sleeping, // in a timer heap
+        Blocked   // in Fx0A, owned by nobody until SetKey
+    };
+
+    struct Entry
+    {
+        chip8 *machine = nullptr;
+        std::atomic<uint16_t> keys{0};
+        std::atomic<uint8_t> state{Queued};
+        std::atomic<int> worker{0}; // last worker to run it, where SetKey requeues it
+        Clock::time_point due{};
+    };
+
+    struct Timer
+    {
+        Clock::time_point due;
+        Entry *entry;
+
+        bool operator>(Timer const &other) const
+        {
+            return due > other.due;
+        }
+    };
+
+    struct alignas(64) Worker
+    {
+        std::mutex mutex; // queue and kicked
+        std::condition_variable wake;
+        std::deque<Entry *> queue;
+        bool kicked = false;
+        std::atomic<bool> sleeping{false};
+        std::vector<Timer> timers; // min-heap, owner only
+        std::thread thread;
+
+        // Single writer counters, read by Totals
+        std::atomic<uint64_t> frames{0};
+        std::atomic<uint64_t> key_waits{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<uint64_t> sleeps{0};
+    };
+
+    void Work(int w, int cpu);
+    void Slice(int w, Entry &entry);
+    void Push(int w, Entry *entry);
+    Entry *Steal(int w);
+    void Kick(int w);
+    static void Bump(std::atomic<uint64_t> &counter);
+
+    Options options;
+    std::vector<int> cpus;
+    std::unique_ptr<Worker[]> workers;
+    int worker_count = 0;
+
+    mutable std::mutex tasks_mutex; // Add / lookup, entries never move once added
+    std::deque<Entry> entries;
+
+    std::atomic<uint64_t> wakeups{0};
+    std::atomic<bool> stop{false};
+    bool running = false;
+};
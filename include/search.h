@@ -0,0 +1,121 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "chip8.h"
+#include "paged.h"
+
+// Lock-free set of 64-bit state hashes shared by every search thread. Open addressing with
+// linear probing over a fixed power of two table, 0 marks an empty slot (hash 0 is stored as 1).
+class StateSet
+{
+public:
+    explicit StateSet(int bits);
+    ~StateSet();
+
+    StateSet(StateSet const &) = delete;
+    StateSet &operator=(StateSet const &) = delete;
+
+    // True if hash wasn't in the set yet. Once a probe run gets too long (the table is nearly
+    // full) inserts report new, so the search degrades to no deduplication instead of failing.
+    bool Insert(uint64_t hash);
+    void Clear();
+    size_t Capacity() const
+    {
+        return mask + 1;
+    }
+
+private:
+    static constexpr int MAX_PROBE = 64;
+
+    std::atomic<uint64_t> *slots{};
+    size_t mask;
+};
+
+// Finds keypad sequences that reach a goal state. Every step holds one key (or none) for a few
+// frames; each level of the search expands all frontier states by all actions across threads,
+// drops states already seen anywhere in the search (StateSet on chip8::Hash), and keeps the
+// best scoring beam_width of the rest (all of them, up to max_states, when beam_width is 0, which
+// makes it breadth first). Frontier states are copy-on-write PagedStates forked from their parent,
+// children are only recorded as (parent, action, score) and the survivors simulated again, so
+// memory stays bounded by the beam.
+class Search
+{
+public:
+    struct Options
+    {
+        int depth = 64;                 // maximum actions in a sequence
+        int beam_width = 1024;          // survivors per level, 0 = breadth first
+        size_t max_states = 1u << 20;   // frontier cap for breadth first
+        int frames_per_action = 4;      // frames each action is held for
+        int threads = 0;                // 0 = one per hardware thread
+        int table_bits = 24;            // StateSet holds 2^table_bits hashes
+        uint16_t keys = 0xFFFF;         // keys to try, bit n = key n, "no key" is always tried
+    };
+
+    static constexpr int8_t NO_KEY = -1;
+
+    struct Result
+    {
+        bool found = false;          // a state satisfied the goal
+        std::vector<int8_t> actions; // key held per step (NO_KEY for none), the goal path or the best found
+        int64_t score = 0;           // score of the state actions leads to
+        uint64_t expanded = 0;       // states simulated
+        uint64_t unique = 0;         // of those, never seen before
+        int levels = 0;              // levels searched
+        int threads = 0;
+        double seconds = 0;
+    };
+
+    using Score = std::function<int64_t(chip8 const &)>;
+    using Goal = std::function<bool(chip8 const &)>;
+
+    explicit Search(Options const &options);
+
+    // Searches from start (copied, never modified). score ranks states for the beam, goal ends
+    // the search; either may be empty.
+    Result Run(chip8 const &start, Score const &score, Goal const &goal);
+
+private:
+    struct Candidate
+    {
+        uint32_t parent;
+        int8_t action;
+        bool goal;
+        int64_t score;
+    };
+
+    // How a frontier state was reached, one vector per level, for rebuilding the path
+    struct Trail
+    {
+        uint32_t parent;
+        int8_t action;
+    };
+
+    // One per thread, padded so counters of different threads never share a cache line
+    struct alignas(64) Worker
+    {
+        explicit Worker(chip8 const &start) : machine(start)
+        {
+        }
+
+        chip8 machine;
+        PagedState const *loaded = nullptr; // state machine's memory was last restored from / saved to
+        std::vector<Candidate> found;
+        uint64_t expanded = 0;
+        uint64_t unique = 0;
+    };
+
+    static void Apply(chip8 &machine, int8_t action, int frames);
+    // Calls fn(worker, i) for i in [0, count), spread over the worker threads in small chunks
+    template <typename Fn>
+    void Parallel(size_t count, Fn &&fn);
+    std::vector<int8_t> Path(std::vector<std::vector<Trail>> const &trails, uint32_t last) const;
+
+    Options options;
+    std::vector<int8_t> actions;
+    std::vector<Worker> workers;
+};
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include "chip8.h"
+
+// Persistent, deduplicated collection of machine states for tools that keep millions of them
+// between runs (search frontiers, regression corpora). Two memory-mapped files:
+//
+//   <path>      header page, then fixed-size Records (a chip8::Snapshot and its Digest), appended
+//   <path>.idx  open addressing table of (Key, record) with linear probing, kept at most half
+//               full, rebuilt from the records whenever it is missing or out of date
+//
+// Records are deduplicated on Key, which is Digest() plus the random engine and keypad: two
+// states only share a record if they replay identically from it.
+//
+// Opening maps both files and reads nothing else, so reaching a record costs the page faults of
+// its own pages and Load restores straight from the mapping into a machine. Records are the
+// in-memory Snapshot layout: files are only readable by builds with the same Snapshot (checked
+// through RECORD_SIZE in the header).
+//
+// One writer. Get and Load are const and safe from any number of threads while nothing appends;
+// an Append that grows the file remaps it, so references from Get don't survive it.
+class StateStore
+{
+public:
+    static constexpr uint32_t MAGIC = 0x53533843; // "C8SS" little endian
+    static constexpr uint32_t VERSION = 1;
+    static constexpr uint32_t INDEX_VERSION = 2; // 1 indexed Digest() alone, rebuilt on open
+    static constexpr uint64_t NOT_FOUND = ~0ull;
+
+    struct alignas(64) Record
+    {
+        uint64_t digest; // chip8::Digest() of the state, checked by Load
+        chip8::Snapshot snapshot;
+    };
+
+    StateStore() = default;
+    ~StateStore();
+
+    StateStore(StateStore const &) = delete;
+    StateStore &operator=(StateStore const &) = delete;
+
+    // Opens path, creating an empty store if it doesn't exist. False (and error when given) if it
+    // can't be opened or was written by a build with a different Record.
+    bool Open(char const *path, std::string *error = nullptr);
+    // Trims the data file to its records and unmaps everything
+    void Close();
+    // msync both files, for callers that need the records on disk before going on
+    void Sync();
+
+    // What records are deduplicated on: Digest(), the random engine and the keypad
+    static uint64_t Key(chip8 const &machine);
+
+    // Stores machine's state unless one with the same Key is already there. Returns the record
+    // number either way, added says which. NOT_FOUND if the files couldn't grow, the store is then
+    // unchanged and still usable.
+    uint64_t Append(chip8 const &machine, bool *added = nullptr);
+    // Record number of the state with this Key, or NOT_FOUND
+    uint64_t Find(uint64_t key) const;
+
+    Record const &Get(uint64_t record) const
+    {
+        return records[record];
+    }
+    // Restore from the mapped record, no intermediate copy. The cached hashes in the file aren't
+    // trusted, the machine is rehashed; false if the result doesn't match the record's digest (a
+    // damaged file), the machine then holds whatever the record did.
+    bool Load(uint64_t record, chip8 &machine) const
+    {
+        machine.Restore(records[record].snapshot);
+        machine.Rehash();
+        return machine.Digest() == records[record].digest;
+    }
+
+    uint64_t Size() const
+    {
+        return header ? header->count : 0;
+    }
+
+private:
+    static constexpr size_t HEADER_SIZE = 4096; // records start page aligned
+    static constexpr uint64_t MIN_CAPACITY = 1024;
+
+    struct Header
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t reserved;
+        uint64_t count; // records written, bumped after the record itself
+    };
+
+    struct IndexHeader
+    {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t count;    // records indexed, the index is stale unless it equals Header::count
+        uint64_t capacity; // slots, a power of two
+    };
+
+    struct Slot
+    {
+        uint64_t key;
+        uint64_t record; // record number + 1, 0 = empty
+    };
+
+    static uint64_t Key(uint64_t digest, std::default_random_engine const &rng, uint8_t const *keypad);
+
+    bool MapData(uint64_t capacity);
+    bool BuildIndex(uint64_t capacity);
+    void Insert(uint64_t key, uint64_t record);
+
+    std::string path;
+    bool trim = false; // the data file passed validation, Close may shrink it
+    int data_fd = -1;
+    int index_fd = -1;
+
+    uint8_t *data = nullptr;
+    size_t data_size = 0;
+    Header *header = nullptr;
+    Record *records = nullptr;
+    uint64_t capacity = 0; // records the data mapping has room for
+
+    uint8_t *index = nullptr;
+    size_t index_size = 0;
+    IndexHeader *index_header = nullptr;
+    Slot *slots = nullptr;
+};
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Live performance counters for a running emulator. The emulation thread is the only writer and
+// bumps plain relaxed atomics (no locked instructions); an exporter thread reads them every
+// interval and writes one text line per export to a file or to every client of a Unix socket:
+//
+//   c8stats t=2.000 instructions=1200000 ips=600000 frames=75000 fps=37500 presented=120
+//   presented_fps=60 cycle_ns=41 input_ns=1800 update_ns=950000 latency_us=8300 latency_max_us=16600
+//   latency_samples=4
+//
+// Totals are since Open, rates and *_ns averages (per call) cover the last interval only.
+// latency_* is key change seen by ProcessInput to the next present, averaged over the interval.
+class Telemetry
+{
+public:
+    enum Counter
+    {
+        Instructions,
+        Frames,           // emulated, one per instructions_per_frame instructions
+        Presented,        // frames handed to the frontend
+        CycleNs,          // time inside chip8::Cycle
+        CycleCalls,
+        InputNs,          // time inside ProcessInput
+        InputCalls,
+        UpdateNs,         // time presenting (Update / UpdateIndexed)
+        UpdateCalls,
+        LatencyNs,
+        LatencySamples,
+        COUNT
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    Telemetry() = default;
+    ~Telemetry();
+
+    Telemetry(Telemetry const &) = delete;
+    Telemetry &operator=(Telemetry const &) = delete;
+
+    // target is a file path (lines are appended) or unix:<path> (a listening socket, clients get
+    // every line from the moment they connect). Starts the exporter thread.
+    bool Open(char const *target, int interval_ms = 1000);
+    void Close();
+
+    // Single writer: load + store, not a read-modify-write
+    void Add(Counter counter, uint64_t value)
+    {
+        counters[counter].store(counters[counter].load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    void Latency(uint64_t ns)
+    {
+        Add(LatencyNs, ns);
+        Add(LatencySamples, 1);
+        if (ns > latency_max.load(std::memory_order_relaxed))
+        {
+            latency_max.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    static uint64_t Since(Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    // One export line for the counters now, against previous (updated to now). Returns its length.
+    size_t Format(char *out, size_t size, double seconds, double interval, uint64_t (&previous)[COUNT]);
+
+private:
+    void Export();
+    void Write(char const *line, size_t length);
+
+    std::atomic<uint64_t> counters[COUNT]{};
+    std::atomic<uint64_t> latency_max{0}; // reset by every export
+
+    FILE *file{};
+    int listener = -1;
+    std::vector<int> clients;
+    char socket_path[108]{};
+
+    int interval_ms = 1000;
+    std::thread exporter;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stop = false;
+};
@@ -0,0 +1,288 @@
+#pragma once
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+// Headless text backend, drop-in for Platform when SDL isn't available (e.g. over SSH).
+// Two video rows share one character cell via half-block glyphs, only changed cells are
+// re-emitted, and every frame goes out with a single write() from a preallocated buffer.
+class Terminal
+{
+public:
+	Terminal(int textureWidth, int textureHeight)
+		: width(textureWidth), height(textureHeight), rows((textureHeight + 1) / 2)
+	{
+		cells = new uint8_t[width * rows];
+		memset(cells, CELL_UNKNOWN, width * rows);
+
+		// Worst case per cell is a cursor move plus a 3 byte UTF-8 glyph.
+		capacity = width * rows * (sizeof("\x1b[999;999H") + 3) + 64;
+		out = new char[capacity];
+
+		// VMIN = VTIME = 0 makes read() return at once. No O_NONBLOCK: on a tty stdin and stdout
+		// are usually one open file, and it would make frame writes fail with EAGAIN.
+		if (tcgetattr(STDIN_FILENO, &saved) == 0)
+		{
+			termios raw = saved;
+			raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+			raw.c_iflag &= ~(IXON | ICRNL);
+			raw.c_cc[VMIN] = 0;
+			raw.c_cc[VTIME] = 0;
+			tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw);
+			restore = true;
+		}
+
+		// Alternate screen, hide cursor, clear.
+		Emit("\x1b[?1049h\x1b[?25l\x1b[2J");
+	}
+
+	~Terminal()
+	{
+		Emit("\x1b[0m\x1b[?25h\x1b[?1049l");
+		if (restore)
+		{
+			tcsetattr(STDIN_FILENO, TCSAFLUSH, &saved);
+		}
+		delete[] out;
+		delete[] cells;
+	}
+
+	Terminal(Terminal const&) = delete;
+	Terminal& operator=(Terminal const&) = delete;
+
+	// Same contract as Platform::Update, buffer is textureHeight rows of 32bit pixels, pitch in bytes.
+	void Update(void const* buffer, int pitch)
+	{
+		char* p = out;
+		int lastRow = -1;
+		int lastCol = -1;
+
+		for (int row = 0; row < rows; ++row)
+		{
+			uint32_t const* top = Row(buffer, pitch, row * 2);
+			uint32_t const* bottom = (row * 2 + 1 < height) ? Row(buffer, pitch, row * 2 + 1) : nullptr;
+
+			for (int col = 0; col < width; ++col)
+			{
+				uint8_t cell = (top[col] ? 1u : 0u) | ((bottom && bottom[col]) ? 2u : 0u);
+				uint8_t& prev = cells[row * width + col];
+				if (cell == prev)
+				{
+					continue;
+				}
+				prev = cell;
+
+				// Skip the cursor move when the terminal is already sitting on this cell.
+				if (row != lastRow || col != lastCol)
+				{
+					p = MoveTo(p, row + 1, col + 1);
+				}
+				memcpy(p, GLYPHS[cell], GLYPH_LEN[cell]);
+				p += GLYPH_LEN[cell];
+				lastRow = row;
+				lastCol = col + 1;
+			}
+		}
+
+		if (p != out)
+		{
+			Flush(out, p - out);
+		}
+	}
+
+	// Same contract as Platform::ProcessInput. Terminals only report presses (as key repeats),
+	// so a key counts as held until KEY_HOLD has passed without another press.
+	bool ProcessInput(uint8_t* keys)
+	{
+		bool quit = false;
+		auto now = std::chrono::steady_clock::now();
+
+		char input[64];
+		ssize_t n;
+		while (Ready(STDIN_FILENO, POLLIN) && (n = read(STDIN_FILENO, input, sizeof(input))) > 0)
+		{
+			for (ssize_t i = 0; i < n; ++i)
+			{
+				char c = input[i];
+				// ESC on its own quits, escape sequences (arrows etc.) are swallowed and whatever
+				// follows them in the same read still counts.
+				if (c == 0x1b)
+				{
+					if (i + 1 >= n)
+					{
+						quit = true;
+					}
+					else
+					{
+						i = EscapeEnd(input, i, n);
+					}
+					continue;
+				}
+				if (c == 0x03) // Ctrl-C, ISIG is off in raw mode
+				{
+					quit = true;
+					continue;
+				}
+
+				int key = KeyFor(c);
+				if (key >= 0)
+				{
+					keys[key] = 1;
+					pressed[key] = now;
+				}
+			}
+		}
+
+		for (int key = 0; key < 16; ++key)
+		{
+			if (keys[key] && now - pressed[key] > KEY_HOLD)
+			{
+				keys[key] = 0;
+			}
+		}
+
+		return quit;
+	}
+
+private:
+	static constexpr uint8_t CELL_UNKNOWN = 0xFF; // forces the first frame to be drawn in full
+	static constexpr std::chrono::milliseconds KEY_HOLD{150};
+
+	// Indexed by (top lit) | (bottom lit) << 1
+	static constexpr char const* GLYPHS[4] = {" ", "\xe2\x96\x80", "\xe2\x96\x84", "\xe2\x96\x88"};
+	static constexpr uint8_t GLYPH_LEN[4] = {1, 3, 3, 3};
+
+	// Last byte of the escape sequence at input[i], which has at least one byte after the ESC.
+	// CSI is ESC [ then parameters up to a final byte in @-~, SS3 is ESC O and one byte, anything
+	// else is ESC and one byte (Alt+key). Cut short at the end of the read.
+	static ssize_t EscapeEnd(char const* input, ssize_t i, ssize_t n)
+	{
+		char kind = input[i + 1];
+		ssize_t end = i + 1;
+		if (kind == 'O')
+		{
+			end = i + 2;
+		}
+		else if (kind == '[')
+		{
+			end = i + 2;
+			while (end < n && (input[end] < 0x40 || input[end] > 0x7e))
+			{
+				++end;
+			}
+		}
+		return end < n ? end : n - 1;
+	}
+
+	static uint32_t const* Row(void const* buffer, int pitch, int y)
+	{
+		return reinterpret_cast<uint32_t const*>(static_cast<char const*>(buffer) + y * pitch);
+	}
+
+	static char* Digits(char* p, int value)
+	{
+		if (value >= 100)
+		{
+			*p++ = '0' + value / 100;
+		}
+		if (value >= 10)
+		{
+			*p++ = '0' + (value / 10) % 10;
+		}
+		*p++ = '0' + value % 10;
+		return p;
+	}
+
+	static char* MoveTo(char* p, int row, int col)
+	{
+		*p++ = '\x1b';
+		*p++ = '[';
+		p = Digits(p, row);
+		*p++ = ';';
+		p = Digits(p, col);
+		*p++ = 'H';
+		return p;
+	}
+
+	// Same layout as Platform's SDL key map.
+	static int KeyFor(char c)
+	{
+		switch (c)
+		{
+			case 'x': return 0x0;
+			case '1': return 0x1;
+			case '2': return 0x2;
+			case '3': return 0x3;
+			case 'q': return 0x4;
+			case 'w': return 0x5;
+			case 'e': return 0x6;
+			case 'a': return 0x7;
+			case 's': return 0x8;
+			case 'd': return 0x9;
+			case 'z': return 0xA;
+			case 'c': return 0xB;
+			case '4': return 0xC;
+			case 'r': return 0xD;
+			case 'f': return 0xE;
+			case 'v': return 0xF;
+		}
+		return -1;
+	}
+
+	void Emit(char const* s)
+	{
+		Flush(s, strlen(s));
+	}
+
+	// Whether fd is ready for events now (timeout 0) or, with wait, once it becomes ready.
+	// Input is polled rather than read blind so a stdin that isn't a tty (VMIN/VTIME don't
+	// apply) can't block a frame.
+	static bool Ready(int fd, short events, int timeout = 0)
+	{
+		pollfd p{fd, events, 0};
+		return poll(&p, 1, timeout) > 0 && (p.revents & events);
+	}
+
+	void Flush(char const* data, size_t size)
+	{
+		// One write() in the common case, the loop only matters for a short write on a full pty.
+		// A frame that is cut short would leave cells already marked drawn, so it waits out a
+		// full (or non-blocking) output instead of dropping the rest.
+		while (size > 0)
+		{
+			ssize_t written = write(STDOUT_FILENO, data, size);
+			if (written < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (written < 0 && (errno == EAGAIN || errno == EWOULDBLOCK) && Ready(STDOUT_FILENO, POLLOUT, -1))
+			{
+				continue;
+			}
+			if (written <= 0)
+			{
+				return;
+			}
+			data += written;
+			size -= written;
+		}
+	}
+
+	int width;
+	int height;
+	int rows;
+	uint8_t* cells{};
+	char* out{};
+	size_t capacity{};
+
+	termios saved{};
+	bool restore = false;
+
+	std::chrono::steady_clock::time_point pressed[16]{};
+};
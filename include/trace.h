@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// One executed instruction. Values are sampled after the instruction ran: vx is V[x] for the
+// opcode's x nibble, which covers every single register write, vf catches flag updates, and index
+// catches I changes. Multi register loads (Fx65) and stack traffic follow from memory and pc flow.
+struct TraceEntry
+{
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t index;
+    uint8_t vx;
+    uint8_t vf;
+};
+
+// Fixed size binary ring of the last capacity instructions. Record is a store and an increment,
+// all formatting is left to the offline decoder (tools/c8trace.cpp).
+class TraceRing
+{
+public:
+    // capacity is rounded up to a power of two
+    explicit TraceRing(size_t capacity)
+    {
+        size = RoundUp(capacity);
+        mask = size - 1;
+        entries = new TraceEntry[size];
+        owned = true;
+    }
+
+    // Records into caller owned storage (e.g. an Arena) of RoundUp(capacity) entries
+    TraceRing(TraceEntry *storage, size_t capacity)
+    {
+        size = RoundUp(capacity);
+        mask = size - 1;
+        entries = storage;
+    }
+
+    ~TraceRing()
+    {
+        if (owned)
+        {
+            delete[] entries;
+        }
+    }
+
+    static size_t RoundUp(size_t capacity)
+    {
+        size_t size = 1;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+        return size;
+    }
+
+    TraceRing(TraceRing const &) = delete;
+    TraceRing &operator=(TraceRing const &) = delete;
+
+    void Record(uint16_t pc, uint16_t opcode, uint16_t index, uint8_t vx, uint8_t vf)
+    {
+        entries[head++ & mask] = TraceEntry{pc, opcode, index, vx, vf};
+    }
+
+    // Entries currently held, oldest first via At(0)
+    size_t Count() const
+    {
+        return head < size ? head : size;
+    }
+
+    TraceEntry const &At(size_t i) const
+    {
+        return entries[(head - Count() + i) & mask];
+    }
+
+    uint64_t Total() const
+    {
+        return head;
+    }
+
+    void Clear()
+    {
+        head = 0;
+    }
+
+    // File layout: "C8TR", uint32 version, uint64 count, count TraceEntry records oldest first.
+    bool Save(char const *filename) const;
+
+private:
+    TraceEntry *entries{};
+    size_t size = 0;
+    size_t mask = 0;
+    uint64_t head = 0;
+    bool owned = false;
+};
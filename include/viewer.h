@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "SDL.h"
+#include "chip8.h"
+
+// Watches many machines in one window. Every framebuffer is a tile of one atlas texture, tiles are
+// only uploaded when the machine's video_digest moved since the last upload, and the whole grid
+// reaches the screen with a single SDL_RenderCopy. Runs of neighbouring dirty tiles in an atlas row
+// go up as one rectangle through a staging buffer, so a frame where everything changed is one
+// SDL_UpdateTexture per row of tiles rather than one per machine. Plain copies (no blending, nearest
+// scaling) keep the software renderer fast.
+class Viewer
+{
+public:
+	static constexpr int TILE_WIDTH = chip8::DISPLAY_WIDTH + 1; // one pixel of border right and below
+	static constexpr int TILE_HEIGHT = chip8::DISPLAY_HEIGHT + 1;
+
+	// Only records the configuration, SDL comes up in Open() (or the first Update / ProcessInput).
+	// columns 0 picks a roughly 2:1 grid. scale is capped at (and 0 picks) the largest integer
+	// scale that fits maxWidth.
+	Viewer(char const* title, int count, int columns = 0, int scale = 0, bool software = false, int maxWidth = 1600)
+		: title(title), count(count), software(software)
+	{
+		this->columns = columns > 0 ? columns : std::max(1, static_cast<int>(std::ceil(std::sqrt(count * 2.0))));
+		rows = (count + this->columns - 1) / this->columns;
+		atlasWidth = this->columns * TILE_WIDTH;
+		atlasHeight = rows * TILE_HEIGHT;
+		int fits = std::max(1, maxWidth / atlasWidth);
+		this->scale = scale > 0 ? std::min(scale, fits) : fits;
+		shown.assign(count, 0);
+		dirty.assign(count, 1);
+		staging.resize(static_cast<size_t>(atlasWidth) * chip8::DISPLAY_HEIGHT);
+	}
+
+	void Open()
+	{
+		if (window)
+		{
+			return;
+		}
+
+		SDL_Init(SDL_INIT_VIDEO);
+		SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "0");
+
+		window = SDL_CreateWindow(title, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, atlasWidth * scale,
+			atlasHeight * scale, SDL_WINDOW_SHOWN);
+		if (!software)
+		{
+			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+		}
+		if (!renderer)
+		{
+			renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+		}
+
+		atlas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_STREAMING, atlasWidth, atlasHeight);
+		SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_NONE);
+
+		// Borders are never uploaded again, tiles overwrite everything inside them.
+		std::vector<uint32_t> blank(static_cast<size_t>(atlasWidth) * atlasHeight, border);
+		SDL_UpdateTexture(atlas, nullptr, blank.data(), atlasWidth * sizeof(uint32_t));
+	}
+
+	~Viewer()
+	{
+		if (!window)
+		{
+			return;
+		}
+		SDL_DestroyTexture(atlas);
+		SDL_DestroyRenderer(renderer);
+		SDL_DestroyWindow(window);
+		SDL_Quit();
+	}
+
+	Viewer(Viewer const&) = delete;
+	Viewer& operator=(Viewer const&) = delete;
+
+	// machines holds count pointers, tile i is machines[i]. Dirtiness comes from video_digest, so
+	// anything that writes video directly must Rehash() the machine first. Returns tiles uploaded.
+	int Update(chip8 const* const* machines)
+	{
+		Open();
+
+		int uploaded = 0;
+		for (int i = 0; i < count; ++i)
+		{
+			uint64_t digest = machines[i]->video_digest;
+			dirty[i] |= digest != shown[i];
+			shown[i] = digest;
+		}
+
+		for (int row = 0; row < rows; ++row)
+		{
+			int first = row * columns;
+			int end = std::min(first + columns, count);
+			for (int i = first; i < end;)
+			{
+				if (!dirty[i])
+				{
+					++i;
+					continue;
+				}
+				int run = 0;
+				while (i + run < end && dirty[i + run])
+				{
+					dirty[i + run] = 0;
+					++run;
+				}
+				Upload(machines + i, i - first, row, run);
+				uploaded += run;
+				i += run;
+			}
+		}
+
+		SDL_RenderCopy(renderer, atlas, nullptr, nullptr);
+		SDL_RenderPresent(renderer);
+		return uploaded;
+	}
+
+	// Keys go to every machine (keys is the keypad they share), returns true on quit.
+	bool ProcessInput(uint8_t* keys)
+	{
+		Open();
+		bool quit = false;
+
+		SDL_Event event;
+		while (SDL_PollEvent(&event))
+		{
+			if (event.type == SDL_QUIT || (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE))
+			{
+				quit = true;
+			}
+			else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+			{
+				for (int key = 0; key < 16; ++key)
+				{
+					if (event.key.keysym.sym == keymap[key])
+					{
+						keys[key] = event.type == SDL_KEYDOWN;
+					}
+				}
+			}
+		}
+		return quit;
+	}
+
+	int Columns() const
+	{
+		return columns;
+	}
+
+	int Rows() const
+	{
+		return rows;
+	}
+
+private:
+	static constexpr uint32_t border = 0x303030FF;
+
+	// Same layout as Platform: 1 2 3 4 / Q W E R / A S D F / Z X C V
+	static constexpr int keymap[16] = {
+		SDLK_x, SDLK_1, SDLK_2, SDLK_3, SDLK_q, SDLK_w, SDLK_e, SDLK_a,
+		SDLK_s, SDLK_d, SDLK_z, SDLK_c, SDLK_4, SDLK_r, SDLK_f, SDLK_v};
+
+	// run neighbouring tiles starting at column, one SDL_UpdateTexture straight from video when
+	// run is 1, otherwise side by side in staging first
+	void Upload(chip8 const* const* machines, int column, int row, int run)
+	{
+		constexpr int width = chip8::DISPLAY_WIDTH;
+		constexpr int height = chip8::DISPLAY_HEIGHT;
+		SDL_Rect rect{column * TILE_WIDTH, row * TILE_HEIGHT, run * TILE_WIDTH - 1, height};
+
+		if (run == 1)
+		{
+			SDL_UpdateTexture(atlas, &rect, machines[0]->video, width * sizeof(uint32_t));
+			return;
+		}
+
+		int pitch = rect.w;
+		for (int y = 0; y < height; ++y)
+		{
+			uint32_t* out = &staging[static_cast<size_t>(y) * pitch];
+			for (int t = 0; t < run; ++t)
+			{
+				memcpy(out + t * TILE_WIDTH, &machines[t]->video[y * width], width * sizeof(uint32_t));
+				if (t + 1 < run)
+				{
+					out[t * TILE_WIDTH + width] = border;
+				}
+			}
+		}
+		SDL_UpdateTexture(atlas, &rect, staging.data(), pitch * sizeof(uint32_t));
+	}
+
+	char const* title;
+	int count;
+	bool software;
+	int columns;
+	int rows;
+	int atlasWidth;
+	int atlasHeight;
+	int scale;
+
+	std::vector<uint64_t> shown; // video_digest at the last upload
+	std::vector<uint8_t> dirty;  // changed since the last upload, every tile starts dirty
+	std::vector<uint32_t> staging;
+
+	SDL_Window* window{};
+	SDL_Renderer* renderer{};
+	SDL_Texture* atlas{};
+};
@@ -0,0 +1,432 @@
+#include "analyzer.h"
+#include "disassembler.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+    char const *EXIT_NAMES[] = {"fallthrough", "jump", "call", "return", "skip", "indirect", "halt", "end"};
+
+    // I at a block boundary: not seen yet, a known constant, or unknown.
+    constexpr int32_t I_UNSET = -1;
+    constexpr int32_t I_UNKNOWN = -2;
+
+    int32_t Meet(int32_t a, int32_t b)
+    {
+        if (a == I_UNSET)
+        {
+            return b;
+        }
+        if (b == I_UNSET || a == b)
+        {
+            return a;
+        }
+        return I_UNKNOWN;
+    }
+
+    uint16_t Fetch(uint8_t const *image, uint16_t address)
+    {
+        return (image[address & chip8::MEM_END] << 8u) | image[(address + 1) & chip8::MEM_END];
+    }
+
+    bool IsSkip(uint16_t opcode)
+    {
+        switch (opcode & 0xF000u)
+        {
+            // 5xyN and 9xyN skip whatever N is, as the interpreter runs them
+            case 0x3000u:
+            case 0x4000u:
+            case 0x5000u:
+            case 0x9000u:
+                return true;
+            case 0xE000u:
+                return (opcode & 0x00FFu) == 0x9Eu || (opcode & 0x00FFu) == 0xA1u;
+        }
+        return false;
+    }
+
+    bool IsTerminator(uint16_t opcode)
+    {
+        uint16_t family = opcode & 0xF000u;
+        return opcode == 0x00EEu || family == 0x1000u || family == 0x2000u || family == 0xB000u || IsSkip(opcode);
+    }
+}
+
+RomAnalysis RomAnalysis::Analyze(uint8_t const *image, size_t rom_size)
+{
+    RomAnalysis result;
+    uint32_t limit = std::min<uint32_t>(chip8::DATA_START + rom_size, chip8::MEM_END + 1);
+    auto inside = [&](uint32_t address) { return address >= chip8::DATA_START && address + 1 < limit; };
+
+    // Pass 1, reachable instructions and block leaders.
+    std::vector<uint16_t> work;
+    auto reach = [&](uint32_t address, bool leader) {
+        if (!inside(address))
+        {
+            return;
+        }
+        if (leader)
+        {
+            result.flags[address] |= LEADER;
+        }
+        if (!(result.flags[address] & INSTRUCTION))
+        {
+            result.flags[address] |= INSTRUCTION;
+            work.push_back(static_cast<uint16_t>(address));
+        }
+    };
+
+    reach(chip8::DATA_START, true);
+    while (!work.empty())
+    {
+        uint16_t address = work.back();
+        work.pop_back();
+        result.flags[address] |= CODE;
+        result.flags[address + 1] |= CODE;
+
+        uint16_t opcode = Fetch(image, address);
+        uint16_t nnn = opcode & 0x0FFFu;
+        switch (opcode & 0xF000u)
+        {
+            case 0x1000u:
+                reach(nnn, true);
+                continue;
+            case 0x2000u:
+                reach(nnn, true);
+                reach(address + 2, true);
+                continue;
+            case 0xB000u:
+                result.flags[address] |= INDIRECT;
+                continue;
+        }
+        if (opcode == 0x00EEu)
+        {
+            continue;
+        }
+        if (IsSkip(opcode))
+        {
+            reach(address + 2, true);
+            reach(address + 4, true);
+            continue;
+        }
+        reach(address + 2, false);
+    }
+
+    // Pass 2, blocks from each leader up to a terminator or the next leader.
+    for (uint32_t leader = chip8::DATA_START; leader < limit; ++leader)
+    {
+        if (!(result.flags[leader] & LEADER))
+        {
+            continue;
+        }
+
+        Block block{};
+        block.start = static_cast<uint16_t>(leader);
+        uint16_t address = block.start;
+        for (;;)
+        {
+            uint16_t opcode = Fetch(image, address);
+            uint16_t next = address + 2;
+            block.end = next;
+
+            if (IsTerminator(opcode))
+            {
+                uint16_t nnn = opcode & 0x0FFFu;
+                if (opcode == 0x00EEu)
+                {
+                    block.exit = Exit::Return;
+                }
+                else if ((opcode & 0xF000u) == 0x1000u)
+                {
+                    block.exit = (nnn == address) ? Exit::Halt : Exit::Jump;
+                    block.successors[block.successor_count++] = nnn;
+                }
+                else if ((opcode & 0xF000u) == 0x2000u)
+                {
+                    block.exit = Exit::Call;
+                    block.successors[block.successor_count++] = nnn;
+                    block.successors[block.successor_count++] = next;
+                }
+                else if ((opcode & 0xF000u) == 0xB000u)
+                {
+                    block.exit = Exit::Indirect;
+                }
+                else
+                {
+                    block.exit = Exit::Skip;
+                    block.successors[block.successor_count++] = next;
+                    block.successors[block.successor_count++] = next + 2;
+                }
+                break;
+            }
+            if (!inside(next) || !(result.flags[next] & INSTRUCTION))
+            {
+                block.exit = Exit::End;
+                break;
+            }
+            if (result.flags[next] & LEADER)
+            {
+                block.exit = Exit::Fallthrough;
+                block.successors[block.successor_count++] = next;
+                break;
+            }
+            address = next;
+        }
+        result.blocks.push_back(block);
+    }
+
+    // Pass 3, forward constant propagation of I to find sprite data and store targets. Marking
+    // waits for the fixed point: a block first reached with a constant I may meet another later.
+    std::vector<int32_t> entry(result.blocks.size(), I_UNSET);
+    std::vector<size_t> pending;
+    if (!result.blocks.empty())
+    {
+        entry[0] = 0; // index is 0 after Reset
+        pending.push_back(0);
+    }
+    auto mark = [&](int32_t i, unsigned length, uint8_t flag) {
+        for (unsigned k = 0; k < length; ++k)
+        {
+            result.flags[(i + k) & chip8::MEM_END] |= flag;
+        }
+    };
+    // I at the end of block given I at its start, marking what it reads and writes when asked
+    auto walk = [&](Block &block, int32_t i, bool marking) {
+        for (uint16_t address = block.start; address < block.end; address += 2)
+        {
+            uint16_t opcode = Fetch(image, address);
+            unsigned x = (opcode & 0x0F00u) >> 8u;
+            switch (opcode & 0xF000u)
+            {
+                case 0xA000u:
+                    i = opcode & 0x0FFFu;
+                    break;
+                case 0xD000u:
+                    if (marking && i >= 0)
+                    {
+                        mark(i, opcode & 0x000Fu, DATA);
+                    }
+                    break;
+                case 0xF000u:
+                    switch (opcode & 0x00FFu)
+                    {
+                        case 0x1Eu:
+                        case 0x29u:
+                            i = I_UNKNOWN;
+                            break;
+                        case 0x65u:
+                            if (marking && i >= 0)
+                            {
+                                mark(i, x + 1, DATA);
+                            }
+                            break;
+                        case 0x55u:
+                        case 0x33u:
+                            if (!marking)
+                            {
+                                break;
+                            }
+                            if (i >= 0)
+                            {
+                                mark(i, (opcode & 0x00FFu) == 0x55u ? x + 1 : 3, WRITTEN);
+                            }
+                            else
+                            {
+                                block.unknown_store = true;
+                            }
+                            break;
+                    }
+                    break;
+            }
+        }
+        return i;
+    };
+    auto propagate = [&](uint16_t target, int32_t value) {
+        Block const *successor = result.Find(target);
+        if (!successor)
+        {
+            return;
+        }
+        size_t at = successor - result.blocks.data();
+        int32_t merged = Meet(entry[at], value);
+        if (merged != entry[at])
+        {
+            entry[at] = merged;
+            pending.push_back(at);
+        }
+    };
+
+    while (!pending.empty())
+    {
+        size_t at = pending.back();
+        pending.pop_back();
+        Block &block = result.blocks[at];
+        int32_t i = walk(block, entry[at], false);
+
+        if (block.exit == Exit::Call)
+        {
+            propagate(block.successors[0], i);
+            propagate(block.successors[1], I_UNKNOWN); // the callee may have changed I
+        }
+        else
+        {
+            for (uint8_t s = 0; s < block.successor_count; ++s)
+            {
+                propagate(block.successors[s], i);
+            }
+        }
+    }
+
+    for (size_t at = 0; at < result.blocks.size(); ++at)
+    {
+        if (entry[at] != I_UNSET)
+        {
+            walk(result.blocks[at], entry[at], true);
+        }
+    }
+
+    for (Block &block : result.blocks)
+    {
+        for (uint16_t address = block.start; address < block.end; ++address)
+        {
+            if (result.flags[address] & WRITTEN)
+            {
+                block.self_modifying = true;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+RomAnalysis::Block const *RomAnalysis::Find(uint16_t address) const
+{
+    auto it = std::lower_bound(blocks.begin(), blocks.end(), address,
+                               [](Block const &block, uint16_t value) { return block.start < value; });
+    return (it != blocks.end() && it->start == address) ? &*it : nullptr;
+}
+
+void RomAnalysis::WriteDot(FILE *out, uint8_t const *image) const
+{
+    char text[32];
+    fprintf(out, "digraph rom {\n  node [shape=box fontname=monospace];\n");
+    for (Block const &block : blocks)
+    {
+        fprintf(out, "  b%03X [label=\"", block.start);
+        fprintf(out, "%03X-%03X %s\\l", block.start, block.end - 1, EXIT_NAMES[static_cast<int>(block.exit)]);
+        for (uint16_t address = block.start; image && address < block.end; address += 2)
+        {
+            Disassembler::Format(Fetch(image, address), text, sizeof(text));
+            fprintf(out, "%03X  %s\\l", address, text);
+        }
+        fprintf(out, "\"%s%s];\n", block.self_modifying ? " color=red" : "",
+                block.exit == Exit::Indirect ? " style=dashed" : "");
+
+        for (uint8_t s = 0; s < block.successor_count; ++s)
+        {
+            bool ret = block.exit == Exit::Call && s == 1;
+            fprintf(out, "  b%03X -> b%03X%s;\n", block.start, block.successors[s], ret ? " [style=dotted]" : "");
+        }
+    }
+    fprintf(out, "}\n");
+}
+
+void RomAnalysis::WriteHints(FILE *out) const
+{
+    fprintf(out, "c8hints 1\n");
+    for (Block const &block : blocks)
+    {
+        fprintf(out, "block %03X %03X %d %d %03X %03X %d %d\n", block.start, block.end, static_cast<int>(block.exit),
+                block.successor_count, block.successors[0], block.successors[1], block.self_modifying ? 1 : 0,
+                block.unknown_store ? 1 : 0);
+    }
+
+    // Runs of sprite / table data
+    for (uint32_t address = 0; address < chip8::MEM_SIZE;)
+    {
+        if (!(flags[address] & DATA))
+        {
+            ++address;
+            continue;
+        }
+        uint32_t start = address;
+        while (address < chip8::MEM_SIZE && (flags[address] & DATA))
+        {
+            ++address;
+        }
+        fprintf(out, "data %03X %u\n", start, address - start);
+    }
+}
+
+bool RomAnalysis::ReadHints(FILE *in, RomAnalysis &out)
+{
+    out = RomAnalysis{};
+
+    int version = 0;
+    if (fscanf(in, " c8hints %d", &version) != 1 || version != 1)
+    {
+        return false;
+    }
+
+    char kind[8];
+    while (fscanf(in, " %7s", kind) == 1)
+    {
+        if (strcmp(kind, "block") == 0)
+        {
+            unsigned start, end, s0, s1;
+            int exit, count, smc, unknown;
+            if (fscanf(in, "%x %x %d %d %x %x %d %d", &start, &end, &exit, &count, &s0, &s1, &smc, &unknown) != 8 ||
+                start >= end || end > chip8::MEM_SIZE || exit < 0 || exit > static_cast<int>(Exit::End) || count < 0 ||
+                count > 2)
+            {
+                return false;
+            }
+            Block block{};
+            block.start = static_cast<uint16_t>(start);
+            block.end = static_cast<uint16_t>(end);
+            block.exit = static_cast<Exit>(exit);
+            block.successor_count = static_cast<uint8_t>(count);
+            block.successors[0] = static_cast<uint16_t>(s0);
+            block.successors[1] = static_cast<uint16_t>(s1);
+            block.self_modifying = smc != 0;
+            block.unknown_store = unknown != 0;
+            out.blocks.push_back(block);
+
+            out.flags[start] |= LEADER;
+            for (unsigned address = start; address < end; ++address)
+            {
+                out.flags[address] |= CODE;
+            }
+            for (unsigned address = start; address < end; address += 2)
+            {
+                out.flags[address] |= INSTRUCTION;
+            }
+            if (block.exit == Exit::Indirect)
+            {
+                out.flags[end - 2] |= INDIRECT;
+            }
+        }
+        else if (strcmp(kind, "data") == 0)
+        {
+            unsigned start, length;
+            if (fscanf(in, "%x %u", &start, &length) != 2 || start + length > chip8::MEM_SIZE)
+            {
+                return false;
+            }
+            for (unsigned k = 0; k < length; ++k)
+            {
+                out.flags[start + k] |= DATA;
+            }
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    std::sort(out.blocks.begin(), out.blocks.end(),
+              [](Block const &a, Block const &b) { return a.start < b.start; });
+    return true;
+}
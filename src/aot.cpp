@@ -0,0 +1,17 @@
+#include "aot.h"
+
+uint64_t AotRun(AotProgram const &program, chip8 &c, uint64_t budget)
+{
+    uint64_t executed = 0;
+    while (executed < budget)
+    {
+        uint32_t n = program.run_block(c);
+        if (n == 0)
+        {
+            c.Cycle();
+            n = 1;
+        }
+        executed += n;
+    }
+    return executed;
+}
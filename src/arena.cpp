@@ -0,0 +1,56 @@
+#include "arena.h"
+
+#include <cstring>
+
+#include <sys/mman.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+Arena::Arena(size_t capacity, int node) : capacity(capacity)
+{
+    void *mapping = mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED)
+    {
+        this->capacity = 0;
+        return;
+    }
+    base = static_cast<uint8_t *>(mapping);
+
+#ifdef __linux__
+    // mbind(2) directly, MPOL_PREFERRED from <linux/mempolicy.h>
+    static constexpr int MPOL_PREFERRED = 1;
+    if (node >= 0 && node < 64)
+    {
+        unsigned long mask = 1ul << node;
+        if (syscall(SYS_mbind, base, capacity, MPOL_PREFERRED, &mask, sizeof(mask) * 8, 0) == 0)
+        {
+            this->node = node;
+        }
+    }
+#else
+    (void)node;
+#endif
+}
+
+Arena::~Arena()
+{
+    if (base)
+    {
+        munmap(base, capacity);
+    }
+}
+
+void *Arena::Allocate(size_t size, size_t align)
+{
+    size_t start = (used + align - 1) & ~(align - 1);
+    if (!base || start > capacity || size > capacity - start)
+    {
+        return nullptr;
+    }
+    used = start + size;
+    // Touch now, from the allocating thread, rather than wherever the first use happens
+    memset(base + start, 0, size);
+    return base + start;
+}
@@ -0,0 +1,227 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "arena.h"
+#include "chip8.h"
+#include "numa.h"
+#include "trace.h"
+
+namespace
+{
+// Everything one worker owns, allocated from one arena
+struct Slice
+{
+    chip8 **instances{};
+    chip8::Snapshot *snapshots{};
+    TraceRing **traces{};
+    size_t count = 0;
+};
+
+size_t SliceBytes(size_t count, size_t trace_capacity)
+{
+    size_t per_instance = sizeof(chip8) + alignof(chip8) + sizeof(chip8 *) + sizeof(chip8::Snapshot);
+    if (trace_capacity)
+    {
+        per_instance += sizeof(TraceRing) + sizeof(TraceRing *) + sizeof(TraceEntry) * TraceRing::RoundUp(trace_capacity);
+    }
+    // Saturates, so absurd counts fail to map instead of wrapping to a small arena
+    if (count > (SIZE_MAX - (1u << 16)) / per_instance)
+    {
+        return SIZE_MAX;
+    }
+    return count * per_instance + (1u << 16);
+}
+
+bool Build(Slice &slice, Arena &arena, size_t first, size_t count, uint8_t const *rom, size_t size,
+           Batch::Options const &options)
+{
+    slice.instances = arena.Array<chip8 *>(count);
+    slice.snapshots = arena.Array<chip8::Snapshot>(count);
+    slice.traces = options.trace_capacity ? arena.Array<TraceRing *>(count) : nullptr;
+    if (!slice.instances || !slice.snapshots || (options.trace_capacity && !slice.traces))
+    {
+        return false;
+    }
+    // Only now, Destroy walks count entries of the arrays
+    slice.count = count;
+    for (size_t i = 0; i < count; ++i)
+    {
+        chip8 *c = arena.New<chip8>(static_cast<uint32_t>(options.seed + first + i));
+        if (!c)
+        {
+            return false;
+        }
+        c->LoadROM(rom, size);
+        c->instructions_per_frame = options.instructions_per_frame;
+        if (options.trace_capacity)
+        {
+            TraceEntry *entries = arena.Array<TraceEntry>(TraceRing::RoundUp(options.trace_capacity));
+            slice.traces[i] = entries ? arena.New<TraceRing>(entries, options.trace_capacity) : nullptr;
+            c->trace = slice.traces[i];
+        }
+        slice.instances[i] = c;
+    }
+    return true;
+}
+
+void Destroy(Slice &slice)
+{
+    for (size_t i = 0; i < slice.count; ++i)
+    {
+        if (slice.instances[i])
+        {
+            slice.instances[i]->~chip8();
+        }
+        if (slice.traces && slice.traces[i])
+        {
+            slice.traces[i]->~TraceRing();
+        }
+    }
+}
+
+// Different keys per instance and frame, cheap enough not to show up in the timing
+void Keys(chip8 &c, size_t instance, int frame)
+{
+    uint32_t h = static_cast<uint32_t>(instance * 2654435761u) ^ static_cast<uint32_t>(frame / 8 * 40503u);
+    h ^= h >> 13;
+    for (auto &key : c.keypad)
+    {
+        key = 0;
+    }
+    c.keypad[h & 0xFu] = (h >> 4) & 1u;
+}
+} // namespace
+
+Batch::Result Batch::Run(uint8_t const *rom, size_t size, Options const &options)
+{
+    Result result;
+    if (size > chip8::DATA_END - chip8::DATA_START + 1u)
+    {
+        return result;
+    }
+
+    std::vector<int> cpus = Topology::Cpus();
+    size_t workers = options.workers > 0 ? static_cast<size_t>(options.workers) : cpus.size();
+    workers = std::max<size_t>(1, std::min(workers, options.instances));
+
+    std::vector<Slice> slices(workers);
+    std::vector<size_t> firsts(workers);
+    std::vector<int> nodes(workers);
+    std::vector<double> seconds(workers);
+    std::vector<size_t> arena_bytes(workers);
+    std::vector<std::unique_ptr<Arena>> arenas(workers);
+    std::atomic<size_t> ready{0};
+    std::atomic<bool> go{false};
+    std::atomic<int> pinned{0};
+    std::atomic<bool> failed{false};
+
+    for (size_t w = 0; w < workers; ++w)
+    {
+        firsts[w] = options.instances * w / workers;
+        nodes[w] = Topology::NodeOf(cpus[w % cpus.size()]);
+    }
+    auto count = [&](size_t w) { return options.instances * (w + 1) / workers - firsts[w]; };
+
+    // Baseline: one arena, allocated and touched by this thread, wherever it runs
+    std::unique_ptr<Arena> shared;
+    if (!options.local)
+    {
+        shared.reset(new Arena(SliceBytes(options.instances, options.trace_capacity)));
+        for (size_t w = 0; w < workers; ++w)
+        {
+            failed = failed || !Build(slices[w], *shared, firsts[w], count(w), rom, size, options);
+        }
+    }
+
+    auto work = [&](size_t w) {
+        if (options.pin && Topology::Pin(cpus[w % cpus.size()]))
+        {
+            ++pinned;
+        }
+        if (options.local)
+        {
+            // Created on the pinned thread so first touch agrees with the binding
+            arenas[w].reset(new Arena(SliceBytes(count(w), options.trace_capacity), nodes[w]));
+            if (!Build(slices[w], *arenas[w], firsts[w], count(w), rom, size, options))
+            {
+                failed = true;
+            }
+            arena_bytes[w] = arenas[w]->Used();
+        }
+
+        ++ready;
+        while (!go.load(std::memory_order_acquire))
+        {
+            std::this_thread::yield();
+        }
+
+        auto began = std::chrono::steady_clock::now();
+        Slice &slice = slices[w];
+        if (!failed)
+        {
+            for (int frame = 0; frame < options.frames; ++frame)
+            {
+                bool save = options.snapshot_every > 0 && (frame + 1) % options.snapshot_every == 0;
+                for (size_t i = 0; i < slice.count; ++i)
+                {
+                    chip8 &c = *slice.instances[i];
+                    Keys(c, firsts[w] + i, frame);
+                    c.Frame();
+                    if (save)
+                    {
+                        c.Save(slice.snapshots[i]);
+                    }
+                }
+            }
+        }
+        seconds[w] = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+        Destroy(slice);
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 0; w < workers; ++w)
+    {
+        threads.emplace_back(work, w);
+    }
+    while (ready.load() < workers)
+    {
+        std::this_thread::yield();
+    }
+    go.store(true, std::memory_order_release);
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    if (failed)
+    {
+        return result;
+    }
+
+    for (size_t w = 0; w < workers; ++w)
+    {
+        auto node = std::find_if(result.nodes.begin(), result.nodes.end(), [&](Node const &n) { return n.node == nodes[w]; });
+        if (node == result.nodes.end())
+        {
+            result.nodes.push_back({});
+            node = result.nodes.end() - 1;
+            node->node = nodes[w];
+        }
+        uint64_t instructions = uint64_t{count(w)} * options.frames * options.instructions_per_frame;
+        ++node->workers;
+        node->instances += count(w);
+        node->instructions += instructions;
+        node->seconds = std::max(node->seconds, seconds[w]);
+        node->arena_bytes += arena_bytes[w];
+        result.instructions += instructions;
+        result.seconds = std::max(result.seconds, seconds[w]);
+    }
+    std::sort(result.nodes.begin(), result.nodes.end(), [](Node const &a, Node const &b) { return a.node < b.node; });
+    result.pinned = pinned.load() == static_cast<int>(workers);
+    return result;
+}
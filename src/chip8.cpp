@@ -0,0 +1,1060 @@
+#include "chip8.h"
+#include "disassembler.h"
+#include "paged.h"
+#include "trace.h"
+
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <utility>
+
+chip8::chip8() : chip8(std::chrono::system_clock::now().time_since_epoch().count())
+{
+}
+
+// Dispatch tables, built at compile time
+static constexpr std::array<chip8::chip8Func, 0x10> MakeTable()
+{
+    return {&chip8::Table0, &chip8::OP_1nnn, &chip8::OP_2nnn, &chip8::OP_3xkk,
+            &chip8::OP_4xkk, &chip8::OP_5xy0, &chip8::OP_6xkk, &chip8::OP_7xkk,
+            &chip8::Table8, &chip8::OP_9xy0, &chip8::OP_Annn, &chip8::OP_Bnnn,
+            &chip8::OP_Cxkk, &chip8::OP_Dxyn, &chip8::TableE, &chip8::TableF};
+}
+
+template <size_t N>
+static constexpr std::array<chip8::chip8Func, N> Unused()
+{
+    // populate the empty spots for bad calls and padding
+    std::array<chip8::chip8Func, N> t{};
+    for (size_t i = 0; i < N; ++i)
+    {
+        t[i] = &chip8::OP_NULL;
+    }
+    return t;
+}
+
+static constexpr std::array<chip8::chip8Func, 0x10> MakeTable0()
+{
+    auto t = Unused<0x10>();
+    t[0x0] = &chip8::OP_00E0;
+    t[0xE] = &chip8::OP_00EE;
+    return t;
+}
+
+static constexpr std::array<chip8::chip8Func, 0x10> MakeTable8()
+{
+    auto t = Unused<0x10>();
+    t[0x0] = &chip8::OP_8xy0;
+    t[0x1] = &chip8::OP_8xy1;
+    t[0x2] = &chip8::OP_8xy2;
+    t[0x3] = &chip8::OP_8xy3;
+    t[0x4] = &chip8::OP_8xy4;
+    t[0x5] = &chip8::OP_8xy5;
+    t[0x6] = &chip8::OP_8xy6;
+    t[0x7] = &chip8::OP_8xy7;
+    t[0xE] = &chip8::OP_8xyE;
+    return t;
+}
+
+static constexpr std::array<chip8::chip8Func, 0x10> MakeTableE()
+{
+    auto t = Unused<0x10>();
+    t[0x1] = &chip8::OP_ExA1;
+    t[0xE] = &chip8::OP_Ex9E;
+    return t;
+}
+
+static constexpr std::array<chip8::chip8Func, 0x100> MakeTableF()
+{
+    auto t = Unused<0x100>();
+    t[0x07] = &chip8::OP_Fx07;
+    t[0x0A] = &chip8::OP_Fx0A;
+    t[0x15] = &chip8::OP_Fx15;
+    t[0x18] = &chip8::OP_Fx18;
+    t[0x1E] = &chip8::OP_Fx1E;
+    t[0x29] = &chip8::OP_Fx29;
+    t[0x33] = &chip8::OP_Fx33;
+    t[0x55] = &chip8::OP_Fx55;
+    t[0x65] = &chip8::OP_Fx65;
+    return t;
+}
+
+const std::array<chip8::chip8Func, 0x10> chip8::table = MakeTable();
+const std::array<chip8::chip8Func, 0x10> chip8::table0 = MakeTable0();
+const std::array<chip8::chip8Func, 0x10> chip8::table8 = MakeTable8();
+const std::array<chip8::chip8Func, 0x10> chip8::tableE = MakeTableE();
+const std::array<chip8::chip8Func, 0x100> chip8::tableF = MakeTableF();
+
+static constexpr uint64_t Mix(uint64_t h, uint64_t word)
+{
+    h ^= word;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 29);
+}
+
+// Little endian 64-bit load, usable at compile time (compilers turn it into one load)
+static constexpr uint64_t Load64(uint8_t const *bytes)
+{
+    uint64_t word = 0;
+    for (size_t i = 0; i < 8; ++i)
+    {
+        word |= uint64_t{bytes[i]} << (8 * i);
+    }
+    return word;
+}
+
+static constexpr uint64_t PageHash(size_t page, uint8_t const *bytes)
+{
+    uint64_t h = Mix(0x243F6A8885A308D3ull, page);
+    for (size_t i = 0; i < chip8::PAGE_SIZE; i += 8)
+    {
+        h = Mix(h, Load64(&bytes[i]));
+    }
+    return Mix(h, h >> 32);
+}
+
+// Power-on memory: zeroes with the font, and its memory_digest
+struct InitialImage
+{
+    uint8_t memory[chip8::MEM_SIZE];
+    uint64_t memory_digest;
+};
+
+static constexpr InitialImage MakeInitialImage()
+{
+    InitialImage image{};
+    for (size_t i = 0; i < sizeof(chip8::FONT_SET); ++i)
+    {
+        image.memory[chip8::FONT_START + i] = chip8::FONT_SET[i];
+    }
+    for (size_t page = 0; page < chip8::MEM_SIZE / chip8::PAGE_SIZE; ++page)
+    {
+        image.memory_digest ^= PageHash(page, &image.memory[page * chip8::PAGE_SIZE]);
+    }
+    return image;
+}
+
+static constexpr InitialImage INITIAL = MakeInitialImage();
+
+chip8::chip8(uint32_t seed)
+{
+    // random byte via rng
+    randByte = std::uniform_int_distribution<uint8_t>(0, 255U);
+    Reset(seed);
+}
+
+chip8::~chip8()
+{
+}
+
+void chip8::Reset(uint32_t seed)
+{
+    // Memory (font loaded) and its digest come from the compile time image
+    memcpy(memory, INITIAL.memory, sizeof(memory));
+    memory_digest = INITIAL.memory_digest;
+    dirty_pages = ~0u;
+
+    memset(v_registers, 0, sizeof(v_registers));
+    memset(stack, 0, sizeof(stack));
+    memset(keypad, 0, sizeof(keypad));
+    memset(video, 0, sizeof(video));
+    memset(video_rows, 0, sizeof(video_rows));
+    video_digest = 0;
+    sp = 0;
+    index = 0;
+    opcode = 0;
+    frame_cycle = 0;
+    cycles = 0;
+    frames = 0;
+    delay_timer = 0;
+    sound_timer = 0;
+
+    // Start Program
+    pc = DATA_START;
+
+    rng.seed(seed);
+    randByte.reset();
+}
+void chip8::rop()
+{
+    char text[32];
+    Disassembler::Format(opcode, text, sizeof(text));
+    // printf, not std::endl: no flush per instruction
+    printf("%03X  %04X  %s\n", (pc - 2) & MEM_END, opcode, text);
+}
+
+template <bool DIRECT>
+void chip8::Step()
+{
+    // Fetch, whichever is true. Combines bytes to make a 16 No *(uint16_t*)&memory[pc], ignores endianess
+    opcode = (memory[pc & MEM_END] << 8u) | memory[(pc + 1) & MEM_END];
+    
+    // Increment before exec.
+    pc += 2;
+
+    // Decode and Execute
+    if (DIRECT)
+    {
+        direct[opcode](*this);
+    }
+    else
+    {
+        ((*this).*(table[(opcode & 0xF000u) >> 12u]))();
+    }
+
+    // Decrement the delay timer if it's been set
+    if (delay_timer > 0)
+    {
+        --delay_timer;
+    }
+    // Decrement the sound timer if it's been set
+    if (sound_timer > 0)
+    {
+        --sound_timer;
+    }
+}
+
+void chip8::Cycle()
+{
+    if (dispatch == Dispatch::Direct)
+    {
+        Step<true>();
+        return;
+    }
+    Step<false>();
+}
+
+template <bool BREAK, bool WATCH, bool DRAW, bool FRAME, bool TRACE, bool DIRECT, bool KEY, bool VIP>
+chip8::RunResult chip8::RunLoop(uint64_t budget)
+{
+    uint64_t executed = 0;
+    while (executed < budget)
+    {
+        uint16_t at = pc;
+        uint16_t stored_at = index; // Fx55 under QUIRK_LOAD_STORE moves I past what it wrote
+        Step<DIRECT>();
+        ++executed;
+
+        if (TRACE)
+        {
+            trace->Record(at, opcode, index, v_registers[(opcode & 0x0F00u) >> 8u], v_registers[0xF]);
+        }
+
+        // Frame position is always kept so stopping on frames can be toggled between calls.
+        // The remainder is what a Vip frame overshot by (always 0 for Flat). A length <= 0 has
+        // no frames, as in Frame().
+        int frame_length = VIP ? cycles_per_frame : instructions_per_frame;
+        frame_cycle += VIP ? VipCost(at) : 1;
+        bool frame_end = frame_length > 0 && frame_cycle >= frame_length;
+        if (frame_end)
+        {
+            frame_cycle %= frame_length;
+            ++frames;
+        }
+        else if (frame_length <= 0)
+        {
+            frame_cycle = 0;
+        }
+
+        if (WATCH && (opcode & 0xF0FFu) == 0xF055u)
+        {
+            for (uint16_t i = 0; i <= ((opcode & 0x0F00u) >> 8u); ++i)
+            {
+                if (Test(watchpoints, stored_at + i))
+                {
+                    cycles += executed;
+                    return {StopReason::Watchpoint, static_cast<uint16_t>((stored_at + i) & MEM_END), executed};
+                }
+            }
+        }
+        if (WATCH && (opcode & 0xF0FFu) == 0xF033u)
+        {
+            for (uint16_t i = 0; i < 3; ++i)
+            {
+                if (Test(watchpoints, stored_at + i))
+                {
+                    cycles += executed;
+                    return {StopReason::Watchpoint, static_cast<uint16_t>((stored_at + i) & MEM_END), executed};
+                }
+            }
+        }
+        // Fx0A with no key held rewinds pc onto itself
+        if (KEY && (opcode & 0xF0FFu) == 0xF00Au && pc == at)
+        {
+            cycles += executed;
+            return {StopReason::KeyWait, at, executed};
+        }
+        if (DRAW && ((opcode & 0xF000u) == 0xD000u || opcode == 0x00E0u))
+        {
+            cycles += executed;
+            return {StopReason::Draw, pc, executed};
+        }
+        if (FRAME && frame_end)
+        {
+            cycles += executed;
+            return {StopReason::Frame, pc, executed};
+        }
+        if (BREAK && Test(breakpoints, pc))
+        {
+            cycles += executed;
+            return {StopReason::Breakpoint, pc, executed};
+        }
+    }
+    cycles += executed;
+    return {StopReason::Budget, pc, executed};
+}
+
+// Loop for mode bits break | watch << 1 | draw << 2 | frame << 3 | trace << 4 | direct << 5 | key << 6 |
+// vip << 7
+template <size_t... MODE>
+static constexpr auto MakeRunLoops(std::index_sequence<MODE...>)
+{
+    using Loop = chip8::RunResult (chip8::*)(uint64_t);
+    return std::array<Loop, sizeof...(MODE)>{
+        {&chip8::RunLoop<(MODE & 1u) != 0, (MODE & 2u) != 0, (MODE & 4u) != 0, (MODE & 8u) != 0, (MODE & 16u) != 0,
+                         (MODE & 32u) != 0, (MODE & 64u) != 0, (MODE & 128u) != 0>...}};
+}
+
+static constexpr auto RUN_LOOPS = MakeRunLoops(std::make_index_sequence<256>{});
+
+chip8::RunResult chip8::Run(uint64_t budget, uint32_t stop_on)
+{
+    unsigned mode = (breakpoint_count ? 1u : 0u) | (watchpoint_count ? 2u : 0u) |
+                    ((stop_on & STOP_DRAW) ? 4u : 0u) | ((stop_on & STOP_FRAME) ? 8u : 0u) |
+                    (trace ? 16u : 0u) | (dispatch == Dispatch::Direct ? 32u : 0u) |
+                    ((stop_on & STOP_KEY_WAIT) ? 64u : 0u) | (timing == Timing::Vip ? 128u : 0u);
+    return ((*this).*(RUN_LOOPS[mode]))(budget);
+}
+
+void chip8::Frame()
+{
+    bool vip = timing == Timing::Vip;
+    if ((vip ? cycles_per_frame : instructions_per_frame) <= 0)
+    {
+        return;
+    }
+    // Run's frame loops, without the breakpoint and watchpoint bits
+    unsigned mode = 8u | (trace ? 16u : 0u) | (dispatch == Dispatch::Direct ? 32u : 0u) | (vip ? 128u : 0u);
+    ((*this).*(RUN_LOOPS[mode]))(~0ull);
+}
+
+// COSMAC VIP-like costs in machine cycles: the interpreter's fetch and decode, then roughly what
+// its routine for the opcode takes. Taken skips pay for the extra branch, Dxyn pays per sprite
+// row and Fx55 / Fx65 per register. Approximate, what matters is that costs are fixed and ordered
+// like the real machine's (a sprite or a screen clear is worth many register ops).
+int chip8::VipCost(uint16_t at) const
+{
+    static constexpr int FETCH = 68;
+    bool skipped = pc == static_cast<uint16_t>(at + 4);
+    int x = (opcode & 0x0F00u) >> 8u;
+    switch (opcode >> 12u)
+    {
+    case 0x0:
+        return FETCH + (opcode == 0x00E0u ? 680 : 10);
+    case 0x1:
+        return FETCH + 12;
+    case 0x2:
+        return FETCH + 26;
+    case 0x3:
+    case 0x4:
+        return FETCH + 10 + (skipped ? 4 : 0);
+    case 0x5:
+    case 0x9:
+        return FETCH + 18 + (skipped ? 4 : 0);
+    case 0x6:
+        return FETCH + 6;
+    case 0x7:
+        return FETCH + 10;
+    case 0x8:
+        return FETCH + 44;
+    case 0xA:
+        return FETCH + 12;
+    case 0xB:
+        return FETCH + 22;
+    case 0xC:
+        return FETCH + 36;
+    case 0xD:
+        return FETCH + 26 + 46 * (opcode & 0x000Fu);
+    case 0xE:
+        return FETCH + 14 + (skipped ? 4 : 0);
+    default:
+        switch (opcode & 0x00FFu)
+        {
+        case 0x1E:
+        case 0x29:
+            return FETCH + 16;
+        case 0x33:
+            return FETCH + 84;
+        case 0x55:
+        case 0x65:
+            return FETCH + 14 + 14 * (x + 1);
+        default:
+            return FETCH + 10;
+        }
+    }
+}
+
+void chip8::Assign(uint64_t *bits, uint32_t &count, uint16_t address, bool enabled)
+{
+    address &= MEM_END;
+    uint64_t mask = 1ull << (address & 63u);
+    uint64_t &word = bits[address >> 6];
+    if (enabled && !(word & mask))
+    {
+        word |= mask;
+        ++count;
+    }
+    else if (!enabled && (word & mask))
+    {
+        word &= ~mask;
+        --count;
+    }
+}
+
+void chip8::SetBreakpoint(uint16_t address, bool enabled)
+{
+    Assign(breakpoints, breakpoint_count, address, enabled);
+}
+
+void chip8::SetWatchpoint(uint16_t start, uint16_t length, bool enabled)
+{
+    for (uint32_t i = 0; i < length; ++i)
+    {
+        Assign(watchpoints, watchpoint_count, start + i, enabled);
+    }
+}
+
+void chip8::ClearBreakpoints()
+{
+    memset(breakpoints, 0, sizeof(breakpoints));
+    breakpoint_count = 0;
+}
+
+void chip8::ClearWatchpoints()
+{
+    memset(watchpoints, 0, sizeof(watchpoints));
+    watchpoint_count = 0;
+}
+
+// Reads the ROM straight into chip8 memory/ram starting at DATA_START.
+size_t chip8::LoadROM(char const *filename)
+{
+    std::ifstream file(filename, std::ios::binary | std::ios::ate); // std::ios::ate sets to end of stream
+
+    if (!file.is_open())
+    {
+        std::clog << "Could not open file or no file is loaded!\n";
+        return 0;
+    }
+    std::streamoff size = file.tellg();
+    if (size <= 0 || size > DATA_END - DATA_START + 1)
+    {
+        std::clog << "ROM is empty or too large for memory!\n";
+        return 0;
+    }
+
+    file.seekg(0, std::ios::beg); // move file (ptr) to beginning of file.
+    uint8_t rom[DATA_END - DATA_START + 1];
+    file.read(reinterpret_cast<char *>(rom), size);
+    Store(DATA_START, rom, static_cast<size_t>(file.gcount()));
+    return static_cast<size_t>(file.gcount());
+}
+
+// Copies a ROM already in memory (embedders, tests) to DATA_START.
+size_t chip8::LoadROM(uint8_t const *data, size_t size)
+{
+    if (size > DATA_END - DATA_START + 1)
+    {
+        return 0;
+    }
+    Store(DATA_START, data, size);
+    return size;
+}
+
+// Collapses the 32bit pixels back to bits, for frontends that upload a palette-indexed plane.
+void chip8::PackVideo(uint8_t *out) const
+{
+    for (size_t i = 0; i < sizeof(Snapshot::video); ++i)
+    {
+        uint32_t bits = 0;
+        for (size_t bit = 0; bit < 8; ++bit)
+        {
+            bits |= (video[i * 8 + bit] != 0 ? 0x80u : 0u) >> bit;
+        }
+        out[i] = static_cast<uint8_t>(bits);
+    }
+}
+
+void chip8::Save(Snapshot &out) const
+{
+    memcpy(out.memory, memory, sizeof(memory));
+    memcpy(out.v_registers, v_registers, sizeof(v_registers));
+    memcpy(out.stack, stack, sizeof(stack));
+    out.pc = pc;
+    out.index = index;
+    out.opcode = opcode;
+    out.sp = sp;
+    out.delay_timer = delay_timer;
+    out.sound_timer = sound_timer;
+    memcpy(out.keypad, keypad, sizeof(keypad));
+    PackVideo(out.video);
+    out.rng = rng;
+    out.memory_digest = memory_digest;
+}
+
+void chip8::Restore(Snapshot const &in)
+{
+    memcpy(memory, in.memory, sizeof(memory));
+    memcpy(v_registers, in.v_registers, sizeof(v_registers));
+    memcpy(stack, in.stack, sizeof(stack));
+    pc = in.pc;
+    index = in.index;
+    opcode = in.opcode;
+    sp = in.sp;
+    delay_timer = in.delay_timer;
+    sound_timer = in.sound_timer;
+    memcpy(keypad, in.keypad, sizeof(keypad));
+    // Branch free so it vectorizes, Restore is on the search hot path
+    for (size_t i = 0; i < sizeof(in.video); ++i)
+    {
+        uint32_t bits = in.video[i]; // local copy, a uint8_t could alias video
+        for (size_t bit = 0; bit < 8; ++bit)
+        {
+            video[i * 8 + bit] = 0u - ((bits >> (7u - bit)) & 1u);
+        }
+    }
+    // Packed rows are already video_rows, MSB first
+    video_digest = 0;
+    for (size_t row = 0; row < DISPLAY_HEIGHT; ++row)
+    {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < DISPLAY_WIDTH / 8; ++i)
+        {
+            bits = (bits << 8u) | in.video[row * (DISPLAY_WIDTH / 8) + i];
+        }
+        video_rows[row] = bits;
+        video_digest ^= RowTerm(row, bits);
+    }
+    memory_digest = in.memory_digest;
+    dirty_pages = ~0u;
+    rng = in.rng;
+    randByte.reset();
+}
+
+void chip8::Save(PagedState &out)
+{
+    static_assert(PagedState::PAGES <= 32, "dirty_pages has one bit per page");
+    for (int page = 0; page < PagedState::PAGES; ++page)
+    {
+        if (!out.pages[page] || (dirty_pages >> page) & 1u)
+        {
+            out.Assign(page, &memory[page * PagedState::PAGE_SIZE]);
+        }
+    }
+    dirty_pages = 0;
+
+    memcpy(out.v_registers, v_registers, sizeof(v_registers));
+    memcpy(out.stack, stack, sizeof(stack));
+    out.pc = pc;
+    out.index = index;
+    out.opcode = opcode;
+    out.sp = sp;
+    out.delay_timer = delay_timer;
+    out.sound_timer = sound_timer;
+    memcpy(out.keypad, keypad, sizeof(keypad));
+    memcpy(out.video_rows, video_rows, sizeof(video_rows));
+    out.memory_digest = memory_digest;
+    out.video_digest = video_digest;
+    out.rng = rng;
+}
+
+void chip8::Restore(PagedState const &in, PagedState const *loaded)
+{
+    for (int page = 0; page < PagedState::PAGES; ++page)
+    {
+        if (!loaded || !in.Shares(*loaded, page) || (dirty_pages >> page) & 1u)
+        {
+            uint8_t *bytes = &memory[page * PagedState::PAGE_SIZE];
+            if (in.pages[page])
+                memcpy(bytes, in.pages[page]->bytes, PagedState::PAGE_SIZE);
+            else
+                memset(bytes, 0, PagedState::PAGE_SIZE);
+        }
+    }
+    dirty_pages = 0;
+
+    memcpy(v_registers, in.v_registers, sizeof(v_registers));
+    memcpy(stack, in.stack, sizeof(stack));
+    pc = in.pc;
+    index = in.index;
+    opcode = in.opcode;
+    sp = in.sp;
+    delay_timer = in.delay_timer;
+    sound_timer = in.sound_timer;
+    memcpy(keypad, in.keypad, sizeof(keypad));
+    // Only rows that differ are expanded back to 32bit pixels
+    for (size_t row = 0; row < DISPLAY_HEIGHT; ++row)
+    {
+        uint64_t bits = in.video_rows[row];
+        if (bits == video_rows[row])
+        {
+            continue;
+        }
+        video_rows[row] = bits;
+        for (size_t x = 0; x < DISPLAY_WIDTH; ++x)
+        {
+            video[row * DISPLAY_WIDTH + x] = 0u - static_cast<uint32_t>((bits >> (63u - x)) & 1u);
+        }
+    }
+    memory_digest = in.memory_digest;
+    video_digest = in.video_digest;
+    rng = in.rng;
+    randByte.reset();
+}
+
+uint64_t chip8::PageTerm(size_t page, uint8_t const *bytes)
+{
+    return PageHash(page, bytes);
+}
+
+void chip8::Store(uint16_t address, uint8_t const *data, size_t size)
+{
+    size_t first = (address & MEM_END) / PAGE_SIZE;
+    size_t pages = size ? ((address & MEM_END) + size - 1) / PAGE_SIZE - first + 1 : 0;
+    for (size_t i = 0; i < pages && i < MEM_SIZE / PAGE_SIZE; ++i)
+    {
+        size_t page = (first + i) % (MEM_SIZE / PAGE_SIZE);
+        memory_digest ^= PageTerm(page, &memory[page * PAGE_SIZE]);
+    }
+    for (size_t i = 0; i < size; ++i)
+    {
+        memory[(address + i) & MEM_END] = data[i];
+    }
+    for (size_t i = 0; i < pages && i < MEM_SIZE / PAGE_SIZE; ++i)
+    {
+        size_t page = (first + i) % (MEM_SIZE / PAGE_SIZE);
+        memory_digest ^= PageTerm(page, &memory[page * PAGE_SIZE]);
+        dirty_pages |= 1u << (page * PAGE_SIZE / PagedState::PAGE_SIZE);
+    }
+}
+
+// Empty rows contribute nothing, so clearing the screen just zeroes video_digest
+uint64_t chip8::RowTerm(size_t row, uint64_t bits)
+{
+    uint64_t h = Mix(Mix(0x13198A2E03707344ull, row), bits);
+    return bits ? Mix(h, h >> 32) : 0;
+}
+
+void chip8::FlipPages(uint16_t first, uint16_t last)
+{
+    size_t a = (first & MEM_END) / PAGE_SIZE;
+    size_t b = (last & MEM_END) / PAGE_SIZE;
+    memory_digest ^= PageTerm(a, &memory[a * PAGE_SIZE]);
+    if (b != a)
+    {
+        memory_digest ^= PageTerm(b, &memory[b * PAGE_SIZE]);
+    }
+    dirty_pages |= (1u << ((first & MEM_END) / PagedState::PAGE_SIZE)) | (1u << ((last & MEM_END) / PagedState::PAGE_SIZE));
+}
+
+void chip8::Rehash()
+{
+    dirty_pages = ~0u;
+    memory_digest = 0;
+    for (size_t page = 0; page < MEM_SIZE / PAGE_SIZE; ++page)
+    {
+        memory_digest ^= PageTerm(page, &memory[page * PAGE_SIZE]);
+    }
+
+    video_digest = 0;
+    for (size_t row = 0; row < DISPLAY_HEIGHT; ++row)
+    {
+        uint64_t bits = 0;
+        for (size_t x = 0; x < DISPLAY_WIDTH; ++x)
+        {
+            bits = (bits << 1u) | (video[row * DISPLAY_WIDTH + x] ? 1u : 0u);
+        }
+        video_rows[row] = bits;
+        video_digest ^= RowTerm(row, bits);
+    }
+}
+
+uint64_t chip8::Hash() const
+{
+    uint64_t h = Mix(memory_digest, uint64_t{pc} | uint64_t{index} << 16u | uint64_t{sp} << 32u |
+                                        uint64_t{delay_timer} << 40u | uint64_t{sound_timer} << 48u);
+    for (size_t i = 0; i < sizeof(v_registers); i += 8)
+    {
+        uint64_t word;
+        memcpy(&word, &v_registers[i], sizeof(word));
+        h = Mix(h, word);
+    }
+    for (size_t i = 0; i < REGISTER_STACK_SIZE; i += 4)
+    {
+        uint64_t word;
+        memcpy(&word, &stack[i], sizeof(word));
+        h = Mix(h, word);
+    }
+    return Mix(h, h >> 32);
+}
+
+uint64_t chip8::Digest() const
+{
+    return Mix(Hash(), video_digest);
+}
+
+// OP CLS, clear screen.
+void chip8::OP_00E0()
+{
+    memset(video, 0, sizeof(video));
+    memset(video_rows, 0, sizeof(video_rows));
+    video_digest = 0;
+}
+
+// OP RET, return from sub-routine.
+void chip8::OP_00EE()
+{
+    sp = (sp - 1) & (REGISTER_STACK_SIZE - 1); // wraps instead of underflowing
+    pc = stack[sp];
+}
+
+// OP JP addr, jump to address nnn via bitmask.
+void chip8::OP_1nnn()
+{
+    // assign the program counter to the lower 12 bits
+    pc = opcode & 0x0FFFu;
+    // NNN = 0000 1111 1111 11111 -> ()0000 (N)ibble (N)ibble (N)ibble
+}
+
+// OP CALL addr, call subroutine and return.
+void chip8::OP_2nnn()
+{
+    stack[sp & (REGISTER_STACK_SIZE - 1)] = pc; // Push current pc before JP
+    sp = (sp + 1) & (REGISTER_STACK_SIZE - 1);  // Move sp up, for 00EE, wraps instead of overflowing
+    pc = opcode & 0x0FFFu;
+}
+
+// OP SE Vx, kk. Skip(3) if Vx[x] == kk. Where kk -> 0000 0000 1111 1111, an 8bit/byte immediate value
+void chip8::OP_3xkk()
+{
+    // uint8_t x = (opcode & 0x0F00u) >> 8u;
+    // uint8_t kk = opcode & 0x00FFu;
+    bool skip = v_registers[(opcode & 0x0F00u) >> 8u] == (opcode & 0x00FFu);
+    if (!skip)
+        return;
+    pc += 2;
+}
+
+// OP SNE Vx, kk. Skip(4) if Vx[x] != kk. Opposite, similar, to OP_3xkk.
+void chip8::OP_4xkk()
+{
+    // uint8_t x = (opcode & 0x0F00u) >> 8u;
+    // uint8_t kk = opcode & 0x00FFu;
+    bool skip = v_registers[(opcode & 0x0F00u) >> 8u] != (opcode & 0x00FFu);
+    if (!skip)
+        return;
+    pc += 2;
+}
+
+// 0000 0000 0000 0000
+//      x    y
+// OP SE Vx, Vy. Skip if Vx = Vy
+void chip8::OP_5xy0()
+{
+    // uint8_t x = (opcode & 0x0F00u) >> 8u; // Vx
+    // uint8_t y = (opcode & 0x00F0u) >> 4u; // Vy
+    bool skip = v_registers[(opcode & 0x0F00u) >> 8u] == v_registers[(opcode & 0x00F0u) >> 4u];
+    if (!skip)
+        return;
+    pc += 2;
+}
+
+// OP LD Vx, kk
+void chip8::OP_6xkk()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] = (opcode & 0x00FFu);
+}
+
+// OP ADD Vx, kk
+void chip8::OP_7xkk()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] += (opcode & 0x00FFu);
+}
+
+// OP LD Vx, Vy
+void chip8::OP_8xy0()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] = v_registers[(opcode & 0x00F0u) >> 4u];
+}
+
+// OP OR Vx, Vy
+void chip8::OP_8xy1()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] |= v_registers[(opcode & 0x00F0u) >> 4u];
+    if (quirks & QUIRK_VF_RESET)
+        v_registers[0xF] = 0;
+}
+
+// OP AND Vx, Vy
+void chip8::OP_8xy2()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] &= v_registers[(opcode & 0x00F0u) >> 4u];
+    if (quirks & QUIRK_VF_RESET)
+        v_registers[0xF] = 0;
+}
+
+// OP XOR Vx, Vy
+void chip8::OP_8xy3()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] ^= v_registers[(opcode & 0x00F0u) >> 4u];
+    if (quirks & QUIRK_VF_RESET)
+        v_registers[0xF] = 0;
+}
+
+// OP ADD Vx, Vy. VF = carry.
+void chip8::OP_8xy4()
+{
+    // Vx, mask out x and shift to make it 8 bit 0000 0000 0000 0000
+    uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+    uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+    // uint8_t Vf = 0xF;
+
+    uint16_t sum = v_registers[Vx] + v_registers[Vy];
+
+    // Keep only lowest 8 bits, big-endian. 0000 0000 xxxx xxxx & 1111 1111 -> xxxx xxxx
+    v_registers[Vx] = sum & 0xFFu;
+
+    // If sum is too big / >byte, set Vf to 1, else 0. Remember VF is a special flag!
+    // Written last so it wins when x is F.
+    v_registers[0xF] = (sum > 255U) ? 1 : 0;
+}
+
+// // OP SUB Vx, Vy
+void chip8::OP_8xy5()
+{
+    uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+    uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+    // uint8_t Vf = 0xF;
+
+    // NOT borrow, compares the register values. Equal values don't borrow.
+    uint8_t flag = (v_registers[Vx] >= v_registers[Vy]) ? 1 : 0;
+
+    v_registers[Vx] -= v_registers[Vy];
+    v_registers[0xF] = flag;
+}
+
+// OP SHR Vx, Vy. If the least-significant bit of Vx is 1, then VF is set to 1, otherwise 0. Then Vx is divided by 2.
+void chip8::OP_8xy6()
+{
+    // careful of legacy, quirk behavior for tests
+    uint8_t x = (opcode & 0x0F00u) >> 8u;
+    uint8_t y = (quirks & QUIRK_SHIFT) ? x : (opcode & 0x00F0u) >> 4u;
+    uint8_t flag = v_registers[y] & 0x1u;
+    v_registers[x] = v_registers[y] >> 1;
+    v_registers[0xF] = flag;
+}
+
+// OP SUBN Vx, Vy. Set Vx = Vy - Vx, set VF = NOT borrow.
+void chip8::OP_8xy7()
+{
+    uint8_t Vx = (opcode & 0x0F00u) >> 8u;
+    uint8_t Vy = (opcode & 0x00F0u) >> 4u;
+    uint8_t flag = (v_registers[Vy] >= v_registers[Vx]) ? 1 : 0;
+    v_registers[Vx] = v_registers[Vy] - v_registers[Vx];
+    v_registers[0xF] = flag;
+}
+
+// OP SHL Vx, {, Vy}. Vx = Vx SHL 1, Shift left. Similar to OP_SHR
+void chip8::OP_8xyE()
+{
+    // careful about legacy, quirk behavior for tests
+    uint8_t x = (opcode & 0x0F00u) >> 8u;
+    uint8_t y = (quirks & QUIRK_SHIFT) ? x : (opcode & 0x00F0u) >> 4u;
+
+    // MSB of Vy
+    uint8_t flag = (v_registers[y] & 0x80u) >> 7u;
+
+    // Shift Vy left and store result in Vx, then the flag
+    v_registers[x] = v_registers[y] << 1;
+    v_registers[0xF] = flag;
+}
+
+// OP SNE Vx, Vy. Skip next instruction if Vx != Vy
+void chip8::OP_9xy0()
+{
+    bool skip = v_registers[(opcode & 0x0F00u) >> 8u] != v_registers[(opcode & 0x00F0u) >> 4u];
+    if (!skip)
+        return;
+    pc += 2;
+}
+
+// OP LD I, addr. Set I = nnn
+void chip8::OP_Annn()
+{
+    chip8::index = opcode & 0x0FFFu;
+}
+
+// OP JP V0, addr. Jump to nnn + V0
+void chip8::OP_Bnnn()
+{
+    uint8_t x = (quirks & QUIRK_JUMP) ? (opcode & 0x0F00u) >> 8u : 0;
+    pc = v_registers[x] + (opcode & 0x0FFFu);
+}
+
+// OP RND Vx, byte. Set Vx to a random byte AND kk
+void chip8::OP_Cxkk()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] = randByte(chip8::rng) & (opcode & 0x00FFu);
+}
+
+// OP DRW Vx, Vy, nibble. Draw Sprite (starting from I) at (Vx, Vy), n = height, VF = collision
+void chip8::OP_Dxyn()
+{
+    Sprite((opcode & 0x0F00u) >> 8u, (opcode & 0x00F0u) >> 4u, opcode & 0x000Fu);
+}
+
+// Vx, Vy are register numbers, height is n
+void chip8::Sprite(uint8_t Vx, uint8_t Vy, uint8_t height)
+{
+    uint8_t x_pos = v_registers[Vx] % DISPLAY_WIDTH;
+    uint8_t y_pos = v_registers[Vy] % DISPLAY_HEIGHT;
+
+    v_registers[0xF] = 0; // Initialize VF, collision
+
+    // The start position wraps, the sprite itself is clipped at the right and bottom edges
+    // (or wraps too with QUIRK_WRAP).
+    bool wrap = quirks & QUIRK_WRAP;
+    for (size_t row = 0; row < height && (wrap || y_pos + row < DISPLAY_HEIGHT); ++row)
+    {
+        uint8_t sprite_b = chip8::memory[(chip8::index + row) & MEM_END];
+        size_t y = (y_pos + row) % DISPLAY_HEIGHT;
+
+        // Shifting out past bit 0 is the same clipping as below, wrapping rotates instead
+        uint64_t line = uint64_t{sprite_b} << 56u;
+        uint64_t &bits = video_rows[y];
+        video_digest ^= RowTerm(y, bits);
+        bits ^= (line >> x_pos) | (wrap && x_pos ? line << (64u - x_pos) : 0u);
+        video_digest ^= RowTerm(y, bits);
+
+        for (size_t col = 0; col < 8 && (wrap || x_pos + col < DISPLAY_WIDTH); ++col)
+        {
+            uint8_t spritePixel = sprite_b & (0x80 >> col);
+            uint32_t *screenPx = &video[y * DISPLAY_WIDTH + (x_pos + col) % DISPLAY_WIDTH];
+
+            if (spritePixel)
+            {
+                if (*screenPx == 0xFFFFFFFF)
+                    v_registers[0xF] = 1;
+
+                *screenPx ^= 0xFFFFFFFF;
+            }
+        }
+    }
+}
+
+// OP Ex9E - SKP Vx, skip next instruction if keypad presses Vx
+void chip8::OP_Ex9E()
+{
+    bool skip = keypad[v_registers[(opcode & 0x0F00u) >> 8u] & 0xFu];
+    if (!skip)
+        return;
+    pc += 2;
+}
+
+// ExA1 - SKNP Vx, skip next instruction if Vx not pressed
+void chip8::OP_ExA1()
+{
+    if (keypad[v_registers[(opcode & 0x0F00u) >> 8u] & 0xFu])
+        return;
+    pc += 2;
+}
+
+// LD Vx, DT, Vx = delay timer
+void chip8::OP_Fx07()
+{
+    v_registers[(opcode & 0x0F00u) >> 8u] = delay_timer;
+}
+
+// LD Vx, K. Wait for keypress and store in Vx
+void chip8::OP_Fx0A()
+{
+    for (size_t key = 0; key < 16; ++key)
+    {
+        if (keypad[key])
+        {
+            v_registers[(opcode & 0x0F00u) >> 8u] = key;
+            return;
+        }
+    }
+    pc -= 2;
+}
+
+// LD DT, Vx
+void chip8::OP_Fx15()
+{
+    delay_timer = v_registers[(opcode & 0x0F00u) >> 8u];
+}
+
+// LD ST = Vx
+void chip8::OP_Fx18()
+{
+    sound_timer = v_registers[(opcode & 0x0F00u) >> 8u];
+}
+
+// ADD I, VX
+void chip8::OP_Fx1E()
+{
+    index = index + v_registers[(opcode & 0x0F00u) >> 8u];
+}
+
+// LF F, Vx
+void chip8::OP_Fx29()
+{
+    uint8_t digit = v_registers[(opcode & 0x0F00u) >> 8u];
+    index = FONT_START + (5 * digit);
+}
+
+// LD B, Vx B => Binary-Codede Decimal.  (floats truncated)
+void chip8::OP_Fx33()
+{
+    uint8_t val = v_registers[(opcode & 0x0F00u) >> 8u];
+    FlipPages(index, index + 2);
+    // 100s
+    memory[index & MEM_END] = (val/100) % 10;
+    // 10s
+    memory[(index + 1) & MEM_END] = (val / 10) % 10;
+    // 1s
+    memory[(index + 2) & MEM_END] = val % 10;
+    FlipPages(index, index + 2);
+}
+
+// LD [I], Vx, store/write V0 through Vx in memory starting from I
+void chip8::OP_Fx55()
+{
+    uint16_t last = index + ((opcode & 0x0F00u) >> 8u);
+    FlipPages(index, last);
+    for (size_t i = 0; i <= ((opcode & 0x0F00u) >> 8u); ++i)
+    {
+        memory[(index + i) & MEM_END] = v_registers[i];
+    }
+    FlipPages(index, last);
+    if (quirks & QUIRK_LOAD_STORE)
+        index = last + 1;
+}
+
+// LD Vx, [I], read V0 through Vx
+void chip8::OP_Fx65()
+{
+    for (size_t i = 0; i <= ((opcode & 0x0F00u) >> 8u); ++i)
+    {
+        v_registers[i] = memory[(index + i) & MEM_END];
+    }
+    if (quirks & QUIRK_LOAD_STORE)
+        index += ((opcode & 0x0F00u) >> 8u) + 1;
+}
+void chip8::OP_NULL() {
+    // implementation (could be empty)
+}
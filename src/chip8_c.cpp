@@ -0,0 +1,148 @@
+#include "chip8_c.h"
+#include "chip8.h"
+
+#include <new>
+
+// chip8_vm is never defined, handles are chip8 objects placed in host memory.
+static chip8 *Unwrap(chip8_vm *vm)
+{
+    return reinterpret_cast<chip8 *>(vm);
+}
+
+static chip8 const *Unwrap(chip8_vm const *vm)
+{
+    return reinterpret_cast<chip8 const *>(vm);
+}
+
+size_t chip8_vm_size(void)
+{
+    return sizeof(chip8);
+}
+
+size_t chip8_vm_align(void)
+{
+    return alignof(chip8);
+}
+
+chip8_vm *chip8_create(void *mem, size_t size, uint32_t seed)
+{
+    if (!mem || size < sizeof(chip8) || reinterpret_cast<uintptr_t>(mem) % alignof(chip8) != 0)
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<chip8_vm *>(new (mem) chip8(seed));
+}
+
+void chip8_destroy(chip8_vm *vm)
+{
+    if (vm)
+    {
+        Unwrap(vm)->~chip8();
+    }
+}
+
+void chip8_reset(chip8_vm *vm, uint32_t seed)
+{
+    Unwrap(vm)->Reset(seed);
+}
+
+int chip8_load(chip8_vm *vm, uint8_t const *rom, size_t size)
+{
+    return (size > 0 && Unwrap(vm)->LoadROM(rom, size) == size) ? 0 : -1;
+}
+
+void chip8_step(chip8_vm *vm, uint32_t instructions)
+{
+    chip8 *c = Unwrap(vm);
+    for (uint32_t i = 0; i < instructions; ++i)
+    {
+        c->Cycle();
+    }
+}
+
+void chip8_step_frame(chip8_vm *vm)
+{
+    Unwrap(vm)->Frame();
+}
+
+void chip8_set_instructions_per_frame(chip8_vm *vm, int instructions)
+{
+    Unwrap(vm)->instructions_per_frame = instructions < 1 ? 1 : instructions;
+}
+
+void chip8_set_timing(chip8_vm *vm, int timing, int cycles_per_frame)
+{
+    chip8 *c = Unwrap(vm);
+    c->timing = timing == CHIP8_TIMING_VIP ? chip8::Timing::Vip : chip8::Timing::Flat;
+    if (cycles_per_frame > 0)
+    {
+        c->cycles_per_frame = cycles_per_frame;
+    }
+}
+
+int chip8_run(chip8_vm *vm, uint64_t budget, uint32_t stop_on, uint64_t *executed, uint16_t *address)
+{
+    chip8::RunResult result = Unwrap(vm)->Run(budget, stop_on);
+    if (executed)
+    {
+        *executed = result.executed;
+    }
+    if (address)
+    {
+        *address = result.address;
+    }
+    return static_cast<int>(result.reason);
+}
+
+void chip8_set_breakpoint(chip8_vm *vm, uint16_t address, int enabled)
+{
+    Unwrap(vm)->SetBreakpoint(address, enabled != 0);
+}
+
+void chip8_set_watchpoint(chip8_vm *vm, uint16_t start, uint16_t length, int enabled)
+{
+    Unwrap(vm)->SetWatchpoint(start, length, enabled != 0);
+}
+
+void chip8_set_key(chip8_vm *vm, int key, int pressed)
+{
+    Unwrap(vm)->keypad[key & 0xF] = pressed ? 1 : 0;
+}
+
+size_t chip8_snapshot_size(void)
+{
+    return sizeof(chip8::Snapshot);
+}
+
+void chip8_snapshot(chip8_vm const *vm, void *out)
+{
+    Unwrap(vm)->Save(*static_cast<chip8::Snapshot *>(out));
+}
+
+void chip8_restore(chip8_vm *vm, void const *in)
+{
+    Unwrap(vm)->Restore(*static_cast<chip8::Snapshot const *>(in));
+}
+
+uint64_t chip8_digest(chip8_vm const *vm)
+{
+    return Unwrap(vm)->Digest();
+}
+
+uint32_t const *chip8_framebuffer(chip8_vm const *vm)
+{
+    return Unwrap(vm)->video;
+}
+
+void chip8_framebuffer_packed(chip8_vm const *vm, uint8_t *out)
+{
+    Unwrap(vm)->PackVideo(out);
+}
+
+static_assert(CHIP8_STOP_BREAKPOINT == static_cast<int>(chip8::StopReason::Breakpoint), "C and C++ stop reasons must match");
+static_assert(CHIP8_STOP_DRAW == static_cast<int>(chip8::StopReason::Draw), "C and C++ stop reasons must match");
+static_assert(CHIP8_STOP_KEY_WAIT == static_cast<int>(chip8::StopReason::KeyWait), "C and C++ stop reasons must match");
+static_assert(uint32_t{CHIP8_ON_DRAW} == chip8::STOP_DRAW && uint32_t{CHIP8_ON_FRAME} == chip8::STOP_FRAME &&
+                  uint32_t{CHIP8_ON_KEY_WAIT} == chip8::STOP_KEY_WAIT,
+              "C and C++ stop flags must match");
+static_assert(CHIP8_TIMING_VIP == static_cast<int>(chip8::Timing::Vip), "C and C++ timing modes must match");
@@ -0,0 +1,114 @@
+#include "disassembler.h"
+
+#include <cstdio>
+
+namespace
+{
+    // Which opcode fields the format string consumes, in order.
+    enum Operands
+    {
+        NONE,
+        NNN,
+        X_KK,
+        X_Y,
+        X,
+        X_Y_N
+    };
+
+    struct Row
+    {
+        uint16_t mask;
+        uint16_t match;
+        char const *handler;
+        char const *format;
+        Operands operands;
+    };
+
+    // Same coverage as chip8's dispatch tables, first match wins. Like the tables, 5xyN and 9xyN
+    // ignore N.
+    constexpr Row ROWS[] = {
+        {0xFFFF, 0x00E0, "OP_00E0", "CLS", NONE},
+        {0xFFFF, 0x00EE, "OP_00EE", "RET", NONE},
+        {0xF000, 0x1000, "OP_1nnn", "JP 0x%03X", NNN},
+        {0xF000, 0x2000, "OP_2nnn", "CALL 0x%03X", NNN},
+        {0xF000, 0x3000, "OP_3xkk", "SE V%X, 0x%02X", X_KK},
+        {0xF000, 0x4000, "OP_4xkk", "SNE V%X, 0x%02X", X_KK},
+        {0xF000, 0x5000, "OP_5xy0", "SE V%X, V%X", X_Y},
+        {0xF000, 0x6000, "OP_6xkk", "LD V%X, 0x%02X", X_KK},
+        {0xF000, 0x7000, "OP_7xkk", "ADD V%X, 0x%02X", X_KK},
+        {0xF00F, 0x8000, "OP_8xy0", "LD V%X, V%X", X_Y},
+        {0xF00F, 0x8001, "OP_8xy1", "OR V%X, V%X", X_Y},
+        {0xF00F, 0x8002, "OP_8xy2", "AND V%X, V%X", X_Y},
+        {0xF00F, 0x8003, "OP_8xy3", "XOR V%X, V%X", X_Y},
+        {0xF00F, 0x8004, "OP_8xy4", "ADD V%X, V%X", X_Y},
+        {0xF00F, 0x8005, "OP_8xy5", "SUB V%X, V%X", X_Y},
+        {0xF00F, 0x8006, "OP_8xy6", "SHR V%X, V%X", X_Y},
+        {0xF00F, 0x8007, "OP_8xy7", "SUBN V%X, V%X", X_Y},
+        {0xF00F, 0x800E, "OP_8xyE", "SHL V%X, V%X", X_Y},
+        {0xF000, 0x9000, "OP_9xy0", "SNE V%X, V%X", X_Y},
+        {0xF000, 0xA000, "OP_Annn", "LD I, 0x%03X", NNN},
+        {0xF000, 0xB000, "OP_Bnnn", "JP V0, 0x%03X", NNN},
+        {0xF000, 0xC000, "OP_Cxkk", "RND V%X, 0x%02X", X_KK},
+        {0xF000, 0xD000, "OP_Dxyn", "DRW V%X, V%X, %u", X_Y_N},
+        {0xF0FF, 0xE09E, "OP_Ex9E", "SKP V%X", X},
+        {0xF0FF, 0xE0A1, "OP_ExA1", "SKNP V%X", X},
+        {0xF0FF, 0xF007, "OP_Fx07", "LD V%X, DT", X},
+        {0xF0FF, 0xF00A, "OP_Fx0A", "LD V%X, K", X},
+        {0xF0FF, 0xF015, "OP_Fx15", "LD DT, V%X", X},
+        {0xF0FF, 0xF018, "OP_Fx18", "LD ST, V%X", X},
+        {0xF0FF, 0xF01E, "OP_Fx1E", "ADD I, V%X", X},
+        {0xF0FF, 0xF029, "OP_Fx29", "LD F, V%X", X},
+        {0xF0FF, 0xF033, "OP_Fx33", "LD B, V%X", X},
+        {0xF0FF, 0xF055, "OP_Fx55", "LD [I], V%X", X},
+        {0xF0FF, 0xF065, "OP_Fx65", "LD V%X, [I]", X},
+    };
+
+    Row const *Find(uint16_t opcode)
+    {
+        for (Row const &row : ROWS)
+        {
+            if ((opcode & row.mask) == row.match)
+            {
+                return &row;
+            }
+        }
+        return nullptr;
+    }
+}
+
+void Disassembler::Format(uint16_t opcode, char *out, size_t size)
+{
+    if (size == 0)
+    {
+        return;
+    }
+
+    Row const *row = Find(opcode);
+    if (!row)
+    {
+        snprintf(out, size, "DW 0x%04X", opcode);
+        return;
+    }
+
+    unsigned x = (opcode & 0x0F00u) >> 8u;
+    unsigned y = (opcode & 0x00F0u) >> 4u;
+    unsigned n = opcode & 0x000Fu;
+    unsigned kk = opcode & 0x00FFu;
+    unsigned nnn = opcode & 0x0FFFu;
+
+    switch (row->operands)
+    {
+        case NONE: snprintf(out, size, "%s", row->format); break;
+        case NNN: snprintf(out, size, row->format, nnn); break;
+        case X_KK: snprintf(out, size, row->format, x, kk); break;
+        case X_Y: snprintf(out, size, row->format, x, y); break;
+        case X: snprintf(out, size, row->format, x); break;
+        case X_Y_N: snprintf(out, size, row->format, x, y, n); break;
+    }
+}
+
+char const *Disassembler::Handler(uint16_t opcode)
+{
+    Row const *row = Find(opcode);
+    return row ? row->handler : "OP_NULL";
+}
@@ -0,0 +1,272 @@
+// Dispatch::Direct, one handler per opcode value with x, y, n, kk and nnn as constants, so executing
+// an instruction is the fetch and one indirect call. Kept in its own translation unit since it
+// instantiates ~50000 handlers; everything else about the core stays in chip8.cpp. Each handler
+// must behave exactly like the table path (tests/test_dispatch.cpp runs both over every opcode),
+// including the table quirks: 5xyN and 9xyN ignore N, 8xy6 / 8xyE shift Vy. The configurable
+// quirks (chip8::quirks) are tested at run time, like the table handlers do.
+//
+// Building the handlers takes minutes and adds megabytes of code, so it is opt-in: make DIRECT=1
+// defines CHIP8_DIRECT_DISPATCH. Otherwise every entry is DirectTables and Direct behaves (and is
+// tested) exactly like Tables.
+#include "chip8.h"
+
+#include <cstring>
+#include <utility>
+
+void chip8::DirectNULL(chip8 &)
+{
+}
+
+void chip8::DirectTables(chip8 &c)
+{
+    (c.*(table[(c.opcode & 0xF000u) >> 12u]))();
+}
+
+#ifdef CHIP8_DIRECT_DISPATCH
+const bool chip8::direct_compiled = true;
+
+// Whether the tables give OP a handler other than OP_NULL
+static constexpr bool Valid(uint16_t op)
+{
+    switch (op >> 12)
+    {
+    case 0x0:
+        return op == 0x00E0u || op == 0x00EEu;
+    case 0x8:
+        return (op & 0xFu) <= 0x7u || (op & 0xFu) == 0xEu;
+    case 0xE:
+        return (op & 0xFFu) == 0x9Eu || (op & 0xFFu) == 0xA1u;
+    case 0xF:
+        switch (op & 0xFFu)
+        {
+        case 0x07: case 0x0A: case 0x15: case 0x18: case 0x1E:
+        case 0x29: case 0x33: case 0x55: case 0x65:
+            return true;
+        default:
+            return false;
+        }
+    default:
+        return true;
+    }
+}
+
+template <uint16_t OP>
+void chip8::Direct(chip8 &c)
+{
+    constexpr uint16_t nnn = OP & 0x0FFFu;
+    constexpr uint8_t x = (OP & 0x0F00u) >> 8u;
+    constexpr uint8_t y = (OP & 0x00F0u) >> 4u;
+    constexpr uint8_t n = OP & 0x000Fu;
+    constexpr uint8_t kk = OP & 0x00FFu;
+    uint8_t *v = c.v_registers;
+
+    if constexpr (OP == 0x00E0u)
+    {
+        c.OP_00E0();
+    }
+    else if constexpr (OP == 0x00EEu)
+    {
+        c.sp = (c.sp - 1) & (REGISTER_STACK_SIZE - 1);
+        c.pc = c.stack[c.sp];
+    }
+    else if constexpr ((OP >> 12) == 0x1)
+    {
+        c.pc = nnn;
+    }
+    else if constexpr ((OP >> 12) == 0x2)
+    {
+        c.stack[c.sp & (REGISTER_STACK_SIZE - 1)] = c.pc;
+        c.sp = (c.sp + 1) & (REGISTER_STACK_SIZE - 1);
+        c.pc = nnn;
+    }
+    else if constexpr ((OP >> 12) == 0x3)
+    {
+        c.pc += v[x] == kk ? 2 : 0;
+    }
+    else if constexpr ((OP >> 12) == 0x4)
+    {
+        c.pc += v[x] != kk ? 2 : 0;
+    }
+    else if constexpr ((OP >> 12) == 0x5)
+    {
+        c.pc += v[x] == v[y] ? 2 : 0;
+    }
+    else if constexpr ((OP >> 12) == 0x6)
+    {
+        v[x] = kk;
+    }
+    else if constexpr ((OP >> 12) == 0x7)
+    {
+        v[x] += kk;
+    }
+    else if constexpr ((OP >> 12) == 0x8)
+    {
+        if constexpr (n == 0x0)
+        {
+            v[x] = v[y];
+        }
+        else if constexpr (n == 0x1)
+        {
+            v[x] |= v[y];
+            if (c.quirks & QUIRK_VF_RESET)
+                v[0xF] = 0;
+        }
+        else if constexpr (n == 0x2)
+        {
+            v[x] &= v[y];
+            if (c.quirks & QUIRK_VF_RESET)
+                v[0xF] = 0;
+        }
+        else if constexpr (n == 0x3)
+        {
+            v[x] ^= v[y];
+            if (c.quirks & QUIRK_VF_RESET)
+                v[0xF] = 0;
+        }
+        else if constexpr (n == 0x4)
+        {
+            uint16_t sum = v[x] + v[y];
+            v[x] = sum & 0xFFu;
+            v[0xF] = sum > 255u ? 1 : 0;
+        }
+        else if constexpr (n == 0x5)
+        {
+            uint8_t flag = v[x] >= v[y] ? 1 : 0;
+            v[x] -= v[y];
+            v[0xF] = flag;
+        }
+        else if constexpr (n == 0x6)
+        {
+            uint8_t source = v[c.quirks & QUIRK_SHIFT ? x : y];
+            v[x] = source >> 1;
+            v[0xF] = source & 0x1u;
+        }
+        else if constexpr (n == 0x7)
+        {
+            uint8_t flag = v[y] >= v[x] ? 1 : 0;
+            v[x] = v[y] - v[x];
+            v[0xF] = flag;
+        }
+        else
+        {
+            uint8_t source = v[c.quirks & QUIRK_SHIFT ? x : y];
+            v[x] = source << 1;
+            v[0xF] = (source & 0x80u) >> 7u;
+        }
+    }
+    else if constexpr ((OP >> 12) == 0x9)
+    {
+        c.pc += v[x] != v[y] ? 2 : 0;
+    }
+    else if constexpr ((OP >> 12) == 0xA)
+    {
+        c.index = nnn;
+    }
+    else if constexpr ((OP >> 12) == 0xB)
+    {
+        c.pc = v[c.quirks & QUIRK_JUMP ? x : 0] + nnn;
+    }
+    else if constexpr ((OP >> 12) == 0xC)
+    {
+        v[x] = c.randByte(c.rng) & kk;
+    }
+    else if constexpr ((OP >> 12) == 0xD)
+    {
+        c.Sprite(x, y, n);
+    }
+    else if constexpr (kk == 0x9E)
+    {
+        c.pc += c.keypad[v[x] & 0xFu] ? 2 : 0;
+    }
+    else if constexpr (kk == 0xA1)
+    {
+        c.pc += c.keypad[v[x] & 0xFu] ? 0 : 2;
+    }
+    else if constexpr (kk == 0x07)
+    {
+        v[x] = c.delay_timer;
+    }
+    else if constexpr (kk == 0x0A)
+    {
+        c.OP_Fx0A();
+    }
+    else if constexpr (kk == 0x15)
+    {
+        c.delay_timer = v[x];
+    }
+    else if constexpr (kk == 0x18)
+    {
+        c.sound_timer = v[x];
+    }
+    else if constexpr (kk == 0x1E)
+    {
+        c.index = c.index + v[x];
+    }
+    else if constexpr (kk == 0x29)
+    {
+        c.index = FONT_START + 5 * v[x];
+    }
+    else if constexpr (kk == 0x33)
+    {
+        c.OP_Fx33();
+    }
+    else if constexpr (kk == 0x55)
+    {
+        uint16_t last = c.index + x;
+        c.FlipPages(c.index, last);
+        for (size_t i = 0; i <= x; ++i)
+        {
+            c.memory[(c.index + i) & MEM_END] = v[i];
+        }
+        c.FlipPages(c.index, last);
+        if (c.quirks & QUIRK_LOAD_STORE)
+            c.index = last + 1;
+    }
+    else
+    {
+        for (size_t i = 0; i <= x; ++i)
+        {
+            v[i] = c.memory[(c.index + i) & MEM_END];
+        }
+        if (c.quirks & QUIRK_LOAD_STORE)
+            c.index += x + 1;
+    }
+}
+
+template <uint16_t OP>
+static constexpr chip8::DirectFunc Entry()
+{
+    // Only valid opcodes get their own instantiation
+    if constexpr (Valid(OP))
+    {
+        return &chip8::Direct<OP>;
+    }
+    else
+    {
+        return &chip8::DirectNULL;
+    }
+}
+
+// A single aggregate initializer, the table is constant initialized with no code run at startup
+template <size_t... OP>
+static constexpr std::array<chip8::DirectFunc, sizeof...(OP)> MakeDirect(std::index_sequence<OP...>)
+{
+    return {{Entry<static_cast<uint16_t>(OP)>()...}};
+}
+
+const std::array<chip8::DirectFunc, 0x10000> chip8::direct = MakeDirect(std::make_index_sequence<0x10000>{});
+#else
+const bool chip8::direct_compiled = false;
+
+static constexpr std::array<chip8::DirectFunc, 0x10000> MakeDirect()
+{
+    std::array<chip8::DirectFunc, 0x10000> entries{};
+    for (chip8::DirectFunc &entry : entries)
+    {
+        entry = &chip8::DirectTables;
+    }
+    return entries;
+}
+
+const std::array<chip8::DirectFunc, 0x10000> chip8::direct = MakeDirect();
+#endif
@@ -0,0 +1,471 @@
+#include "env.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "arena.h"
+#include "chip8.h"
+#include "numa.h"
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS, a client going away only ends that client's loop
+#endif
+
+namespace
+{
+// Spins before a worker (or the server waiting on them) falls back to sleeping. Steps usually
+// come back to back, so most commands never pay for a futex wake.
+constexpr int SPIN = 20000;
+
+uint16_t *ActionsOf(uint8_t *region, size_t instances)
+{
+    return reinterpret_cast<uint16_t *>(region + EnvLayout::Actions(instances));
+}
+
+uint8_t *FramesOf(uint8_t *region, size_t instances)
+{
+    return region + EnvLayout::Frames(instances);
+}
+
+float *RewardsOf(uint8_t *region, size_t instances)
+{
+    return reinterpret_cast<float *>(region + EnvLayout::Rewards(instances));
+}
+
+uint8_t *DonesOf(uint8_t *region, size_t instances)
+{
+    return region + EnvLayout::Dones(instances);
+}
+} // namespace
+
+EnvServer::EnvServer() = default; // here, where Arena is complete
+
+EnvServer::~EnvServer()
+{
+    Close();
+}
+
+bool EnvServer::Open(char const *socket, char const *shm, uint8_t const *data, size_t size, Options const &opts)
+{
+    Close();
+    options = opts;
+    if (!data || size == 0 || size > chip8::DATA_END - chip8::DATA_START + 1u || options.instances == 0 ||
+        options.frames_per_step < 1 || options.reward_address >= chip8::MEM_SIZE ||
+        options.done_address >= chip8::MEM_SIZE || strlen(shm) >= sizeof(shm_name) ||
+        strlen(socket) >= sizeof(socket_path))
+    {
+        return false;
+    }
+    rom.assign(data, data + size);
+    strcpy(shm_name, shm);
+
+    // Shared region, replacing whatever a crashed server left behind
+    shm_unlink(shm_name);
+    int fd = shm_open(shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+    region_size = EnvLayout::Size(options.instances);
+    if (fd < 0 || ftruncate(fd, static_cast<off_t>(region_size)) != 0)
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        Close();
+        return false;
+    }
+    void *mapped = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    region = static_cast<uint8_t *>(mapped);
+    auto *header = reinterpret_cast<EnvLayout::Header *>(region);
+    header->magic = EnvLayout::MAGIC;
+    header->version = EnvLayout::VERSION;
+    header->instances = static_cast<uint32_t>(options.instances);
+    header->frame_bytes = EnvLayout::FRAME_BYTES;
+    header->steps = 0;
+
+    // Workers build their machines themselves, on their own node
+    std::vector<int> cpus = Topology::Cpus();
+    size_t count = options.workers > 0 ? static_cast<size_t>(options.workers) : cpus.size();
+    count = std::max<size_t>(1, std::min(count, options.instances));
+    workers = std::vector<Worker>(count);
+    stop = false;
+    ready = 0;
+    failed = false;
+    for (size_t w = 0; w < count; ++w)
+    {
+        workers[w].first = options.instances * w / count;
+        workers[w].count = options.instances * (w + 1) / count - workers[w].first;
+        workers[w].thread = std::thread(&EnvServer::Work, this, w, cpus[w % cpus.size()]);
+    }
+    while (ready.load() < count)
+    {
+        std::this_thread::yield();
+    }
+    if (failed)
+    {
+        Close();
+        return false;
+    }
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, socket);
+    strcpy(socket_path, socket);
+    listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socket_path);
+    if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+        listen(listener, 1) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    Reset();
+    return true;
+}
+
+void EnvServer::Close()
+{
+    if (!workers.empty())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            generation.fetch_add(1, std::memory_order_release);
+        }
+        wake.notify_all();
+        for (Worker &worker : workers)
+        {
+            if (worker.thread.joinable())
+            {
+                worker.thread.join();
+            }
+        }
+        workers.clear();
+    }
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(socket_path);
+        listener = -1;
+    }
+    if (region)
+    {
+        munmap(region, region_size);
+        shm_unlink(shm_name);
+        region = nullptr;
+    }
+}
+
+void EnvServer::Serve()
+{
+    for (;;)
+    {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return;
+        }
+
+        bool shutdown = false;
+        uint8_t request;
+        while (!shutdown && read(client, &request, 1) == 1)
+        {
+            uint8_t reply = ENV_REPLY;
+            switch (request)
+            {
+            case ENV_STEP:
+                Step();
+                break;
+            case ENV_RESET:
+                Reset();
+                break;
+            case ENV_SHUTDOWN:
+                shutdown = true;
+                break;
+            default:
+                reply = ENV_ERROR;
+                break;
+            }
+            if (send(client, &reply, 1, MSG_NOSIGNAL) != 1)
+            {
+                break;
+            }
+        }
+        close(client);
+        if (shutdown)
+        {
+            return;
+        }
+    }
+}
+
+void EnvServer::Step()
+{
+    Dispatch(ENV_STEP);
+    ++reinterpret_cast<EnvLayout::Header *>(region)->steps;
+}
+
+void EnvServer::Reset()
+{
+    Dispatch(ENV_RESET);
+}
+
+void EnvServer::Dispatch(uint8_t request)
+{
+    command.store(request, std::memory_order_relaxed);
+    pending.store(workers.size(), std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        generation.fetch_add(1, std::memory_order_release);
+    }
+    wake.notify_all();
+
+    for (int spin = 0; spin < SPIN && pending.load(std::memory_order_acquire) != 0; ++spin)
+    {
+        std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [&] { return pending.load(std::memory_order_acquire) == 0; });
+}
+
+void EnvServer::Work(size_t w, int cpu)
+{
+    Worker &worker = workers[w];
+    if (options.pin)
+    {
+        Topology::Pin(cpu);
+    }
+
+    // Created on the (pinned) worker so first touch puts its machines on its node
+    size_t bytes = worker.count * (sizeof(chip8) + alignof(chip8) + sizeof(Slot)) + (1u << 16);
+    worker.arena.reset(new Arena(bytes, options.pin ? Topology::NodeOf(cpu) : -1));
+    worker.slots = worker.arena->Array<Slot>(worker.count);
+    for (size_t i = 0; worker.slots && i < worker.count; ++i)
+    {
+        worker.slots[i].machine = worker.arena->New<chip8>(options.seed);
+        if (!worker.slots[i].machine)
+        {
+            failed = true;
+        }
+    }
+    if (!worker.slots)
+    {
+        failed = true;
+    }
+    uint64_t seen = generation.load(std::memory_order_acquire); // nothing is dispatched before ready
+    ++ready;
+
+    for (;;)
+    {
+        uint64_t current = generation.load(std::memory_order_acquire);
+        for (int spin = 0; spin < SPIN && current == seen; ++spin)
+        {
+            std::this_thread::yield();
+            current = generation.load(std::memory_order_acquire);
+        }
+        if (current == seen)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] { return generation.load(std::memory_order_acquire) != seen; });
+            current = generation.load(std::memory_order_acquire);
+        }
+        seen = current;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stop)
+            {
+                break;
+            }
+        }
+
+        Run(w, command.load(std::memory_order_relaxed));
+        if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done.notify_one();
+        }
+    }
+
+    for (size_t i = 0; worker.slots && i < worker.count; ++i)
+    {
+        if (worker.slots[i].machine)
+        {
+            worker.slots[i].machine->~chip8();
+        }
+    }
+}
+
+void EnvServer::Run(size_t w, uint8_t request)
+{
+    Worker &worker = workers[w];
+    for (size_t i = 0; i < worker.count; ++i)
+    {
+        size_t instance = worker.first + i;
+        if (request == ENV_STEP)
+        {
+            StepOne(instance, worker.slots[i]);
+            continue;
+        }
+        ResetOne(instance, worker.slots[i]);
+        RewardsOf(region, options.instances)[instance] = 0.0f;
+        DonesOf(region, options.instances)[instance] = 0;
+        worker.slots[i].machine->PackVideo(FramesOf(region, options.instances) + instance * EnvLayout::FRAME_BYTES);
+    }
+}
+
+// Each episode of an instance gets its own seed, so runs are reproducible and instances differ
+void EnvServer::ResetOne(size_t instance, Slot &slot)
+{
+    chip8 &c = *slot.machine;
+    c.Reset(options.seed + static_cast<uint32_t>(instance) + slot.episode * static_cast<uint32_t>(options.instances));
+    c.LoadROM(rom.data(), rom.size());
+    c.instructions_per_frame = options.instructions_per_frame;
+    ++slot.episode;
+    slot.frames = 0;
+    slot.score = options.reward_address >= 0 ? c.memory[options.reward_address] : 0;
+    slot.reset = false;
+}
+
+void EnvServer::StepOne(size_t instance, Slot &slot)
+{
+    if (slot.reset)
+    {
+        ResetOne(instance, slot);
+    }
+    chip8 &c = *slot.machine;
+
+    uint16_t keys = ActionsOf(region, options.instances)[instance];
+    for (int key = 0; key < 16; ++key)
+    {
+        c.keypad[key] = (keys >> key) & 1u;
+    }
+    for (int frame = 0; frame < options.frames_per_step; ++frame)
+    {
+        c.Frame();
+    }
+    slot.frames += options.frames_per_step;
+
+    uint8_t score = options.reward_address >= 0 ? c.memory[options.reward_address] : 0;
+    RewardsOf(region, options.instances)[instance] = static_cast<float>(int{score} - int{slot.score});
+    slot.score = score;
+
+    bool ended = (options.done_address >= 0 && c.memory[options.done_address]) ||
+                 (options.max_frames && slot.frames >= options.max_frames);
+    DonesOf(region, options.instances)[instance] = ended;
+    slot.reset = ended;
+
+    c.PackVideo(FramesOf(region, options.instances) + instance * EnvLayout::FRAME_BYTES);
+}
+
+EnvClient::~EnvClient()
+{
+    Disconnect();
+}
+
+bool EnvClient::Connect(char const *socket_path, char const *shm_name)
+{
+    Disconnect();
+
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(address.sun_path))
+    {
+        return false;
+    }
+    strcpy(address.sun_path, socket_path);
+    socket_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (socket_fd < 0 || connect(socket_fd, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        Disconnect();
+        return false;
+    }
+
+    int fd = shm_open(shm_name, O_RDWR, 0);
+    struct stat info;
+    if (fd < 0 || fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(EnvLayout::Header))
+    {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        Disconnect();
+        return false;
+    }
+    region_size = static_cast<size_t>(info.st_size);
+    void *mapped = mmap(nullptr, region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapped == MAP_FAILED)
+    {
+        Disconnect();
+        return false;
+    }
+    region = static_cast<uint8_t *>(mapped);
+
+    header = reinterpret_cast<EnvLayout::Header const *>(region);
+    size_t instances = header->instances;
+    if (header->magic != EnvLayout::MAGIC || header->version != EnvLayout::VERSION ||
+        header->frame_bytes != EnvLayout::FRAME_BYTES || EnvLayout::Size(instances) != region_size)
+    {
+        Disconnect();
+        return false;
+    }
+    actions = ActionsOf(region, instances);
+    frames = FramesOf(region, instances);
+    rewards = RewardsOf(region, instances);
+    dones = DonesOf(region, instances);
+    return true;
+}
+
+void EnvClient::Disconnect()
+{
+    if (socket_fd >= 0)
+    {
+        close(socket_fd);
+        socket_fd = -1;
+    }
+    if (region)
+    {
+        munmap(region, region_size);
+        region = nullptr;
+    }
+    header = nullptr;
+}
+
+bool EnvClient::Send(uint8_t command)
+{
+    uint8_t reply = 0;
+    return socket_fd >= 0 && send(socket_fd, &command, 1, MSG_NOSIGNAL) == 1 && read(socket_fd, &reply, 1) == 1 &&
+           reply == ENV_REPLY;
+}
+
+bool EnvClient::Step()
+{
+    return Send(ENV_STEP);
+}
+
+bool EnvClient::Reset()
+{
+    return Send(ENV_RESET);
+}
+
+bool EnvClient::Shutdown()
+{
+    return Send(ENV_SHUTDOWN);
+}
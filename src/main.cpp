@@ -1,52 +1,543 @@
+#include <algorithm>
+#include <cctype>
 #include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <memory>
+#include <vector>
 
 #include "chip8.h"
+#include "phosphor.h"
+#include "romdb.h"
+#include "telemetry.h"
+#include "terminal.h"
+#ifndef CHIP8_NO_SDL
 #include "platform.h"
+#include "viewer.h"
+#endif
 
 #include <cassert>
 
 
+// Shared by every frontend (Platform, Terminal): poll input, cycle, present every present_every cycles.
+// With Timing::Vip the machine meters its own frames in emulated cycles, so a step is a whole
+// Frame() every 1/60 s instead of one instruction every cycle_delay ms.
+// With telemetry, every stage is timed and key changes are timestamped until the next present.
+// With a keymap (RomDb::Entry::keys) the frontend's keys are folded onto the CHIP-8 keys it names.
+template <typename Frontend, typename Present>
+void Run(Frontend& frontend, chip8& active_chip, float cycle_delay, int present_every, uint8_t const* keymap, Present present,
+         Telemetry* telemetry)
+{
+	int cycles = 0;
+	int frame_cycles = 0;
+	bool framed = active_chip.timing == chip8::Timing::Vip;
+	float step_delay = framed ? 1000.0f / 60.0f : cycle_delay;
+	auto lastCycleTime = std::chrono::high_resolution_clock::now();
+	bool quit = false;
+
+	bool key_pending = false;
+	Telemetry::Clock::time_point key_change{};
+	uint8_t keys_before[sizeof(active_chip.keypad)];
+
+	uint8_t held[sizeof(active_chip.keypad)] = {};
+	auto input = [&] {
+		if (!keymap)
+		{
+			return frontend.ProcessInput(active_chip.keypad);
+		}
+		bool quit = frontend.ProcessInput(held);
+		memset(active_chip.keypad, 0, sizeof(active_chip.keypad));
+		for (size_t key = 0; key < sizeof(held); ++key)
+		{
+			active_chip.keypad[keymap[key] & 0xF] |= held[key];
+		}
+		return quit;
+	};
+
+	while (!quit)
+	{
+		if (telemetry)
+		{
+			memcpy(keys_before, active_chip.keypad, sizeof(keys_before));
+			auto start = Telemetry::Clock::now();
+			quit = input();
+			telemetry->Add(Telemetry::InputNs, Telemetry::Since(start));
+			telemetry->Add(Telemetry::InputCalls, 1);
+			if (!key_pending && memcmp(keys_before, active_chip.keypad, sizeof(keys_before)) != 0)
+			{
+				key_pending = true;
+				key_change = start;
+			}
+		}
+		else
+		{
+			quit = input();
+		}
+
+		auto currentTime = std::chrono::high_resolution_clock::now();
+		float dt = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastCycleTime).count();
+
+		if (dt > step_delay)
+		{
+			lastCycleTime = currentTime;
+
+			if (telemetry)
+			{
+				auto start = Telemetry::Clock::now();
+				uint64_t before = active_chip.cycles;
+				framed ? active_chip.Frame() : active_chip.Cycle();
+				telemetry->Add(Telemetry::CycleNs, Telemetry::Since(start));
+				telemetry->Add(Telemetry::CycleCalls, 1);
+				telemetry->Add(Telemetry::Instructions, framed ? active_chip.cycles - before : 1);
+				if (framed || ++frame_cycles >= active_chip.instructions_per_frame)
+				{
+					frame_cycles = 0;
+					telemetry->Add(Telemetry::Frames, 1);
+				}
+			}
+			else
+			{
+				framed ? active_chip.Frame() : active_chip.Cycle();
+			}
+
+			if (++cycles >= present_every)
+			{
+				cycles = 0;
+				if (telemetry)
+				{
+					auto start = Telemetry::Clock::now();
+					present();
+					telemetry->Add(Telemetry::UpdateNs, Telemetry::Since(start));
+					telemetry->Add(Telemetry::UpdateCalls, 1);
+					telemetry->Add(Telemetry::Presented, 1);
+					if (key_pending)
+					{
+						key_pending = false;
+						telemetry->Latency(Telemetry::Since(key_change));
+					}
+				}
+				else
+				{
+					present();
+				}
+			}
+		}
+	}
+}
+
+// RGBA8888 colour for each grey level of a frame (video is 0 / 0xFFFFFFFF, Phosphor blends in
+// between), from a ROM's background to its foreground.
+struct Palette
+{
+    uint32_t levels[256];
+
+    void Set(uint32_t foreground, uint32_t background)
+    {
+        for (uint32_t level = 0; level < 256; ++level)
+        {
+            uint32_t rgb = 0;
+            for (int shift = 0; shift < 24; shift += 8)
+            {
+                int bg = (background >> shift) & 0xFF;
+                int fg = (foreground >> shift) & 0xFF;
+                rgb |= static_cast<uint32_t>(bg + (fg - bg) * static_cast<int>(level) / 255) << shift;
+            }
+            levels[level] = rgb << 8 | 0xFF;
+        }
+    }
+
+    uint32_t const* Apply(uint32_t const* frame, uint32_t* out, size_t count) const
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = levels[(frame[i] >> 8) & 0xFF];
+        }
+        return out;
+    }
+};
+
+// Looks the ROM machine just loaded up in db and applies its speed and quirks. nullptr when the
+// ROM isn't in it.
+RomDb::Entry const* Configure(RomDb const& db, chip8& machine, size_t loaded)
+{
+    RomDb::Entry const* entry = db.Find(&machine.memory[chip8::DATA_START], loaded);
+    if (entry)
+    {
+        RomDb::Apply(*entry, machine);
+        std::clog << "romdb: " << (*db.Name(*entry) ? db.Name(*entry) : "(unnamed)") << ", "
+                  << machine.instructions_per_frame << " instructions per frame\n";
+    }
+    return entry;
+}
+
+#ifndef CHIP8_NO_SDL
+// Monitoring view: count machines running the same ROM from different seeds, one frame each per
+// 60 Hz display frame, shown as a grid by Viewer. The keyboard drives all of them at once.
+int RunGrid(int count, int scale, bool software, char const* rom_filename, RomDb const& db, chip8::Timing timing,
+            Telemetry* telemetry)
+{
+    std::vector<std::unique_ptr<chip8>> machines;
+    std::vector<chip8 const*> tiles;
+    uint32_t seed = static_cast<uint32_t>(std::chrono::system_clock::now().time_since_epoch().count());
+    for (int i = 0; i < count; ++i)
+    {
+        machines.emplace_back(new chip8(seed + i));
+        machines.back()->timing = timing;
+        tiles.push_back(machines.back().get());
+    }
+
+    size_t loaded = 0;
+    RomDb::Entry const* entry = nullptr;
+    std::thread loader([&] {
+        loaded = machines[0]->LoadROM(rom_filename);
+        entry = loaded ? Configure(db, *machines[0], loaded) : nullptr;
+        for (int i = 1; i < count && loaded; ++i)
+        {
+            machines[i]->LoadROM(&machines[0]->memory[chip8::DATA_START], loaded);
+            machines[i]->instructions_per_frame = machines[0]->instructions_per_frame;
+            machines[i]->quirks = machines[0]->quirks;
+        }
+    });
+    Viewer viewer("CHIP-8 Grid", count, 0, scale, software);
+    viewer.Open();
+    loader.join();
+    if (!loaded)
+    {
+        return EXIT_FAILURE;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    constexpr auto period = std::chrono::microseconds(16667);
+    auto started = Clock::now();
+    auto deadline = started;
+    uint64_t presented = 0;
+    uint64_t uploaded = 0;
+    double update_ms = 0;
+    uint8_t keys[16] = {};
+    uint8_t mapped[16] = {};
+    bool remap = entry && (entry->flags & RomDb::HAS_KEYS);
+
+    while (!viewer.ProcessInput(keys))
+    {
+        if (remap)
+        {
+            memset(mapped, 0, sizeof(mapped));
+            for (size_t key = 0; key < sizeof(keys); ++key)
+            {
+                mapped[entry->keys[key] & 0xF] |= keys[key];
+            }
+        }
+        uint64_t executed = 0;
+        for (auto& c : machines)
+        {
+            memcpy(c->keypad, remap ? mapped : keys, sizeof(keys));
+            uint64_t before = c->cycles;
+            c->Frame();
+            executed += c->cycles - before;
+        }
+
+        auto start = Clock::now();
+        uploaded += viewer.Update(tiles.data());
+        update_ms += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+        ++presented;
+        if (telemetry)
+        {
+            telemetry->Add(Telemetry::Instructions, executed);
+            telemetry->Add(Telemetry::Frames, 1);
+            telemetry->Add(Telemetry::Presented, 1);
+            telemetry->Add(Telemetry::UpdateNs, Telemetry::Since(start));
+            telemetry->Add(Telemetry::UpdateCalls, 1);
+        }
+
+        // Fixed 60 Hz, and no catching up after a stall
+        deadline = std::max(deadline + period, Clock::now() - period);
+        std::this_thread::sleep_until(deadline);
+    }
+
+    double seconds = std::chrono::duration<double>(Clock::now() - started).count();
+    printf("%d machines, %dx%d grid: %llu frames, %.1f fps, update %.2f ms, %.1f tiles uploaded per frame\n", count,
+           viewer.Columns(), viewer.Rows(), static_cast<unsigned long long>(presented), presented / seconds,
+           presented ? update_ms / presented : 0.0, presented ? double(uploaded) / presented : 0.0);
+    return 0;
+}
+#endif
+
+void Usage(char const* exe)
+{
+    std::cerr << "Usage: " << exe << " <Scale> <Delay> <ROM> [--term] [--indexed] [--persist <0-255>]"
+              << " [--present <N>] [--phosphor <K>] [--average] [--stats <file|unix:path>] [--stats-interval <ms>]"
+              << " [--headless <frames>] [--grid <N>] [--software] [--db <file>] [--vip [cycles per frame]]\n"
+              << "--vip meters frames in COSMAC VIP machine cycles instead of Delay, the same work per frame on\n"
+              << "any host.\n"
+              << "With --db (or CHIP8_ROMDB set) a ROM found in the database runs at its own speed, quirks,\n"
+              << "palette and keys, and Delay is ignored for it.\n"
+#ifdef CHIP8_NO_SDL
+              << "Built without SDL (NO_SDL): always runs in the terminal, --grid is unavailable.\n"
+#endif
+              ;
+    std::exit(EXIT_FAILURE);
+}
+
 int main(int argc, char* argv[])
 {
-    if (argc != 4)
+    auto launched = std::chrono::steady_clock::now();
+    if (argc < 4)
     {
-        std::cerr << "Usage: " << argv[0] << " <Scale> <Delay> <ROM>\n";
-        std::exit(EXIT_FAILURE);
+        Usage(argv[0]);
     }
 
     int video_scale = std::stoi(argv[1]);
-    int cycle_delay = std::stoi(argv[2]);
+    float cycle_delay = std::stof(argv[2]);
     char const* rom_filename = argv[3];
 
-    
-    Platform platform("CHIP-8 Emulator", DEFAULT_WIDTH * video_scale, DEFAULT_HEIGHT * video_scale, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+#ifdef CHIP8_NO_SDL
+    bool terminal = true; // the only frontend without SDL
+#else
+    bool terminal = false;
+#endif
+    bool indexed = false;
+    int persistence = 0;
+    int present_every = 0; // 0 = every cycle, or once per frame for a ROM from the database
+    int phosphor_depth = 0;
+    Phosphor::Mode phosphor_mode = Phosphor::Mode::Decay;
+    char const* stats_target = nullptr;
+    int stats_interval = 1000;
+    long headless_frames = 0;
+    int grid = 0;
+    bool software = false;
+    char const* db_path = getenv("CHIP8_ROMDB");
+    bool vip = false;
+    int vip_cycles = chip8::VIP_CYCLES_PER_FRAME;
+    for (int i = 4; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--term") == 0)
+        {
+            terminal = true;
+        }
+        else if (std::strcmp(argv[i], "--indexed") == 0)
+        {
+            indexed = true;
+        }
+        else if (std::strcmp(argv[i], "--persist") == 0 && i + 1 < argc)
+        {
+            persistence = std::stoi(argv[++i]);
+            indexed = true;
+        }
+        else if (std::strcmp(argv[i], "--present") == 0 && i + 1 < argc)
+        {
+            present_every = std::max(1, std::stoi(argv[++i]));
+        }
+        else if (std::strcmp(argv[i], "--phosphor") == 0 && i + 1 < argc)
+        {
+            phosphor_depth = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--average") == 0)
+        {
+            phosphor_mode = Phosphor::Mode::Average;
+        }
+        else if (std::strcmp(argv[i], "--stats") == 0 && i + 1 < argc)
+        {
+            stats_target = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--stats-interval") == 0 && i + 1 < argc)
+        {
+            stats_interval = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+        {
+            headless_frames = std::stol(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--grid") == 0 && i + 1 < argc)
+        {
+            grid = std::stoi(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--software") == 0)
+        {
+            software = true;
+        }
+        else if (std::strcmp(argv[i], "--db") == 0 && i + 1 < argc)
+        {
+            db_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--vip") == 0)
+        {
+            vip = true;
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0])))
+            {
+                vip_cycles = std::max(1, std::stoi(argv[++i]));
+            }
+        }
+        else
+        {
+            Usage(argv[0]);
+        }
+    }
 
+#ifdef CHIP8_NO_SDL
+    // Window options, the terminal ignores them as it does with --term
+    (void)video_scale;
+    (void)indexed;
+    (void)persistence;
+    (void)software;
+#endif
 
     chip8 active_chip;
-    active_chip.LoadROM(rom_filename);
-    
+    active_chip.timing = vip ? chip8::Timing::Vip : chip8::Timing::Flat;
+    active_chip.cycles_per_frame = vip_cycles;
 
-    int videoPitch = sizeof(active_chip.video[0]) * DEFAULT_WIDTH;
+    Telemetry telemetry;
+    if (stats_target && !telemetry.Open(stats_target, stats_interval))
+    {
+        std::cerr << "Could not open " << stats_target << " for stats\n";
+        return EXIT_FAILURE;
+    }
+    Telemetry* stats = stats_target ? &telemetry : nullptr;
 
-	auto lastCycleTime = std::chrono::high_resolution_clock::now();
-	bool quit = false;
+    // Read once, on whichever thread loads the ROM
+    RomDb db;
+    std::string db_error;
+    auto load_db = [&] { return !db_path || db.Load(db_path, &db_error); };
 
-	while (!quit)
-	{
-		quit = platform.ProcessInput(active_chip.keypad);
+    // Batch use: no frontend and no SDL, run frames as fast as possible and report.
+    if (headless_frames > 0)
+    {
+        size_t loaded = active_chip.LoadROM(rom_filename);
+        if (!loaded || !load_db())
+        {
+            std::cerr << db_error << (db_error.empty() ? "" : "\n");
+            return EXIT_FAILURE;
+        }
+        Configure(db, active_chip, loaded);
+        auto first = std::chrono::steady_clock::now();
+        for (long i = 0; i < headless_frames; ++i)
+        {
+            uint64_t before = active_chip.cycles;
+            active_chip.Frame();
+            if (stats)
+            {
+                stats->Add(Telemetry::Instructions, active_chip.cycles - before);
+                stats->Add(Telemetry::Frames, 1);
+            }
+        }
+        auto done = std::chrono::steady_clock::now();
+        printf("frames %ld instructions %llu digest %016llx first_instruction_us %.0f run_ms %.3f\n", headless_frames,
+               static_cast<unsigned long long>(active_chip.cycles),
+               static_cast<unsigned long long>(active_chip.Digest()),
+               std::chrono::duration<double, std::micro>(first - launched).count(),
+               std::chrono::duration<double, std::milli>(done - first).count());
+        return 0;
+    }
 
-		auto currentTime = std::chrono::high_resolution_clock::now();
-		float dt = std::chrono::duration<float, std::chrono::milliseconds::period>(currentTime - lastCycleTime).count();
+    if (grid > 0)
+    {
+#ifdef CHIP8_NO_SDL
+        std::cerr << "--grid needs SDL, this build has none\n";
+        return EXIT_FAILURE;
+#else
+        if (!load_db())
+        {
+            std::cerr << db_error << "\n";
+            return EXIT_FAILURE;
+        }
+        return RunGrid(grid, video_scale, software, rom_filename, db, active_chip.timing, stats);
+#endif
+    }
 
-		if (dt > cycle_delay)
-		{
-			lastCycleTime = currentTime;
+    // The ROM (and database) load on another thread while this one brings up the frontend (SDL
+    // wants the main thread). A ROM found in the database picks speed, quirks, palette and keys.
+    size_t loaded = 0;
+    bool db_loaded = false;
+    RomDb::Entry const* entry = nullptr;
+    std::thread loader([&] {
+        loaded = active_chip.LoadROM(rom_filename);
+        db_loaded = load_db();
+        entry = loaded && db_loaded ? Configure(db, active_chip, loaded) : nullptr;
+    });
+    uint8_t const* keymap = nullptr;
+    bool colored = false;
+    Palette palette;
+    auto ready = [&] {
+        loader.join();
+        if (!db_loaded)
+        {
+            std::cerr << db_error << "\n";
+            return false;
+        }
+        if (entry && entry->instructions_per_frame && !vip)
+        {
+            // 60 frames a second, shown once each unless --present says otherwise
+            cycle_delay = 1000.0f / (60.0f * entry->instructions_per_frame);
+            present_every = present_every ? present_every : entry->instructions_per_frame;
+        }
+        present_every = std::max(1, present_every);
+        keymap = entry && (entry->flags & RomDb::HAS_KEYS) ? entry->keys : nullptr;
+        if (entry && (entry->flags & RomDb::HAS_PALETTE))
+        {
+            colored = true;
+            palette.Set(entry->foreground, entry->background);
+        }
+        return loaded > 0;
+    };
 
-			active_chip.Cycle();
+    int videoPitch = sizeof(active_chip.video[0]) * DEFAULT_WIDTH;
 
-			platform.Update(active_chip.video, videoPitch);
-		}
-	}
+    // Blends at present time only, the indexed path has its own GPU side persistence instead.
+    Phosphor phosphor(DEFAULT_WIDTH, DEFAULT_HEIGHT, phosphor_depth, phosphor_mode);
+    auto frame = [&]() -> uint32_t const* {
+        return phosphor_depth > 0 ? phosphor.Apply(active_chip.video) : active_chip.video;
+    };
+#ifndef CHIP8_NO_SDL
+    uint32_t colors[DEFAULT_WIDTH * DEFAULT_HEIGHT];
+    auto colored_frame = [&]() -> uint32_t const* {
+        return colored ? palette.Apply(frame(), colors, DEFAULT_WIDTH * DEFAULT_HEIGHT) : frame();
+    };
+#endif
+
+    if (terminal)
+    {
+        // Scale is meaningless in a terminal, one cell is always 1x2 pixels, and so is the palette.
+        Terminal term(DEFAULT_WIDTH, DEFAULT_HEIGHT);
+        if (!ready())
+        {
+            return EXIT_FAILURE;
+        }
+        Run(term, active_chip, cycle_delay, present_every, keymap, [&] { term.Update(frame(), videoPitch); }, stats);
+    }
+#ifndef CHIP8_NO_SDL
+    else if (indexed)
+    {
+        Platform platform("CHIP-8 Emulator", DEFAULT_WIDTH * video_scale, DEFAULT_HEIGHT * video_scale, DEFAULT_WIDTH, DEFAULT_HEIGHT,
+                          PresentMode::Indexed, static_cast<uint8_t>(std::clamp(persistence, 0, 255)));
+        platform.Open();
+        if (!ready())
+        {
+            return EXIT_FAILURE;
+        }
+        if (colored)
+        {
+            platform.SetPalette(entry->foreground, entry->background);
+        }
+        uint8_t bits[DEFAULT_WIDTH * DEFAULT_HEIGHT / 8];
+        Run(platform, active_chip, cycle_delay, present_every, keymap, [&] {
+            active_chip.PackVideo(bits);
+            platform.UpdateIndexed(bits);
+        }, stats);
+    }
+    else
+    {
+        Platform platform("CHIP-8 Emulator", DEFAULT_WIDTH * video_scale, DEFAULT_HEIGHT * video_scale, DEFAULT_WIDTH, DEFAULT_HEIGHT);
+        platform.Open();
+        if (!ready())
+        {
+            return EXIT_FAILURE;
+        }
+        Run(platform, active_chip, cycle_delay, present_every, keymap, [&] { platform.Update(colored_frame(), videoPitch); },
+            stats);
+    }
+#endif
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,132 @@
+#include "numa.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+std::vector<int> Topology::Cpus()
+{
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty())
+    {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    return cpus;
+}
+
+std::vector<int> Topology::ParseList(char const *text)
+{
+    std::vector<int> ids;
+    char const *p = text;
+    while (*p >= '0' && *p <= '9')
+    {
+        char *end;
+        int first = static_cast<int>(strtol(p, &end, 10));
+        int last = first;
+        if (*end == '-')
+        {
+            last = static_cast<int>(strtol(end + 1, &end, 10));
+        }
+        for (int id = first; id <= last; ++id)
+        {
+            ids.push_back(id);
+        }
+        p = *end == ',' ? end + 1 : end;
+    }
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    return ids;
+}
+
+#ifdef __linux__
+// First line of a sysfs file, empty when it can't be read
+static std::string ReadLine(char const *path)
+{
+    char line[4096] = {};
+    FILE *file = fopen(path, "r");
+    if (!file)
+    {
+        return {};
+    }
+    if (!fgets(line, sizeof(line), file))
+    {
+        line[0] = 0;
+    }
+    fclose(file);
+    return line;
+}
+#endif
+
+std::vector<int> Topology::NodeIds()
+{
+    std::vector<int> ids;
+#ifdef __linux__
+    // Not node0..N-1: IDs of offline or hot-plugged nodes leave gaps ("0,2")
+    ids = ParseList(ReadLine("/sys/devices/system/node/online").c_str());
+#endif
+    if (ids.empty())
+    {
+        ids.push_back(0);
+    }
+    return ids;
+}
+
+int Topology::Nodes()
+{
+    return static_cast<int>(NodeIds().size());
+}
+
+int Topology::NodeOf(int cpu)
+{
+#ifdef __linux__
+    for (int node : NodeIds())
+    {
+        char path[64];
+        snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+        std::vector<int> cpus = ParseList(ReadLine(path).c_str());
+        if (std::binary_search(cpus.begin(), cpus.end(), cpu))
+        {
+            return node;
+        }
+    }
+#else
+    (void)cpu;
+#endif
+    return 0;
+}
+
+bool Topology::Pin(int cpu)
+{
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
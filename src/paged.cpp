@@ -0,0 +1,93 @@
+#include "paged.h"
+
+#include <cstring>
+
+PagedState::PagedState(PagedState const &other)
+{
+    Share(other);
+}
+
+PagedState::PagedState(PagedState &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+PagedState &PagedState::operator=(PagedState const &other)
+{
+    if (this != &other)
+    {
+        Share(other);
+    }
+    return *this;
+}
+
+PagedState &PagedState::operator=(PagedState &&other) noexcept
+{
+    if (this != &other)
+    {
+        for (int page = 0; page < PAGES; ++page)
+        {
+            Release(pages[page]);
+            pages[page] = other.pages[page];
+            other.pages[page] = nullptr;
+        }
+        CopyRegisters(other);
+    }
+    return *this;
+}
+
+PagedState::~PagedState()
+{
+    for (Page *page : pages)
+    {
+        Release(page);
+    }
+}
+
+void PagedState::Release(Page *page)
+{
+    if (page && page->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        delete page;
+    }
+}
+
+void PagedState::Share(PagedState const &other)
+{
+    for (int page = 0; page < PAGES; ++page)
+    {
+        // Take the new reference first, other may share this very page
+        if (other.pages[page])
+        {
+            other.pages[page]->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        Release(pages[page]);
+        pages[page] = other.pages[page];
+    }
+    CopyRegisters(other);
+}
+
+void PagedState::CopyRegisters(PagedState const &other)
+{
+    memcpy(v_registers, other.v_registers, sizeof(v_registers));
+    memcpy(stack, other.stack, sizeof(stack));
+    pc = other.pc;
+    index = other.index;
+    opcode = other.opcode;
+    sp = other.sp;
+    delay_timer = other.delay_timer;
+    sound_timer = other.sound_timer;
+    memcpy(keypad, other.keypad, sizeof(keypad));
+    memcpy(video_rows, other.video_rows, sizeof(video_rows));
+    memory_digest = other.memory_digest;
+    video_digest = other.video_digest;
+    rng = other.rng;
+}
+
+void PagedState::Assign(int page, uint8_t const *bytes)
+{
+    Page *fresh = new Page;
+    memcpy(fresh->bytes, bytes, PAGE_SIZE);
+    Release(pages[page]);
+    pages[page] = fresh;
+}
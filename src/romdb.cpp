@@ -0,0 +1,375 @@
+#include "romdb.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "chip8.h"
+
+static uint32_t Rotl(uint32_t value, int bits)
+{
+    return (value << bits) | (value >> (32 - bits));
+}
+
+static void Sha1Block(uint32_t state[5], uint8_t const *block)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+    {
+        w[i] = uint32_t{block[i * 4]} << 24 | uint32_t{block[i * 4 + 1]} << 16 | uint32_t{block[i * 4 + 2]} << 8 |
+               block[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; ++i)
+    {
+        w[i] = Rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+    }
+
+    uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+    for (int i = 0; i < 80; ++i)
+    {
+        uint32_t f, k;
+        if (i < 20)
+        {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        }
+        else if (i < 40)
+        {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        }
+        else if (i < 60)
+        {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        }
+        else
+        {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = Rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = Rotl(b, 30);
+        b = a;
+        a = t;
+    }
+    state[0] += a;
+    state[1] += b;
+    state[2] += c;
+    state[3] += d;
+    state[4] += e;
+}
+
+void RomDb::Sha1(uint8_t const *data, size_t size, uint8_t out[DIGEST_SIZE])
+{
+    uint32_t state[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t whole = size & ~size_t{63};
+    for (size_t offset = 0; offset < whole; offset += 64)
+    {
+        Sha1Block(state, data + offset);
+    }
+
+    // The tail, 0x80, zeros and the bit length fill one or two more blocks
+    uint8_t tail[128] = {};
+    size_t rest = size - whole;
+    if (rest)
+    {
+        memcpy(tail, data + whole, rest);
+    }
+    tail[rest] = 0x80;
+    size_t blocks = rest < 56 ? 1 : 2;
+    uint64_t bits = uint64_t{size} * 8;
+    for (int i = 0; i < 8; ++i)
+    {
+        tail[blocks * 64 - 1 - i] = static_cast<uint8_t>(bits >> (i * 8));
+    }
+    for (size_t block = 0; block < blocks; ++block)
+    {
+        Sha1Block(state, tail + block * 64);
+    }
+
+    for (int i = 0; i < 5; ++i)
+    {
+        out[i * 4] = static_cast<uint8_t>(state[i] >> 24);
+        out[i * 4 + 1] = static_cast<uint8_t>(state[i] >> 16);
+        out[i * 4 + 2] = static_cast<uint8_t>(state[i] >> 8);
+        out[i * 4 + 3] = static_cast<uint8_t>(state[i]);
+    }
+}
+
+static int Hex(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+// Exactly digits hex digits from text into value
+static bool ParseHex(char const *text, size_t length, size_t digits, uint32_t &value)
+{
+    if (length != digits)
+    {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < digits; ++i)
+    {
+        int digit = Hex(text[i]);
+        if (digit < 0)
+        {
+            return false;
+        }
+        value = value << 4 | static_cast<uint32_t>(digit);
+    }
+    return true;
+}
+
+bool RomDb::ParseQuirks(char const *text, size_t length, uint8_t &quirks)
+{
+    static constexpr struct
+    {
+        char const *name;
+        uint8_t bit;
+    } NAMES[] = {{"none", 0},
+                 {"shift", chip8::QUIRK_SHIFT},
+                 {"load_store", chip8::QUIRK_LOAD_STORE},
+                 {"jump", chip8::QUIRK_JUMP},
+                 {"vf_reset", chip8::QUIRK_VF_RESET},
+                 {"wrap", chip8::QUIRK_WRAP}};
+
+    quirks = 0;
+    char const *end = text + length;
+    while (text < end)
+    {
+        char const *comma = std::find(text, end, ',');
+        size_t size = static_cast<size_t>(comma - text);
+        bool known = false;
+        for (auto const &quirk : NAMES)
+        {
+            if (strlen(quirk.name) == size && strncmp(quirk.name, text, size) == 0)
+            {
+                quirks |= quirk.bit;
+                known = true;
+            }
+        }
+        if (!known)
+        {
+            return false;
+        }
+        text = comma == end ? end : comma + 1;
+    }
+    return true;
+}
+
+// One non-comment line into entry, the name appended to names. nullptr or what was wrong.
+static char const *ParseLine(char const *line, char const *end, RomDb::Entry &entry, std::string &names)
+{
+    entry = {};
+    auto token_end = [&](char const *p) {
+        while (p < end && *p != ' ' && *p != '\t')
+            ++p;
+        return p;
+    };
+    auto skip_space = [&](char const *p) {
+        while (p < end && (*p == ' ' || *p == '\t'))
+            ++p;
+        return p;
+    };
+
+    char const *p = skip_space(line);
+    char const *next = token_end(p);
+    if (next - p != 2 * RomDb::DIGEST_SIZE)
+    {
+        return "expected a 40 digit SHA-1";
+    }
+    for (size_t i = 0; i < RomDb::DIGEST_SIZE; ++i)
+    {
+        uint32_t byte;
+        if (!ParseHex(p + i * 2, 2, 2, byte))
+        {
+            return "expected a 40 digit SHA-1";
+        }
+        entry.sha1[i] = static_cast<uint8_t>(byte);
+    }
+
+    for (p = skip_space(next); p < end; p = skip_space(next))
+    {
+        next = token_end(p);
+        char const *equals = std::find(p, next, '=');
+        if (equals == next)
+        {
+            return "expected key=value";
+        }
+        std::string key(p, equals);
+        char const *value = equals + 1;
+        size_t length = static_cast<size_t>(next - value);
+
+        if (key == "name")
+        {
+            // The rest of the line, spaces included
+            char const *last = end;
+            while (last > value && (last[-1] == ' ' || last[-1] == '\t'))
+                --last;
+            entry.name = static_cast<uint32_t>(names.size());
+            names.append(value, last);
+            names.push_back('\0');
+            next = end;
+        }
+        else if (key == "ipf")
+        {
+            std::string number(value, length);
+            char *stop = nullptr;
+            long ipf = strtol(number.c_str(), &stop, 10);
+            if (number.empty() || *stop || ipf < 1 || ipf > 10000)
+            {
+                return "ipf must be 1-10000";
+            }
+            entry.instructions_per_frame = static_cast<uint16_t>(ipf);
+        }
+        else if (key == "quirks")
+        {
+            if (!RomDb::ParseQuirks(value, length, entry.quirks))
+            {
+                return "unknown quirk";
+            }
+        }
+        else if (key == "palette")
+        {
+            if (length != 13 || value[6] != ',' || !ParseHex(value, 6, 6, entry.foreground) ||
+                !ParseHex(value + 7, 6, 6, entry.background))
+            {
+                return "palette must be RRGGBB,RRGGBB";
+            }
+            entry.flags |= RomDb::HAS_PALETTE;
+        }
+        else if (key == "keys")
+        {
+            if (length != 16)
+            {
+                return "keys must be 16 hex digits";
+            }
+            for (size_t k = 0; k < 16; ++k)
+            {
+                int digit = Hex(value[k]);
+                if (digit < 0)
+                {
+                    return "keys must be 16 hex digits";
+                }
+                entry.keys[k] = static_cast<uint8_t>(digit);
+            }
+            entry.flags |= RomDb::HAS_KEYS;
+        }
+        else
+        {
+            return "unknown key";
+        }
+    }
+    return nullptr;
+}
+
+bool RomDb::Load(char const *path, std::string *error)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        if (error)
+        {
+            *error = std::string("could not open ") + path;
+        }
+        return false;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return Parse(text.data(), text.size(), error);
+}
+
+bool RomDb::Parse(char const *text, size_t size, std::string *error)
+{
+    std::vector<Entry> parsed;
+    std::string parsed_names(1, '\0');
+
+    char const *end = text + size;
+    size_t number = 0;
+    for (char const *line = text; line < end;)
+    {
+        char const *line_end = std::find(line, end, '\n');
+        char const *next = line_end == end ? end : line_end + 1;
+        ++number;
+        if (line_end > line && line_end[-1] == '\r')
+        {
+            --line_end;
+        }
+
+        char const *first = line;
+        while (first < line_end && (*first == ' ' || *first == '\t'))
+            ++first;
+        if (first < line_end && *first != '#')
+        {
+            Entry entry;
+            if (char const *problem = ParseLine(first, line_end, entry, parsed_names))
+            {
+                if (error)
+                {
+                    *error = "line " + std::to_string(number) + ": " + problem;
+                }
+                return false;
+            }
+            parsed.push_back(entry);
+        }
+        line = next;
+    }
+
+    // Stable, so among equal hashes file order survives and the last one is kept
+    auto less = [](Entry const &a, Entry const &b) { return memcmp(a.sha1, b.sha1, DIGEST_SIZE) < 0; };
+    std::stable_sort(parsed.begin(), parsed.end(), less);
+    size_t kept = 0;
+    for (size_t i = 0; i < parsed.size(); ++i)
+    {
+        if (i + 1 < parsed.size() && memcmp(parsed[i].sha1, parsed[i + 1].sha1, DIGEST_SIZE) == 0)
+        {
+            continue;
+        }
+        parsed[kept++] = parsed[i];
+    }
+    parsed.resize(kept);
+    parsed.shrink_to_fit();
+
+    entries.swap(parsed);
+    names.swap(parsed_names);
+    return true;
+}
+
+RomDb::Entry const *RomDb::Find(uint8_t const sha1[DIGEST_SIZE]) const
+{
+    auto it = std::lower_bound(entries.begin(), entries.end(), sha1, [](Entry const &entry, uint8_t const *key) {
+        return memcmp(entry.sha1, key, DIGEST_SIZE) < 0;
+    });
+    if (it == entries.end() || memcmp(it->sha1, sha1, DIGEST_SIZE) != 0)
+    {
+        return nullptr;
+    }
+    return &*it;
+}
+
+RomDb::Entry const *RomDb::Find(uint8_t const *data, size_t size) const
+{
+    uint8_t sha1[DIGEST_SIZE];
+    Sha1(data, size, sha1);
+    return Find(sha1);
+}
+
+void RomDb::Apply(Entry const &entry, chip8 &machine)
+{
+    if (entry.instructions_per_frame)
+    {
+        machine.instructions_per_frame = entry.instructions_per_frame;
+    }
+    machine.quirks = entry.quirks;
+}
@@ -0,0 +1,286 @@
+#include "scheduler.h"
+
+#include <algorithm>
+
+#include "chip8.h"
+#include "numa.h"
+
+Scheduler::Scheduler(Options const &opts) : options(opts)
+{
+    cpus = Topology::Cpus();
+    worker_count = options.workers > 0 ? options.workers : static_cast<int>(cpus.size());
+    worker_count = std::max(1, worker_count);
+    workers.reset(new Worker[worker_count]);
+}
+
+Scheduler::~Scheduler()
+{
+    Stop();
+}
+
+void Scheduler::Bump(std::atomic<uint64_t> &counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+Scheduler::Task Scheduler::Add(chip8 *machine, int worker)
+{
+    Entry *entry;
+    Task task;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        task = static_cast<Task>(entries.size());
+        entries.emplace_back();
+        entry = &entries.back();
+    }
+    entry->machine = machine;
+    entry->due = Clock::now();
+    int w = worker >= 0 ? worker % worker_count : static_cast<int>(task % worker_count);
+    entry->worker.store(w, std::memory_order_relaxed);
+    Push(w, entry);
+    return task;
+}
+
+void Scheduler::Start()
+{
+    if (running)
+    {
+        return;
+    }
+    running = true;
+    stop = false;
+    for (int w = 0; w < worker_count; ++w)
+    {
+        workers[w].thread = std::thread(&Scheduler::Work, this, w, cpus[w % cpus.size()]);
+    }
+}
+
+void Scheduler::Stop()
+{
+    if (!running)
+    {
+        return;
+    }
+    stop = true;
+    for (int w = 0; w < worker_count; ++w)
+    {
+        Kick(w);
+    }
+    for (int w = 0; w < worker_count; ++w)
+    {
+        workers[w].thread.join();
+    }
+    running = false;
+}
+
+void Scheduler::SetKey(Task task, int key, bool pressed)
+{
+    Entry *entry;
+    {
+        std::lock_guard<std::mutex> lock(tasks_mutex);
+        if (task >= entries.size())
+        {
+            return;
+        }
+        entry = &entries[task];
+    }
+    uint16_t bit = static_cast<uint16_t>(1u << (key & 0xF));
+    uint16_t keys = pressed ? entry->keys.fetch_or(bit) | bit : entry->keys.fetch_and(~bit) & ~bit;
+
+    // Pairs with the re-check in Slice: either it sees these keys or this sees Blocked
+    uint8_t blocked = Blocked;
+    if (keys && entry->state.compare_exchange_strong(blocked, Queued))
+    {
+        wakeups.fetch_add(1, std::memory_order_relaxed);
+        Push(entry->worker.load(std::memory_order_relaxed), entry);
+    }
+}
+
+Scheduler::Stats Scheduler::Totals() const
+{
+    Stats stats;
+    for (int w = 0; w < worker_count; ++w)
+    {
+        stats.frames += workers[w].frames.load(std::memory_order_relaxed);
+        stats.key_waits += workers[w].key_waits.load(std::memory_order_relaxed);
+        stats.steals += workers[w].steals.load(std::memory_order_relaxed);
+        stats.sleeps += workers[w].sleeps.load(std::memory_order_relaxed);
+    }
+    stats.wakeups = wakeups.load(std::memory_order_relaxed);
+    return stats;
+}
+
+size_t Scheduler::Tasks() const
+{
+    std::lock_guard<std::mutex> lock(tasks_mutex);
+    return entries.size();
+}
+
+void Scheduler::Push(int w, Entry *entry)
+{
+    Worker &worker = workers[w];
+    bool backlog;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(entry);
+        backlog = worker.queue.size() > 1;
+    }
+    if (worker.sleeping.load())
+    {
+        Kick(w);
+    }
+    // More than its owner can start right now, let a sleeping peer come and steal
+    if (backlog)
+    {
+        for (int other = 0; other < worker_count; ++other)
+        {
+            if (other != w && workers[other].sleeping.load())
+            {
+                Kick(other);
+                break;
+            }
+        }
+    }
+}
+
+void Scheduler::Kick(int w)
+{
+    Worker &worker = workers[w];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.kicked = true;
+    }
+    worker.wake.notify_one();
+}
+
+// Half of the longest looking queue, from its back (the tasks its owner would get to last)
+Scheduler::Entry *Scheduler::Steal(int w)
+{
+    for (int i = 1; i < worker_count; ++i)
+    {
+        Worker &victim = workers[(w + i) % worker_count];
+        std::vector<Entry *> taken;
+        {
+            std::unique_lock<std::mutex> lock(victim.mutex, std::try_to_lock);
+            if (!lock.owns_lock() || victim.queue.empty())
+            {
+                continue;
+            }
+            size_t count = (victim.queue.size() + 1) / 2;
+            taken.assign(victim.queue.end() - count, victim.queue.end());
+            victim.queue.erase(victim.queue.end() - count, victim.queue.end());
+        }
+        Worker &self = workers[w];
+        self.steals.store(self.steals.load(std::memory_order_relaxed) + taken.size(), std::memory_order_relaxed);
+        Entry *first = taken.front();
+        if (taken.size() > 1)
+        {
+            std::lock_guard<std::mutex> lock(self.mutex);
+            self.queue.insert(self.queue.end(), taken.begin() + 1, taken.end());
+        }
+        return first;
+    }
+    return nullptr;
+}
+
+void Scheduler::Work(int w, int cpu)
+{
+    Worker &worker = workers[w];
+    if (options.pin)
+    {
+        Topology::Pin(cpu);
+    }
+
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        // Due timers go to the back of the queue, behind anything already waiting
+        Clock::time_point now = Clock::now();
+        while (!worker.timers.empty() && worker.timers.front().due <= now)
+        {
+            Entry *entry = worker.timers.front().entry;
+            std::pop_heap(worker.timers.begin(), worker.timers.end(), std::greater<Timer>());
+            worker.timers.pop_back();
+            entry->state.store(Queued, std::memory_order_relaxed);
+            Push(w, entry);
+        }
+
+        Entry *entry = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(worker.mutex);
+            if (!worker.queue.empty())
+            {
+                entry = worker.queue.front();
+                worker.queue.pop_front();
+            }
+        }
+        if (!entry)
+        {
+            entry = Steal(w);
+        }
+        if (entry)
+        {
+            Slice(w, *entry);
+            continue;
+        }
+
+        // Nothing runnable anywhere: sleep until the next timer or a kick
+        Bump(worker.sleeps);
+        std::unique_lock<std::mutex> lock(worker.mutex);
+        worker.sleeping.store(true);
+        auto ready = [&] { return worker.kicked || !worker.queue.empty(); };
+        if (worker.timers.empty())
+        {
+            worker.wake.wait(lock, ready);
+        }
+        else
+        {
+            worker.wake.wait_until(lock, worker.timers.front().due, ready);
+        }
+        worker.sleeping.store(false);
+        worker.kicked = false;
+    }
+}
+
+void Scheduler::Slice(int w, Entry &entry)
+{
+    Worker &worker = workers[w];
+    entry.state.store(Running, std::memory_order_relaxed);
+    entry.worker.store(w, std::memory_order_relaxed);
+
+    chip8 &c = *entry.machine;
+    uint16_t keys = entry.keys.load();
+    for (int key = 0; key < 16; ++key)
+    {
+        c.keypad[key] = (keys >> key) & 1u;
+    }
+
+    chip8::RunResult result = c.Run(~0ull, chip8::STOP_FRAME | chip8::STOP_KEY_WAIT);
+    if (result.reason == chip8::StopReason::KeyWait)
+    {
+        Bump(worker.key_waits);
+        entry.state.store(Blocked);
+        // A key that went down while this slice ran was pushed into keys but found the task
+        // Running, so take it back ourselves
+        uint8_t blocked = Blocked;
+        if (entry.keys.load() && entry.state.compare_exchange_strong(blocked, Queued))
+        {
+            Push(w, &entry);
+        }
+        return;
+    }
+
+    Bump(worker.frames);
+    if (options.frame_hz <= 0)
+    {
+        entry.state.store(Queued, std::memory_order_relaxed);
+        Push(w, &entry);
+        return;
+    }
+
+    // Next frame one period later, without bursting to catch up after a long block or stall
+    auto period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.frame_hz));
+    entry.due = std::max(entry.due + period, Clock::now());
+    entry.state.store(Sleeping, std::memory_order_relaxed);
+    worker.timers.push_back({entry.due, &entry});
+    std::push_heap(worker.timers.begin(), worker.timers.end(), std::greater<Timer>());
+}
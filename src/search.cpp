@@ -0,0 +1,235 @@
+#include "search.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+StateSet::StateSet(int bits) : mask((size_t{1} << std::max(4, std::min(bits, 40))) - 1)
+{
+    slots = new std::atomic<uint64_t>[mask + 1]();
+}
+
+StateSet::~StateSet()
+{
+    delete[] slots;
+}
+
+bool StateSet::Insert(uint64_t hash)
+{
+    uint64_t key = hash ? hash : 1;
+    size_t at = (key ^ (key >> 31)) & mask;
+    for (int probe = 0; probe < MAX_PROBE; ++probe, at = (at + 1) & mask)
+    {
+        uint64_t seen = slots[at].load(std::memory_order_relaxed);
+        if (seen == 0 && slots[at].compare_exchange_strong(seen, key, std::memory_order_relaxed))
+        {
+            return true;
+        }
+        // seen holds the winner when the exchange lost a race for this slot
+        if (seen == key)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void StateSet::Clear()
+{
+    for (size_t i = 0; i <= mask; ++i)
+    {
+        slots[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+Search::Search(Options const &options) : options(options)
+{
+    actions.push_back(NO_KEY);
+    for (int8_t key = 0; key < 16; ++key)
+    {
+        if (options.keys & (1u << key))
+        {
+            actions.push_back(key);
+        }
+    }
+    if (this->options.threads <= 0)
+    {
+        this->options.threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void Search::Apply(chip8 &machine, int8_t action, int frames)
+{
+    memset(machine.keypad, 0, sizeof(machine.keypad));
+    if (action != NO_KEY)
+    {
+        machine.keypad[action] = 1;
+    }
+    // Every action is exactly frames * instructions_per_frame instructions from a boundary
+    machine.frame_cycle = 0;
+    for (int i = 0; i < frames; ++i)
+    {
+        machine.Frame();
+    }
+}
+
+template <typename Fn>
+void Search::Parallel(size_t count, Fn &&fn)
+{
+    static constexpr size_t CHUNK = 16;
+    std::atomic<size_t> next{0};
+    for (Worker &worker : workers)
+    {
+        worker.loaded = nullptr; // states from the previous phase may be gone
+    }
+    auto work = [&](size_t worker) {
+        for (size_t begin; (begin = next.fetch_add(CHUNK, std::memory_order_relaxed)) < count;)
+        {
+            for (size_t i = begin; i < std::min(begin + CHUNK, count); ++i)
+            {
+                fn(worker, i);
+            }
+        }
+    };
+
+    size_t threads = std::min(workers.size(), (count + CHUNK - 1) / CHUNK);
+    std::vector<std::thread> pool;
+    for (size_t worker = 1; worker < threads; ++worker)
+    {
+        pool.emplace_back(work, worker);
+    }
+    work(0);
+    for (std::thread &thread : pool)
+    {
+        thread.join();
+    }
+}
+
+std::vector<int8_t> Search::Path(std::vector<std::vector<Trail>> const &trails, uint32_t last) const
+{
+    std::vector<int8_t> path(trails.size());
+    for (size_t level = trails.size(); level-- > 0;)
+    {
+        path[level] = trails[level][last].action;
+        last = trails[level][last].parent;
+    }
+    return path;
+}
+
+Search::Result Search::Run(chip8 const &start, Score const &score, Goal const &goal)
+{
+    Result result;
+    result.threads = options.threads;
+
+    workers.clear();
+    workers.reserve(options.threads);
+    for (int i = 0; i < options.threads; ++i)
+    {
+        workers.emplace_back(start);
+        workers.back().machine.trace = nullptr;
+    }
+
+    StateSet seen(options.table_bits);
+    seen.Insert(start.Hash());
+    auto began = std::chrono::steady_clock::now();
+
+    std::vector<PagedState> frontier(1);
+    workers[0].machine.Save(frontier[0]);
+    std::vector<std::vector<Trail>> trails;
+
+    std::vector<Candidate> children;
+
+    // Best state so far, as (level count, index into that level's trail)
+    int64_t best_score = score ? score(start) : 0;
+    size_t best_level = 0;
+    uint32_t best_index = 0;
+    size_t limit = options.beam_width > 0 ? static_cast<size_t>(options.beam_width) : options.max_states;
+
+    for (int level = 0; level < options.depth && !frontier.empty(); ++level)
+    {
+        // Expand: every frontier state by every action, keeping children nobody has seen
+        Parallel(frontier.size() * actions.size(), [&](size_t w, size_t i) {
+            Worker &worker = workers[w];
+            chip8 &machine = worker.machine;
+            uint32_t parent = static_cast<uint32_t>(i / actions.size());
+            int8_t action = actions[i % actions.size()];
+
+            // Consecutive items mostly share a parent, only the pages the last action wrote are copied
+            machine.Restore(frontier[parent], worker.loaded);
+            worker.loaded = &frontier[parent];
+            Apply(machine, action, options.frames_per_action);
+            ++worker.expanded;
+            if (!seen.Insert(machine.Hash()))
+            {
+                return;
+            }
+            ++worker.unique;
+            worker.found.push_back({parent, action, goal && goal(machine), score ? score(machine) : 0});
+        });
+
+        children.clear();
+        for (Worker &worker : workers)
+        {
+            children.insert(children.end(), worker.found.begin(), worker.found.end());
+            worker.found.clear();
+        }
+        // Threads finish in any order, sort so the kept set doesn't depend on scheduling
+        auto better = [](Candidate const &a, Candidate const &b) {
+            if (a.goal != b.goal)
+                return a.goal;
+            if (a.score != b.score)
+                return a.score > b.score;
+            return a.parent != b.parent ? a.parent < b.parent : a.action < b.action;
+        };
+        if (children.size() > limit)
+        {
+            std::nth_element(children.begin(), children.begin() + limit, children.end(), better);
+            children.resize(limit);
+        }
+        std::sort(children.begin(), children.end(), better);
+
+        trails.emplace_back(children.size());
+        for (size_t i = 0; i < children.size(); ++i)
+        {
+            trails.back()[i] = {children[i].parent, children[i].action};
+        }
+        result.levels = level + 1;
+
+        if (!children.empty() && (children[0].goal || children[0].score > best_score))
+        {
+            best_score = children[0].score;
+            best_level = trails.size();
+            best_index = 0;
+        }
+        if (!children.empty() && children[0].goal)
+        {
+            result.found = true;
+            break;
+        }
+
+        // Materialize the survivors as forks of their parent, sharing every page they didn't write
+        std::vector<PagedState> next(children.size());
+        Parallel(children.size(), [&](size_t w, size_t i) {
+            Worker &worker = workers[w];
+            PagedState const &parent = frontier[children[i].parent];
+            worker.machine.Restore(parent, worker.loaded);
+            Apply(worker.machine, children[i].action, options.frames_per_action);
+            next[i] = parent;
+            worker.machine.Save(next[i]);
+            worker.loaded = &next[i];
+        });
+        frontier.swap(next);
+    }
+
+    trails.resize(best_level);
+    result.actions = Path(trails, best_index);
+    result.score = best_score;
+    for (Worker const &worker : workers)
+    {
+        result.expanded += worker.expanded;
+        result.unique += worker.unique;
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - began).count();
+    return result;
+}
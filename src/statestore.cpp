@@ -0,0 +1,373 @@
+#include "statestore.h"
+
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static constexpr size_t INDEX_HEADER_SIZE = 64; // slots start cache line aligned
+
+static void *Map(int fd, size_t size)
+{
+    void *mapped = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return mapped == MAP_FAILED ? nullptr : mapped;
+}
+
+static uint64_t Mix(uint64_t h, uint64_t word)
+{
+    h ^= word;
+    h *= 0x9E3779B97F4A7C15ull;
+    return h ^ (h >> 32);
+}
+
+static uint64_t MixBytes(uint64_t h, void const *data, size_t size)
+{
+    uint8_t const *bytes = static_cast<uint8_t const *>(data);
+    for (size_t i = 0; i < size; i += 8)
+    {
+        uint64_t word = 0;
+        memcpy(&word, bytes + i, size - i < 8 ? size - i : 8);
+        h = Mix(h, word);
+    }
+    return h;
+}
+
+static bool Fail(std::string *error, std::string const &message)
+{
+    if (error)
+    {
+        *error = message;
+    }
+    return false;
+}
+
+// The engine is hashed by its bytes, it is plain data like the rest of a Snapshot
+uint64_t StateStore::Key(uint64_t digest, std::default_random_engine const &rng, uint8_t const *keypad)
+{
+    return MixBytes(MixBytes(digest, &rng, sizeof(rng)), keypad, sizeof(chip8::Snapshot::keypad));
+}
+
+uint64_t StateStore::Key(chip8 const &machine)
+{
+    return Key(machine.Digest(), machine.Random(), machine.keypad);
+}
+
+StateStore::~StateStore()
+{
+    Close();
+}
+
+bool StateStore::Open(char const *file, std::string *error)
+{
+    Close();
+    path = file;
+
+    data_fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    struct stat info{};
+    if (data_fd < 0 || fstat(data_fd, &info) != 0)
+    {
+        Close();
+        return Fail(error, "could not open " + path);
+    }
+
+    if (info.st_size == 0)
+    {
+        if (!MapData(MIN_CAPACITY))
+        {
+            Close();
+            return Fail(error, "could not map " + path);
+        }
+        header->magic = MAGIC;
+        header->version = VERSION;
+        header->record_size = sizeof(Record);
+        header->count = 0;
+    }
+    else
+    {
+        if (static_cast<size_t>(info.st_size) < HEADER_SIZE)
+        {
+            Close();
+            return Fail(error, path + " is not a state store");
+        }
+        if (!MapData((static_cast<size_t>(info.st_size) - HEADER_SIZE) / sizeof(Record)))
+        {
+            Close();
+            return Fail(error, "could not map " + path);
+        }
+        if (header->magic != MAGIC || header->version != VERSION)
+        {
+            Close();
+            return Fail(error, path + " is not a state store");
+        }
+        if (header->record_size != sizeof(Record))
+        {
+            Close();
+            return Fail(error, path + " was written by a build with a different snapshot layout");
+        }
+        if (header->count > capacity)
+        {
+            Close();
+            return Fail(error, path + " is truncated");
+        }
+    }
+    trim = true;
+
+    // The index is only trusted if it covers exactly the records there are
+    index_fd = open((path + ".idx").c_str(), O_RDWR | O_CREAT, 0644);
+    if (index_fd < 0 || fstat(index_fd, &info) != 0)
+    {
+        Close();
+        return Fail(error, "could not open " + path + ".idx");
+    }
+    if (static_cast<size_t>(info.st_size) > INDEX_HEADER_SIZE)
+    {
+        index_size = static_cast<size_t>(info.st_size);
+        index = static_cast<uint8_t *>(Map(index_fd, index_size));
+        if (index)
+        {
+            index_header = reinterpret_cast<IndexHeader *>(index);
+            slots = reinterpret_cast<Slot *>(index + INDEX_HEADER_SIZE);
+            uint64_t slot_count = index_header->capacity;
+            bool valid = index_header->magic == MAGIC && index_header->version == INDEX_VERSION && slot_count &&
+                         (slot_count & (slot_count - 1)) == 0 &&
+                         index_size == INDEX_HEADER_SIZE + slot_count * sizeof(Slot) &&
+                         index_header->count == header->count;
+            if (valid)
+            {
+                return true;
+            }
+            // Not carried over by BuildIndex, the records are the truth
+            index_header->count = ~0ull;
+        }
+    }
+
+    uint64_t slot_count = MIN_CAPACITY;
+    while (slot_count < 2 * (header->count + 1))
+    {
+        slot_count *= 2;
+    }
+    if (!BuildIndex(slot_count))
+    {
+        Close();
+        return Fail(error, "could not build " + path + ".idx");
+    }
+    return true;
+}
+
+void StateStore::Close()
+{
+    if (data)
+    {
+        uint64_t count = header->count;
+        munmap(data, data_size);
+        // Drop the unused tail the last growth reserved, only from a file known to be a store
+        if (trim && ftruncate(data_fd, static_cast<off_t>(HEADER_SIZE + count * sizeof(Record))) != 0)
+        {
+            // Harmless, the file keeps its spare room and count still says where records end
+        }
+    }
+    if (index)
+    {
+        munmap(index, index_size);
+    }
+    if (data_fd >= 0)
+    {
+        close(data_fd);
+    }
+    if (index_fd >= 0)
+    {
+        close(index_fd);
+    }
+    data_fd = index_fd = -1;
+    data = index = nullptr;
+    data_size = index_size = 0;
+    header = nullptr;
+    records = nullptr;
+    index_header = nullptr;
+    slots = nullptr;
+    capacity = 0;
+    trim = false;
+}
+
+void StateStore::Sync()
+{
+    if (data)
+    {
+        msync(data, data_size, MS_SYNC);
+    }
+    if (index)
+    {
+        msync(index, index_size, MS_SYNC);
+    }
+}
+
+// The new mapping replaces the old one only once it exists: a growth that fails (a full disk)
+// leaves the store as it was.
+bool StateStore::MapData(uint64_t records_wanted)
+{
+    // Only ever grows the file, Open maps an existing one before knowing it is a store
+    size_t size = HEADER_SIZE + records_wanted * sizeof(Record);
+    struct stat info{};
+    if (fstat(data_fd, &info) != 0 ||
+        (static_cast<size_t>(info.st_size) < size && ftruncate(data_fd, static_cast<off_t>(size)) != 0))
+    {
+        return false;
+    }
+    uint8_t *mapped = static_cast<uint8_t *>(Map(data_fd, size));
+    if (!mapped)
+    {
+        return false;
+    }
+    if (data)
+    {
+        munmap(data, data_size);
+    }
+    data = mapped;
+    data_size = size;
+    header = reinterpret_cast<Header *>(data);
+    records = reinterpret_cast<Record *>(data + HEADER_SIZE);
+    capacity = records_wanted;
+    return true;
+}
+
+bool StateStore::BuildIndex(uint64_t slot_count)
+{
+    // Carry the current table over when it is up to date, otherwise read every record's digest.
+    // A stale table is worth nothing and goes first; an up to date one (growth from Append) stays
+    // mapped until its replacement is, so a failed growth leaves it working.
+    std::vector<Slot> carried;
+    bool from_records = !index_header || index_header->count != header->count;
+    if (!from_records)
+    {
+        carried.reserve(header->count);
+        for (uint64_t i = 0; i < index_header->capacity; ++i)
+        {
+            if (slots[i].record)
+            {
+                carried.push_back(slots[i]);
+            }
+        }
+    }
+    else if (index)
+    {
+        munmap(index, index_size);
+        index = nullptr;
+        index_header = nullptr;
+        slots = nullptr;
+        index_size = 0;
+    }
+
+    size_t size = INDEX_HEADER_SIZE + slot_count * sizeof(Slot);
+    if (ftruncate(index_fd, static_cast<off_t>(size)) != 0)
+    {
+        return false;
+    }
+    uint8_t *mapped = static_cast<uint8_t *>(Map(index_fd, size));
+    if (!mapped)
+    {
+        return false;
+    }
+    // The file still holds the old table, start from empty slots
+    memset(mapped, 0, size);
+    if (index)
+    {
+        munmap(index, index_size);
+    }
+    index = mapped;
+    index_size = size;
+    index_header = reinterpret_cast<IndexHeader *>(index);
+    slots = reinterpret_cast<Slot *>(index + INDEX_HEADER_SIZE);
+    index_header->magic = MAGIC;
+    index_header->version = INDEX_VERSION;
+    index_header->capacity = slot_count;
+
+    if (from_records)
+    {
+        for (uint64_t record = 0; record < header->count; ++record)
+        {
+            Record const &stored = records[record];
+            Insert(Key(stored.digest, stored.snapshot.rng, stored.snapshot.keypad), record);
+        }
+    }
+    else
+    {
+        for (Slot const &slot : carried)
+        {
+            Insert(slot.key, slot.record - 1);
+        }
+    }
+    index_header->count = header->count;
+    return true;
+}
+
+void StateStore::Insert(uint64_t key, uint64_t record)
+{
+    uint64_t mask = index_header->capacity - 1;
+    for (uint64_t i = key & mask;; i = (i + 1) & mask)
+    {
+        if (!slots[i].record)
+        {
+            slots[i].key = key;
+            slots[i].record = record + 1;
+            return;
+        }
+    }
+}
+
+uint64_t StateStore::Find(uint64_t key) const
+{
+    if (!slots)
+    {
+        return NOT_FOUND;
+    }
+    uint64_t mask = index_header->capacity - 1;
+    for (uint64_t i = key & mask; slots[i].record; i = (i + 1) & mask)
+    {
+        if (slots[i].key == key)
+        {
+            return slots[i].record - 1;
+        }
+    }
+    return NOT_FOUND;
+}
+
+uint64_t StateStore::Append(chip8 const &machine, bool *added)
+{
+    uint64_t digest = machine.Digest();
+    uint64_t key = Key(digest, machine.Random(), machine.keypad);
+    uint64_t found = Find(key);
+    if (added)
+    {
+        *added = false;
+    }
+    if (found != NOT_FOUND)
+    {
+        return found;
+    }
+
+    uint64_t record = header->count;
+    if (record == capacity && !MapData(capacity < MIN_CAPACITY ? MIN_CAPACITY : capacity * 2))
+    {
+        return NOT_FOUND;
+    }
+    if (2 * (record + 1) > index_header->capacity && !BuildIndex(index_header->capacity * 2))
+    {
+        return NOT_FOUND;
+    }
+
+    // Record first, then the counts, so a crash in between leaves a store that reopens to the
+    // records before it (and an index that gets rebuilt)
+    records[record].digest = digest;
+    machine.Save(records[record].snapshot);
+    header->count = record + 1;
+    Insert(key, record);
+    index_header->count = header->count;
+    if (added)
+    {
+        *added = true;
+    }
+    return record;
+}
@@ -0,0 +1,167 @@
+#include "telemetry.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // macOS, SO_NOSIGPIPE is set on each client instead
+#endif
+
+Telemetry::~Telemetry()
+{
+    Close();
+}
+
+bool Telemetry::Open(char const *target, int interval)
+{
+    Close();
+    interval_ms = interval > 0 ? interval : 1000;
+
+    if (strncmp(target, "unix:", 5) == 0)
+    {
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (strlen(target + 5) >= sizeof(address.sun_path))
+        {
+            return false;
+        }
+        strcpy(address.sun_path, target + 5);
+        strcpy(socket_path, target + 5);
+
+        listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(socket_path);
+        if (listener < 0 || bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            listen(listener, 8) != 0)
+        {
+            Close();
+            return false;
+        }
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+    }
+    else
+    {
+        file = fopen(target, "a");
+        if (!file)
+        {
+            return false;
+        }
+    }
+
+    stop = false;
+    exporter = std::thread(&Telemetry::Export, this);
+    return true;
+}
+
+void Telemetry::Close()
+{
+    if (exporter.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+        }
+        wake.notify_all();
+        exporter.join();
+    }
+    for (int client : clients)
+    {
+        close(client);
+    }
+    clients.clear();
+    if (listener >= 0)
+    {
+        close(listener);
+        unlink(socket_path);
+        listener = -1;
+    }
+    if (file)
+    {
+        fclose(file);
+        file = nullptr;
+    }
+}
+
+size_t Telemetry::Format(char *out, size_t size, double seconds, double interval, uint64_t (&previous)[COUNT])
+{
+    uint64_t now[COUNT];
+    uint64_t delta[COUNT];
+    for (int i = 0; i < COUNT; ++i)
+    {
+        now[i] = counters[i].load(std::memory_order_relaxed);
+        delta[i] = now[i] - previous[i];
+        previous[i] = now[i];
+    }
+    auto rate = [interval](uint64_t count) { return interval > 0 ? count / interval : 0.0; };
+    auto average = [](uint64_t total, uint64_t calls) { return calls ? total / calls : 0; };
+    uint64_t latency_peak = latency_max.exchange(0, std::memory_order_relaxed);
+
+    int length = snprintf(
+        out, size,
+        "c8stats t=%.3f instructions=%llu ips=%.0f frames=%llu fps=%.1f presented=%llu presented_fps=%.1f "
+        "cycle_ns=%llu input_ns=%llu update_ns=%llu latency_us=%llu latency_max_us=%llu latency_samples=%llu\n",
+        seconds, static_cast<unsigned long long>(now[Instructions]), rate(delta[Instructions]),
+        static_cast<unsigned long long>(now[Frames]), rate(delta[Frames]),
+        static_cast<unsigned long long>(now[Presented]), rate(delta[Presented]),
+        static_cast<unsigned long long>(average(delta[CycleNs], delta[CycleCalls])),
+        static_cast<unsigned long long>(average(delta[InputNs], delta[InputCalls])),
+        static_cast<unsigned long long>(average(delta[UpdateNs], delta[UpdateCalls])),
+        static_cast<unsigned long long>(average(delta[LatencyNs], delta[LatencySamples]) / 1000),
+        static_cast<unsigned long long>(latency_peak / 1000),
+        static_cast<unsigned long long>(delta[LatencySamples]));
+    return length < 0 ? 0 : std::min(static_cast<size_t>(length), size - 1);
+}
+
+void Telemetry::Write(char const *line, size_t length)
+{
+    if (file)
+    {
+        fwrite(line, 1, length, file);
+        fflush(file);
+        return;
+    }
+
+    for (int client; (client = accept(listener, nullptr, nullptr)) >= 0;)
+    {
+#ifdef SO_NOSIGPIPE
+        int on = 1;
+        setsockopt(client, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+        fcntl(client, F_SETFL, fcntl(client, F_GETFL) | O_NONBLOCK);
+        clients.push_back(client);
+    }
+    // A client too slow to take a whole line is dropped rather than blocking the exporter
+    for (size_t i = 0; i < clients.size();)
+    {
+        if (send(clients[i], line, length, MSG_NOSIGNAL) != static_cast<ssize_t>(length))
+        {
+            close(clients[i]);
+            clients.erase(clients.begin() + i);
+            continue;
+        }
+        ++i;
+    }
+}
+
+void Telemetry::Export()
+{
+    auto start = Clock::now();
+    auto last = start;
+    uint64_t previous[COUNT]{};
+    char line[512];
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!wake.wait_for(lock, std::chrono::milliseconds(interval_ms), [this] { return stop; }))
+    {
+        auto now = Clock::now();
+        double seconds = std::chrono::duration<double>(now - start).count();
+        double interval = std::chrono::duration<double>(now - last).count();
+        last = now;
+        size_t length = Format(line, sizeof(line), seconds, interval, previous);
+        Write(line, length);
+    }
+}
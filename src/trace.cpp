@@ -0,0 +1,24 @@
+#include "trace.h"
+
+bool TraceRing::Save(char const *filename) const
+{
+    FILE *file = fopen(filename, "wb");
+    if (!file)
+    {
+        return false;
+    }
+
+    uint32_t version = 1;
+    uint64_t count = Count();
+    bool ok = fwrite("C8TR", 1, 4, file) == 4 &&
+              fwrite(&version, sizeof(version), 1, file) == 1 &&
+              fwrite(&count, sizeof(count), 1, file) == 1;
+
+    // At most two contiguous spans, oldest first.
+    size_t start = (head - count) & mask;
+    size_t first = count < size - start ? count : size - start;
+    ok = ok && fwrite(entries + start, sizeof(TraceEntry), first, file) == first;
+    ok = ok && fwrite(entries, sizeof(TraceEntry), count - first, file) == count - first;
+
+    return fclose(file) == 0 && ok;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+// Minimal test harness, no dependencies: TEST registers a function, CHECK / CHECK_EQ record
+// failures without aborting the test, RunTests runs everything and returns the exit code.
+
+#include <cstdio>
+#include <vector>
+
+struct TestCase
+{
+    char const *name;
+    void (*fn)();
+};
+
+inline std::vector<TestCase> &Tests()
+{
+    static std::vector<TestCase> tests;
+    return tests;
+}
+
+inline int &Failures()
+{
+    static int failures = 0;
+    return failures;
+}
+
+struct TestRegistrar
+{
+    TestRegistrar(char const *name, void (*fn)())
+    {
+        Tests().push_back({name, fn});
+    }
+};
+
+#define TEST(name)                                         \
+    static void name();                                    \
+    static TestRegistrar name##_registrar(#name, &name);   \
+    static void name()
+
+#define CHECK(cond)                                                          \
+    do                                                                       \
+    {                                                                        \
+        if (!(cond))                                                         \
+        {                                                                    \
+            printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            ++Failures();                                                    \
+        }                                                                    \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                          \
+    do                                                                                          \
+    {                                                                                           \
+        long long check_a = static_cast<long long>(a);                                          \
+        long long check_b = static_cast<long long>(b);                                          \
+        if (check_a != check_b)                                                                 \
+        {                                                                                       \
+            printf("  %s:%d: %s == %s failed (0x%llX vs 0x%llX)\n", __FILE__, __LINE__, #a, #b, \
+                   check_a, check_b);                                                           \
+            ++Failures();                                                                       \
+        }                                                                                       \
+    } while (0)
+
+inline int RunTests(char const *suite)
+{
+    int failed_tests = 0;
+    for (TestCase const &test : Tests())
+    {
+        int before = Failures();
+        test.fn();
+        if (Failures() != before)
+        {
+            printf("FAIL %s.%s\n", suite, test.name);
+            ++failed_tests;
+        }
+    }
+    printf("%s: %zu tests, %d failed\n", suite, Tests().size(), failed_tests);
+    return failed_tests ? 1 : 0;
+}
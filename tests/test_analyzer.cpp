@@ -0,0 +1,246 @@
+// Control flow recovery must follow every edge the interpreter can take, and what it finds about
+// I (sprite data, stores into code) must survive the hints file.
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+
+#include "analyzer.h"
+#include "check.h"
+#include "chip8.h"
+
+// Program words from DATA_START into a fresh memory image, returns the ROM size
+static size_t Load(uint8_t *image, std::initializer_list<uint16_t> program)
+{
+    memset(image, 0, chip8::MEM_SIZE);
+    size_t size = 0;
+    for (uint16_t op : program)
+    {
+        image[chip8::DATA_START + size++] = op >> 8u;
+        image[chip8::DATA_START + size++] = op & 0xFFu;
+    }
+    return size;
+}
+
+static bool All(RomAnalysis const &analysis, uint16_t start, unsigned length, uint8_t flag)
+{
+    for (unsigned k = 0; k < length; ++k)
+    {
+        if (!(analysis.flags[start + k] & flag))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+TEST(skips_with_a_low_nibble_have_both_edges)
+{
+    // 204: SE V1, V2 written 5121, the interpreter skips the jump at 206 onto 208
+    static uint8_t const ROM[] = {0x61, 0x03, 0x62, 0x03, 0x51, 0x21, 0x12, 0x00, 0x71, 0x01, 0x92, 0x1F, 0x12, 0x00};
+    static chip8 c(1);
+    c.LoadROM(ROM, sizeof(ROM));
+    RomAnalysis analysis = RomAnalysis::Analyze(c.memory, sizeof(ROM));
+
+    RomAnalysis::Block const *entry = analysis.Find(0x200);
+    CHECK(entry != nullptr);
+    if (entry)
+    {
+        CHECK(entry->exit == RomAnalysis::Exit::Skip);
+        CHECK_EQ(entry->end, 0x206);
+        CHECK_EQ(entry->successor_count, 2);
+        CHECK_EQ(entry->successors[0], 0x206);
+        CHECK_EQ(entry->successors[1], 0x208);
+    }
+    CHECK(analysis.flags[0x208] & RomAnalysis::LEADER);
+    CHECK(!(analysis.flags[0x208] & RomAnalysis::DATA));
+
+    // 20A: SNE V2, V1 written 921F, same again
+    RomAnalysis::Block const *skipped = analysis.Find(0x208);
+    CHECK(skipped != nullptr);
+    if (skipped)
+    {
+        CHECK(skipped->exit == RomAnalysis::Exit::Skip);
+        CHECK_EQ(skipped->successors[1], 0x20E);
+    }
+}
+
+TEST(annn_follows_i_across_blocks_to_sprite_data)
+{
+    static uint8_t image[chip8::MEM_SIZE];
+    size_t size = Load(image, {
+        0xA20E, // 200 I = 20E
+        0x1206, // 202 into another block
+        0x0000, // 204 unreachable
+        0xD013, // 206 draws 3 rows at I
+        0xF165, // 208 reads V0-V1 from I
+        0x120A, // 20A halt
+        0x0000, // 20C unreachable
+        0xF0F0, // 20E sprite, 3 bytes
+        0xF000,
+    });
+    RomAnalysis analysis = RomAnalysis::Analyze(image, size);
+    CHECK(All(analysis, 0x20E, 3, RomAnalysis::DATA));
+    CHECK(!(analysis.flags[0x211] & RomAnalysis::DATA));
+    CHECK(!(analysis.flags[0x20E] & RomAnalysis::CODE));
+    CHECK(!(analysis.flags[0x204] & RomAnalysis::INSTRUCTION));
+    RomAnalysis::Block const *halt = analysis.Find(0x20A);
+    CHECK(halt != nullptr && halt->exit == RomAnalysis::Exit::Halt);
+}
+
+TEST(i_is_unknown_where_paths_disagree)
+{
+    static uint8_t image[chip8::MEM_SIZE];
+    size_t size = Load(image, {
+        0xA300, // 200 I = 300
+        0x3000, // 202 skip on V0
+        0xA310, // 204 I = 310 unless skipped, both paths reach 206
+        0xD011, // 206 draw through either
+        0xA320, // 208 I = 320
+        0xF01E, // 20A I += V0
+        0xD011, // 20C draw through an unknown I
+        0x120E, // 20E halt
+    });
+    RomAnalysis analysis = RomAnalysis::Analyze(image, size);
+    CHECK(!(analysis.flags[0x300] & RomAnalysis::DATA));
+    CHECK(!(analysis.flags[0x310] & RomAnalysis::DATA));
+    CHECK(!(analysis.flags[0x320] & RomAnalysis::DATA));
+}
+
+TEST(stores_into_code_mark_it_self_modifying)
+{
+    static uint8_t image[chip8::MEM_SIZE];
+    size_t size = Load(image, {
+        0xA208, // 200 I = 208
+        0xF155, // 202 stores V0-V1 over 208-209
+        0x1206, // 204
+        0x2210, // 206 call, the return site 208 is rewritten
+        0x6001, // 208
+        0x120A, // 20A halt
+        0x0000, // 20C
+        0x0000, // 20E
+        0xF01E, // 210 I += V0
+        0xF033, // 212 BCD through an unknown I
+        0x00EE, // 214
+    });
+    RomAnalysis analysis = RomAnalysis::Analyze(image, size);
+    CHECK(All(analysis, 0x208, 2, RomAnalysis::WRITTEN));
+    CHECK(!(analysis.flags[0x20A] & RomAnalysis::WRITTEN));
+
+    RomAnalysis::Block const *entry = analysis.Find(0x200);
+    RomAnalysis::Block const *written = analysis.Find(0x208);
+    RomAnalysis::Block const *callee = analysis.Find(0x210);
+    CHECK(entry && written && callee);
+    if (entry && written && callee)
+    {
+        CHECK(!entry->self_modifying);
+        CHECK(!entry->unknown_store);
+        CHECK(written->self_modifying);
+        CHECK(callee->unknown_store);
+        CHECK(!callee->self_modifying);
+    }
+}
+
+TEST(bnnn_is_flagged_and_not_followed)
+{
+    static uint8_t image[chip8::MEM_SIZE];
+    size_t size = Load(image, {
+        0x6002, // 200
+        0xB208, // 202 jump to 208 + V0
+        0x0000, // 204
+        0x0000, // 206
+        0x1208, // 208 only reachable through V0
+    });
+    RomAnalysis analysis = RomAnalysis::Analyze(image, size);
+    CHECK(analysis.flags[0x202] & RomAnalysis::INDIRECT);
+    CHECK(!(analysis.flags[0x208] & RomAnalysis::INSTRUCTION));
+    CHECK_EQ(analysis.blocks.size(), 1);
+    RomAnalysis::Block const *entry = analysis.Find(0x200);
+    CHECK(entry != nullptr);
+    if (entry)
+    {
+        CHECK(entry->exit == RomAnalysis::Exit::Indirect);
+        CHECK_EQ(entry->successor_count, 0);
+        CHECK_EQ(entry->end, 0x204);
+    }
+}
+
+TEST(hints_round_trip)
+{
+    static uint8_t image[chip8::MEM_SIZE];
+    size_t size = Load(image, {
+        0xA212, // 200 I = 212
+        0xD012, // 202 draw 212-213
+        0xF055, // 204 store over 212, data is written too
+        0x3000, // 206 skip
+        0x2210, // 208 call
+        0xB200, // 20A indirect
+        0x0000, // 20C
+        0x0000, // 20E
+        0x00EE, // 210
+        0xF0F0, // 212 sprite
+    });
+    RomAnalysis analysis = RomAnalysis::Analyze(image, size);
+
+    FILE *file = tmpfile();
+    CHECK(file != nullptr);
+    if (!file)
+    {
+        return;
+    }
+    analysis.WriteHints(file);
+    rewind(file);
+    static RomAnalysis back;
+    CHECK(RomAnalysis::ReadHints(file, back));
+    fclose(file);
+
+    CHECK_EQ(back.blocks.size(), analysis.blocks.size());
+    for (size_t b = 0; b < back.blocks.size() && b < analysis.blocks.size(); ++b)
+    {
+        RomAnalysis::Block const &want = analysis.blocks[b];
+        RomAnalysis::Block const &got = back.blocks[b];
+        CHECK_EQ(got.start, want.start);
+        CHECK_EQ(got.end, want.end);
+        CHECK(got.exit == want.exit);
+        CHECK_EQ(got.successor_count, want.successor_count);
+        for (uint8_t s = 0; s < want.successor_count; ++s)
+        {
+            CHECK_EQ(got.successors[s], want.successors[s]);
+        }
+        CHECK_EQ(got.self_modifying, want.self_modifying);
+        CHECK_EQ(got.unknown_store, want.unknown_store);
+    }
+    // Everything but WRITTEN, which the format leaves out
+    uint8_t kept = RomAnalysis::CODE | RomAnalysis::INSTRUCTION | RomAnalysis::LEADER | RomAnalysis::DATA |
+                   RomAnalysis::INDIRECT;
+    for (unsigned address = 0; address < chip8::MEM_SIZE; ++address)
+    {
+        if ((back.flags[address] & kept) != (analysis.flags[address] & kept))
+        {
+            CHECK_EQ(address, ~0u);
+            break;
+        }
+    }
+    CHECK(analysis.flags[0x212] & RomAnalysis::DATA);
+    CHECK(analysis.flags[0x20A] & RomAnalysis::INDIRECT);
+}
+
+TEST(bad_hints_are_refused)
+{
+    static RomAnalysis out;
+    char const *bad[] = {"", "c8hints 2\n", "c8hints 1\nblock 200 1FE 0 0 0 0 0 0\n",
+                         "c8hints 1\nblock 200 202 9 0 0 0 0 0\n", "c8hints 1\ndata FFF 2\n",
+                         "c8hints 1\nbogus\n"};
+    for (char const *text : bad)
+    {
+        FILE *file = tmpfile();
+        fputs(text, file);
+        rewind(file);
+        CHECK(!RomAnalysis::ReadHints(file, out));
+        fclose(file);
+    }
+}
+
+int main()
+{
+    return RunTests("analyzer");
+}
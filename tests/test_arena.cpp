@@ -0,0 +1,102 @@
+// Arena allocation, topology queries and a small batch run.
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "arena.h"
+#include "batch.h"
+#include "check.h"
+#include "chip8.h"
+#include "numa.h"
+
+TEST(arena_aligns_and_fills_up)
+{
+    Arena arena(4096, Topology::NodeOf(0));
+    void *a = arena.Allocate(3, 1);
+    void *b = arena.Allocate(8, 64);
+    CHECK(a != nullptr);
+    CHECK_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0);
+    CHECK(arena.Allocate(8192) == nullptr);
+    arena.Reset();
+    CHECK_EQ(arena.Used(), 0);
+    CHECK(arena.Allocate(4096, 1) != nullptr);
+}
+
+TEST(arena_constructs_objects)
+{
+    Arena arena(1 << 20);
+    chip8 *c = arena.New<chip8>(7u);
+    CHECK(c != nullptr);
+    CHECK_EQ(c->pc, chip8::DATA_START);
+    uint32_t *zeros = arena.Array<uint32_t>(100);
+    CHECK(zeros != nullptr);
+    CHECK_EQ(zeros[99], 0);
+    c->~chip8();
+}
+
+TEST(topology_is_consistent)
+{
+    CHECK(!Topology::Cpus().empty());
+    CHECK(Topology::Nodes() >= 1);
+    std::vector<int> ids = Topology::NodeIds();
+    CHECK_EQ(ids.size(), static_cast<size_t>(Topology::Nodes()));
+    int node = Topology::NodeOf(Topology::Cpus()[0]);
+    CHECK(std::find(ids.begin(), ids.end(), node) != ids.end());
+}
+
+TEST(node_lists_can_have_gaps)
+{
+    CHECK(Topology::ParseList("0,2\n") == (std::vector<int>{0, 2}));
+    CHECK(Topology::ParseList("0-3,8,10-11") == (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+    CHECK(Topology::ParseList("5") == (std::vector<int>{5}));
+    CHECK(Topology::ParseList("").empty());
+    CHECK(Topology::ParseList("\n").empty());
+}
+
+TEST(batch_counts_every_instruction)
+{
+    static const uint8_t LOOP[] = {0x70, 0x01, 0xA3, 0x00, 0xF0, 0x55, 0x12, 0x00};
+    Batch::Options options;
+    options.instances = 37;
+    options.frames = 10;
+    options.workers = 2;
+    options.trace_capacity = 16;
+    Batch::Result result = Batch::Run(LOOP, sizeof(LOOP), options);
+    CHECK(!result.nodes.empty());
+    CHECK_EQ(result.instructions, 37ull * 10 * options.instructions_per_frame);
+
+    size_t instances = 0;
+    for (Batch::Node const &node : result.nodes)
+    {
+        instances += node.instances;
+    }
+    CHECK_EQ(instances, 37);
+}
+
+TEST(arena_refuses_overflowing_sizes)
+{
+    Arena arena(4096);
+    CHECK(arena.Array<uint64_t>(SIZE_MAX / 4) == nullptr);
+    CHECK(arena.Allocate(SIZE_MAX) == nullptr);
+    CHECK_EQ(arena.Used(), 0);
+}
+
+TEST(batch_reports_allocation_failure)
+{
+    // Far more than fits, must come back empty rather than crash tearing down
+    static const uint8_t LOOP[] = {0x12, 0x00};
+    Batch::Options options;
+    options.instances = SIZE_MAX / 4;
+    options.frames = 1;
+    options.workers = 1;
+    for (bool local : {true, false})
+    {
+        options.local = local;
+        CHECK(Batch::Run(LOOP, sizeof(LOOP), options).nodes.empty());
+    }
+}
+
+int main()
+{
+    return RunTests("arena");
+}
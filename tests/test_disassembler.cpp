@@ -0,0 +1,51 @@
+// Disassembly must decode opcodes the way the interpreter executes them.
+#include <string>
+
+#include "check.h"
+#include "chip8.h"
+#include "disassembler.h"
+
+static std::string Text(uint16_t opcode)
+{
+    char out[32];
+    Disassembler::Format(opcode, out, sizeof(out));
+    return out;
+}
+
+TEST(formats_operands)
+{
+    CHECK(Text(0x00E0) == "CLS");
+    CHECK(Text(0x1234) == "JP 0x234");
+    CHECK(Text(0x6A2F) == "LD VA, 0x2F");
+    CHECK(Text(0x8124) == "ADD V1, V2");
+    CHECK(Text(0xD125) == "DRW V1, V2, 5");
+    CHECK(Text(0xF233) == "LD B, V2");
+    CHECK(Text(0x8128) == "DW 0x8128");
+    CHECK(std::string(Disassembler::Handler(0xE0FF)) == "OP_NULL");
+}
+
+TEST(skips_ignore_the_low_nibble_like_the_core)
+{
+    // 5121 with V1 == V2 skips when executed, so it is an instruction, not data
+    static chip8 c(1);
+    c.Reset(1);
+    uint8_t const rom[] = {0x51, 0x21, 0x00, 0x00, 0x91, 0x2F};
+    c.LoadROM(rom, sizeof(rom));
+    c.Cycle();
+    CHECK_EQ(c.pc, 0x204);
+    c.Cycle();
+    CHECK_EQ(c.pc, 0x206);
+
+    CHECK(Text(0x5121) == "SE V1, V2");
+    CHECK(Text(0x912F) == "SNE V1, V2");
+    for (uint16_t n = 0; n < 16; ++n)
+    {
+        CHECK(std::string(Disassembler::Handler(0x5120 | n)) == "OP_5xy0");
+        CHECK(std::string(Disassembler::Handler(0x9120 | n)) == "OP_9xy0");
+    }
+}
+
+int main()
+{
+    return RunTests("disassembler");
+}
@@ -0,0 +1,109 @@
+// Dispatch::Direct must execute every one of the 65536 opcodes exactly like the tables.
+#include <cstring>
+#include <random>
+
+#include "check.h"
+#include "chip8.h"
+
+// A machine with random memory, registers, timers, keys and quirks, and op at pc
+static void Randomize(chip8 &c, std::mt19937 &gen, uint16_t op)
+{
+    c.Reset(gen());
+    for (uint8_t &byte : c.memory)
+        byte = gen();
+    for (uint8_t &v : c.v_registers)
+        v = gen();
+    for (uint16_t &entry : c.stack)
+        entry = gen() & chip8::MEM_END;
+    for (uint8_t &key : c.keypad)
+        key = gen() & 1u;
+    for (uint32_t &px : c.video)
+        px = (gen() & 1u) ? 0xFFFFFFFFu : 0u;
+    c.sp = gen() & (chip8::REGISTER_STACK_SIZE - 1);
+    c.index = gen() & chip8::MEM_END;
+    c.delay_timer = gen();
+    c.sound_timer = gen();
+    c.pc = (chip8::DATA_START + (gen() & 0x7FEu)) & chip8::MEM_END;
+    c.quirks = gen() & 0x1Fu;
+    c.memory[c.pc] = op >> 8u;
+    c.memory[c.pc + 1] = op & 0xFFu;
+    c.Rehash();
+}
+
+// Same state, one instruction each way, compared field by field
+static bool Matches(chip8 &tables, chip8 &direct)
+{
+    tables.dispatch = chip8::Dispatch::Tables;
+    direct.dispatch = chip8::Dispatch::Direct;
+    tables.Cycle();
+    direct.Cycle();
+    return tables.Digest() == direct.Digest() && tables.pc == direct.pc && tables.index == direct.index &&
+           tables.sp == direct.sp && memcmp(tables.v_registers, direct.v_registers, 16) == 0 &&
+           memcmp(tables.memory, direct.memory, sizeof(tables.memory)) == 0 &&
+           memcmp(tables.video, direct.video, sizeof(tables.video)) == 0 && tables.dirty_pages == direct.dirty_pages;
+}
+
+TEST(every_opcode_matches_tables)
+{
+    static chip8 tables(1);
+    static chip8 direct(1);
+    std::mt19937 gen(7);
+    int mismatches = 0;
+    for (uint32_t op = 0; op <= 0xFFFF; ++op)
+    {
+        // Two states per opcode so both outcomes of most skips and carries come up
+        for (int trial = 0; trial < 2; ++trial)
+        {
+            Randomize(tables, gen, static_cast<uint16_t>(op));
+            direct = tables;
+            if (!Matches(tables, direct) && mismatches++ < 8)
+            {
+                printf("  %04X differs\n", op);
+            }
+        }
+    }
+    CHECK_EQ(mismatches, 0);
+}
+
+TEST(random_numbers_stay_in_step)
+{
+    static chip8 tables(3);
+    static chip8 direct(3);
+    uint8_t program[] = {0xC0, 0xFF, 0xC1, 0x0F, 0x12, 0x00};
+    tables.LoadROM(program, sizeof(program));
+    direct.LoadROM(program, sizeof(program));
+    direct.dispatch = chip8::Dispatch::Direct;
+    tables.Run(3000);
+    direct.Run(3000);
+    CHECK_EQ(tables.Digest(), direct.Digest());
+    CHECK_EQ(tables.v_registers[0], direct.v_registers[0]);
+    CHECK_EQ(tables.cycles, direct.cycles);
+}
+
+TEST(run_stops_the_same_way)
+{
+    static chip8 tables(5);
+    static chip8 direct(5);
+    // Draws a font digit forever, stopping on draws and on a breakpoint
+    uint8_t program[] = {0x60, 0x05, 0xF0, 0x29, 0x00, 0xE0, 0xD0, 0x05, 0x12, 0x04};
+    for (chip8 *c : {&tables, &direct})
+    {
+        c->LoadROM(program, sizeof(program));
+        c->SetBreakpoint(0x208);
+    }
+    direct.dispatch = chip8::Dispatch::Direct;
+    for (int i = 0; i < 10; ++i)
+    {
+        chip8::RunResult a = tables.Run(100, chip8::STOP_DRAW);
+        chip8::RunResult b = direct.Run(100, chip8::STOP_DRAW);
+        CHECK_EQ(static_cast<int>(a.reason), static_cast<int>(b.reason));
+        CHECK_EQ(a.address, b.address);
+        CHECK_EQ(a.executed, b.executed);
+    }
+    CHECK_EQ(tables.Digest(), direct.Digest());
+}
+
+int main()
+{
+    return RunTests("dispatch");
+}
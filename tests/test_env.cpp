@@ -0,0 +1,150 @@
+// EnvServer stepped by an EnvClient over a real socket and shared memory must match machines
+// stepped directly.
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <unistd.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "env.h"
+
+// Adds 1 to the byte at 0x300 every frame while key 5 is held, draws it as a digit, and sets 0x301
+// once it reaches 3. Both sides of each branch take the same number of instructions, so at 12
+// instructions per frame every frame is exactly one pass.
+static uint8_t const ROM[] = {
+    0x00, 0xE0, // 200 CLS
+    0xA3, 0x00, // 202 LD I, 300
+    0xF1, 0x65, // 204 LD V0..V1, [I]
+    0x62, 0x05, // 206 LD V2, 5
+    0xE2, 0x9E, // 208 SKP V2
+    0x12, 0x0E, // 20A JP 20E
+    0x70, 0x01, // 20C ADD V0, 1
+    0x30, 0x03, // 20E SE V0, 3
+    0x12, 0x14, // 210 JP 214
+    0x61, 0x01, // 212 LD V1, 1
+    0xF1, 0x55, // 214 LD [I], V0..V1
+    0xF0, 0x29, // 216 LD F, V0
+    0xD3, 0x35, // 218 DRW V3, V3, 5
+    0x12, 0x00, // 21A JP 200
+};
+
+struct Fixture
+{
+    EnvServer server;
+    EnvClient client;
+    std::thread thread;
+    std::string socket_path = "/tmp/c8env_test_" + std::to_string(getpid()) + ".sock";
+    std::string shm_name = "/c8env_test_" + std::to_string(getpid());
+
+    bool Start(EnvServer::Options const &options)
+    {
+        if (!server.Open(socket_path.c_str(), shm_name.c_str(), ROM, sizeof(ROM), options))
+        {
+            return false;
+        }
+        thread = std::thread([this] { server.Serve(); });
+        return client.Connect(socket_path.c_str(), shm_name.c_str());
+    }
+
+    ~Fixture()
+    {
+        client.Shutdown();
+        client.Disconnect();
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+};
+
+static EnvServer::Options Options()
+{
+    EnvServer::Options options;
+    options.instances = 10;
+    options.workers = 3;
+    options.pin = false;
+    options.instructions_per_frame = 12;
+    options.reward_address = 0x300;
+    options.done_address = 0x301;
+    return options;
+}
+
+TEST(frames_match_direct_machines)
+{
+    Fixture f;
+    CHECK(f.Start(Options()));
+    CHECK_EQ(f.client.Instances(), 10);
+
+    // Instance i holds key 5 on steps where (step + i) is even
+    chip8 reference[10];
+    for (int i = 0; i < 10; ++i)
+    {
+        reference[i].Reset(Options().seed + i);
+        reference[i].LoadROM(ROM, sizeof(ROM));
+        reference[i].instructions_per_frame = 12;
+    }
+    for (int step = 0; step < 2; ++step)
+    {
+        for (int i = 0; i < 10; ++i)
+        {
+            f.client.Actions()[i] = (step + i) % 2 == 0 ? 1u << 5 : 0u;
+            reference[i].keypad[5] = (step + i) % 2 == 0;
+            reference[i].Frame();
+        }
+        CHECK(f.client.Step());
+        for (int i = 0; i < 10; ++i)
+        {
+            uint8_t packed[EnvLayout::FRAME_BYTES];
+            reference[i].PackVideo(packed);
+            CHECK(memcmp(packed, f.client.Frame(i), sizeof(packed)) == 0);
+            CHECK_EQ(f.client.Rewards()[i], (step + i) % 2 == 0 ? 1 : 0);
+            CHECK_EQ(f.client.Dones()[i], 0);
+        }
+    }
+}
+
+TEST(done_resets_on_the_next_step)
+{
+    Fixture f;
+    CHECK(f.Start(Options()));
+    for (int i = 0; i < 10; ++i)
+    {
+        f.client.Actions()[i] = 1u << 5;
+    }
+    for (int step = 0; step < 3; ++step)
+    {
+        CHECK(f.client.Step());
+    }
+    CHECK_EQ(f.client.Dones()[0], 1);
+    CHECK_EQ(f.client.Rewards()[0], 1);
+
+    // New episode: score starts again from 0, so one step is worth 1 and not done
+    CHECK(f.client.Step());
+    CHECK_EQ(f.client.Dones()[0], 0);
+    CHECK_EQ(f.client.Rewards()[0], 1);
+}
+
+TEST(max_frames_and_reset)
+{
+    EnvServer::Options options = Options();
+    options.max_frames = 4;
+    options.frames_per_step = 2;
+    Fixture f;
+    CHECK(f.Start(options));
+    CHECK(f.client.Step());
+    CHECK_EQ(f.client.Dones()[3], 0);
+    CHECK(f.client.Step());
+    CHECK_EQ(f.client.Dones()[3], 1);
+
+    CHECK(f.client.Reset());
+    CHECK_EQ(f.client.Dones()[3], 0);
+    uint8_t blank[EnvLayout::FRAME_BYTES] = {};
+    CHECK(memcmp(blank, f.client.Frame(3), sizeof(blank)) == 0);
+}
+
+int main()
+{
+    return RunTests("env");
+}
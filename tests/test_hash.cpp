@@ -0,0 +1,113 @@
+// The incremental memory/video hashes must always equal a full recompute.
+#include <initializer_list>
+
+#include "check.h"
+#include "chip8.h"
+
+static chip8 &Load(std::initializer_list<uint16_t> program)
+{
+    static chip8 c(1);
+    c.Reset(1);
+    uint16_t address = chip8::DATA_START;
+    for (uint16_t op : program)
+    {
+        c.memory[address++] = op >> 8u;
+        c.memory[address++] = op & 0xFFu;
+    }
+    c.Rehash();
+    return c;
+}
+
+// Steps n instructions and checks the kept digests against Rehash() after every one
+static void StepAndVerify(chip8 &c, int n)
+{
+    static chip8 fresh(1);
+    for (int i = 0; i < n; ++i)
+    {
+        c.Cycle();
+        fresh = c;
+        fresh.Rehash();
+        CHECK_EQ(c.memory_digest, fresh.memory_digest);
+        CHECK_EQ(c.video_digest, fresh.video_digest);
+        if (c.memory_digest != fresh.memory_digest || c.video_digest != fresh.video_digest)
+        {
+            printf("  after %04X at step %d\n", c.opcode, i);
+            return;
+        }
+    }
+}
+
+TEST(Fx55_across_a_page_boundary)
+{
+    chip8 &c = Load({0x6011, 0x6122, 0x6233, 0xA33E, 0xF255});
+    uint64_t before = c.memory_digest;
+    StepAndVerify(c, 5);
+    CHECK(c.memory_digest != before);
+}
+
+TEST(Fx55_wrapping_memory)
+{
+    chip8 &c = Load({0x6077, 0x6188, 0xAFFF, 0xF155});
+    StepAndVerify(c, 4);
+}
+
+TEST(Fx33_at_end_of_page)
+{
+    chip8 &c = Load({0x60EA, 0xA33F, 0xF033});
+    StepAndVerify(c, 3);
+}
+
+TEST(Dxyn_clipped_and_erased)
+{
+    chip8 &c = Load({0x6000, 0xF029, 0x613C, 0x621E, 0xD125, 0xD125, 0x6100, 0x6200, 0xD125, 0x00E0});
+    StepAndVerify(c, 5);
+    CHECK(c.video_digest != 0);
+    StepAndVerify(c, 1);
+    CHECK_EQ(c.video_digest, 0); // erased rows contribute nothing
+    StepAndVerify(c, 3);
+    CHECK(c.video_digest != 0);
+    StepAndVerify(c, 1);
+    CHECK_EQ(c.video_digest, 0);
+}
+
+TEST(self_modifying_loop)
+{
+    // Draws, stores and increments in a loop: V0..V3 stored at I, I walks through memory
+    chip8 &c = Load({0x7001, 0x7103, 0x8204, 0xD015, 0xF355, 0xF01E, 0x1200});
+    StepAndVerify(c, 20000);
+}
+
+TEST(restore_keeps_digests)
+{
+    chip8 &c = Load({0x6000, 0xF029, 0x6105, 0xD115, 0xA300, 0xF155});
+    StepAndVerify(c, 6);
+    static chip8::Snapshot snapshot;
+    c.Save(snapshot);
+    uint64_t digest = c.Digest();
+
+    static chip8 other(2);
+    other.Restore(snapshot);
+    CHECK_EQ(other.Digest(), digest);
+    CHECK_EQ(other.video_digest, c.video_digest);
+    for (int row = 0; row < chip8::DISPLAY_HEIGHT; ++row)
+    {
+        CHECK_EQ(other.video_rows[row], c.video_rows[row]);
+    }
+}
+
+TEST(digest_sees_video_hash_does_not)
+{
+    chip8 &c = Load({0x6000, 0xF029, 0xD005});
+    StepAndVerify(c, 3);
+
+    static chip8 blank(1);
+    blank = c;
+    blank.OP_00E0();
+    CHECK_EQ(blank.Hash(), c.Hash());
+    CHECK(blank.Digest() != c.Digest());
+}
+
+int main()
+{
+    return RunTests("hash");
+}
@@ -0,0 +1,157 @@
+// Backends must agree instruction by instruction, and the lockstep runner must point at the
+// first instruction that makes two machines differ.
+#include <string>
+
+#include "check.h"
+#include "chip8.h"
+#include "lockstep.h"
+
+// Touches every handler family: draws, BCD and stores into its own data, calls, skips,
+// random numbers, key input and timers.
+static const uint8_t MIXED[] = {
+    0x00, 0xE0, 0x6A, 0x00, 0x6B, 0x00, 0x22, 0x20, 0x7A, 0x01, 0x3A, 0x3C, 0x12, 0x06, 0x6A, 0x00, // 200
+    0x7B, 0x01, 0xFB, 0x15, 0xEB, 0x9E, 0x12, 0x06, 0xEB, 0xA1, 0x12, 0x06, 0x12, 0x06, 0x00, 0x00, // 210
+    0xC0, 0xFF, 0xF0, 0x29, 0x81, 0xA0, 0x82, 0xB0, 0x71, 0x07, 0xD1, 0x25, 0xA3, 0x00, 0xF0, 0x33, // 220
+    0xF2, 0x65, 0x80, 0x14, 0x80, 0x25, 0x80, 0x17, 0x80, 0x06, 0x80, 0x0E, 0xF1, 0x07, 0xA3, 0x10, // 230
+    0xF3, 0x55, 0x40, 0x00, 0x00, 0xEE, 0x00, 0xEE,                                                 // 240
+};
+
+static void Same(Lockstep::Backend a, Lockstep::Backend b, uint8_t quirks = 0)
+{
+    static chip8 left(7), right(7);
+    left.Reset(7);
+    right.Reset(7);
+    left.LoadROM(MIXED, sizeof(MIXED));
+    right.LoadROM(MIXED, sizeof(MIXED));
+    left.quirks = right.quirks = quirks;
+
+    auto input = [](uint64_t step, chip8 &c) { c.keypad[(step / 97) & 0xF] = (step / 13) & 1; };
+    Lockstep::Divergence d = Lockstep::Run(
+        left, right, 200000, [a](chip8 &c) { Lockstep::Step(a, c); }, [b](chip8 &c) { Lockstep::Step(b, c); }, input);
+
+    CHECK(!d.found);
+    if (d.found)
+    {
+        printf("  %s vs %s (quirks %02X) diverged at %llu, pc %03X opcode %04X, %s\n", Lockstep::Name(a),
+               Lockstep::Name(b), quirks, static_cast<unsigned long long>(d.step), d.pc, d.opcode, d.field);
+    }
+}
+
+TEST(cycle_and_run_agree)
+{
+    Same(Lockstep::Backend::Cycle, Lockstep::Backend::Run);
+}
+
+TEST(cycle_and_restore_agree)
+{
+    Same(Lockstep::Backend::Cycle, Lockstep::Backend::Restore);
+}
+
+TEST(cycle_and_direct_agree_under_every_quirk_profile)
+{
+    Same(Lockstep::Backend::Cycle, Lockstep::Backend::Direct);
+    Same(Lockstep::Backend::Run, Lockstep::Backend::Direct, 0x1F);
+    for (uint8_t quirk = 1; quirk < 0x20; quirk <<= 1)
+    {
+        Same(Lockstep::Backend::Cycle, Lockstep::Backend::Direct, quirk);
+    }
+}
+
+TEST(quirk_profiles_are_told_apart)
+{
+    // 8016 shifts V1 into V0 by default, V0 in place with QUIRK_SHIFT
+    static uint8_t const SHIFT[] = {0x60, 0x05, 0x61, 0x03, 0x80, 0x16, 0x12, 0x06};
+    static chip8 left(1), right(1);
+    left.Reset(1);
+    right.Reset(1);
+    left.LoadROM(SHIFT, sizeof(SHIFT));
+    right.LoadROM(SHIFT, sizeof(SHIFT));
+    left.quirks = 0;
+    right.quirks = chip8::QUIRK_SHIFT;
+
+    auto step = [](chip8 &c) { Lockstep::Step(Lockstep::Backend::Direct, c); };
+    Lockstep::Divergence d = Lockstep::Run(left, right, 100, step, step, [](uint64_t, chip8 &) {});
+    CHECK(d.found);
+    CHECK_EQ(d.step, 3);
+    CHECK_EQ(d.opcode, 0x8016);
+    CHECK(d.field && std::string(d.field) == "V0");
+
+    Lockstep::Backend parsed{};
+    CHECK(Lockstep::Parse("direct", parsed) && parsed == Lockstep::Backend::Direct);
+}
+
+TEST(reports_first_divergent_instruction)
+{
+    // Different seeds agree until the first RND at 0x220. Small seeds all draw 0 first with
+    // minstd_rand0, so pick one that doesn't.
+    static chip8 left(1), right(12345);
+    left.Reset(1);
+    right.Reset(12345);
+    left.LoadROM(MIXED, sizeof(MIXED));
+    right.LoadROM(MIXED, sizeof(MIXED));
+
+    auto step = [](chip8 &c) { c.Cycle(); };
+    Lockstep::Divergence d = Lockstep::Run(left, right, 1000, step, step, [](uint64_t, chip8 &) {});
+
+    CHECK(d.found);
+    CHECK_EQ(d.pc, 0x220);
+    CHECK_EQ(d.opcode, 0xC0FF);
+    CHECK_EQ(d.step, 5); // CLS, LD, LD, CALL, RND
+}
+
+TEST(reports_memory_address)
+{
+    static chip8 left(1), right(1);
+    left.Reset(1);
+    right.Reset(1);
+    left.LoadROM(MIXED, sizeof(MIXED));
+    right.LoadROM(MIXED, sizeof(MIXED));
+    right.memory[0xF00] = 1;
+
+    auto step = [](chip8 &c) { c.Cycle(); };
+    Lockstep::Divergence d = Lockstep::Run(left, right, 10, step, step, [](uint64_t, chip8 &) {});
+
+    CHECK(d.found);
+    CHECK_EQ(d.step, 0);
+    CHECK(d.field && std::string(d.field) == "memory");
+    CHECK_EQ(d.address, 0xF00);
+}
+
+TEST(catches_writes_the_digests_miss)
+{
+    // Memory written behind the digests' back: equal digests, different memory
+    static chip8 left(1), right(1);
+    left.Reset(1);
+    right.Reset(1);
+    left.LoadROM(MIXED, sizeof(MIXED));
+    right.LoadROM(MIXED, sizeof(MIXED));
+
+    auto step = [](chip8 &c) { c.Cycle(); };
+    auto corrupt = [](chip8 &c) {
+        c.Cycle();
+        c.memory[0xF00] = 1;
+    };
+    Lockstep::Divergence d = Lockstep::Run(left, right, 10, step, corrupt, [](uint64_t, chip8 &) {});
+    CHECK(d.found);
+    CHECK_EQ(d.step, 1);
+    CHECK(d.field && std::string(d.field) == "memory");
+
+    // And the other way round, a digest that no longer matches identical memory
+    left.Reset(1);
+    right.Reset(1);
+    left.LoadROM(MIXED, sizeof(MIXED));
+    right.LoadROM(MIXED, sizeof(MIXED));
+    auto stale = [](chip8 &c) {
+        c.Cycle();
+        c.memory_digest ^= 1;
+    };
+    d = Lockstep::Run(left, right, 10, step, stale, [](uint64_t, chip8 &) {});
+    CHECK(d.found);
+    CHECK_EQ(d.step, 1);
+    CHECK(d.field && std::string(d.field) == "digest");
+}
+
+int main()
+{
+    return RunTests("lockstep");
+}
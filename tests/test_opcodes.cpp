@@ -0,0 +1,477 @@
+// One or more tests per chip8::OP_* handler, driven through Cycle like a real program.
+#include <initializer_list>
+
+#include "check.h"
+#include "chip8.h"
+
+// Fresh machine (seed 1) with program at DATA_START. Shared, tests run one at a time.
+static chip8 &Load(std::initializer_list<uint16_t> program)
+{
+    static chip8 c(1);
+    c.Reset(1);
+    c.quirks = 0;
+    c.dispatch = chip8::Dispatch::Tables;
+    uint16_t address = chip8::DATA_START;
+    for (uint16_t op : program)
+    {
+        c.memory[address++] = op >> 8u;
+        c.memory[address++] = op & 0xFFu;
+    }
+    return c;
+}
+
+static void Step(chip8 &c, int n = 1)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        c.Cycle();
+    }
+}
+
+static bool Pixel(chip8 const &c, int x, int y)
+{
+    return c.video[y * chip8::DISPLAY_WIDTH + x] != 0;
+}
+
+TEST(OP_00E0_clears_video)
+{
+    chip8 &c = Load({0x00E0});
+    c.video[0] = c.video[2047] = 0xFFFFFFFF;
+    Step(c);
+    CHECK(!Pixel(c, 0, 0));
+    CHECK(!Pixel(c, 63, 31));
+    CHECK_EQ(c.pc, 0x202);
+}
+
+TEST(OP_2nnn_OP_00EE_call_and_return)
+{
+    chip8 &c = Load({0x2206, 0x0000, 0x0000, 0x00EE});
+    Step(c);
+    CHECK_EQ(c.pc, 0x206);
+    CHECK_EQ(c.sp, 1);
+    CHECK_EQ(c.stack[0], 0x202);
+    Step(c);
+    CHECK_EQ(c.pc, 0x202);
+    CHECK_EQ(c.sp, 0);
+}
+
+TEST(OP_2nnn_stack_wraps_instead_of_overflowing)
+{
+    chip8 &c = Load({0x2200});
+    Step(c, chip8::REGISTER_STACK_SIZE + 1);
+    CHECK_EQ(c.sp, 1);
+    CHECK_EQ(c.pc, 0x200);
+}
+
+TEST(OP_1nnn_jumps)
+{
+    chip8 &c = Load({0x1ABC});
+    Step(c);
+    CHECK_EQ(c.pc, 0xABC);
+}
+
+TEST(OP_3xkk_skips_when_equal)
+{
+    chip8 &c = Load({0x6342, 0x3342});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x206);
+    c = Load({0x6342, 0x3343});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x204);
+}
+
+TEST(OP_4xkk_skips_when_not_equal)
+{
+    chip8 &c = Load({0x6342, 0x4343});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x206);
+    c = Load({0x6342, 0x4342});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x204);
+}
+
+TEST(OP_5xy0_skips_when_registers_equal)
+{
+    chip8 &c = Load({0x6107, 0x6207, 0x5120});
+    Step(c, 3);
+    CHECK_EQ(c.pc, 0x208);
+    c = Load({0x6107, 0x6208, 0x5120});
+    Step(c, 3);
+    CHECK_EQ(c.pc, 0x206);
+}
+
+TEST(OP_6xkk_loads)
+{
+    chip8 &c = Load({0x6A5C});
+    Step(c);
+    CHECK_EQ(c.v_registers[0xA], 0x5C);
+}
+
+TEST(OP_7xkk_adds_without_carry_flag)
+{
+    chip8 &c = Load({0x61FF, 0x6F07, 0x7102});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0x01);
+    CHECK_EQ(c.v_registers[0xF], 0x07);
+}
+
+TEST(OP_8xy0_8xy1_8xy2_8xy3_logic)
+{
+    chip8 &c = Load({0x61F0, 0x623C, 0x8120});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0x3C);
+    c = Load({0x61F0, 0x623C, 0x8121});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0xFC);
+    c = Load({0x61F0, 0x623C, 0x8122});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0x30);
+    c = Load({0x61F0, 0x623C, 0x8123});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0xCC);
+}
+
+TEST(OP_8xy4_sets_carry)
+{
+    chip8 &c = Load({0x61F0, 0x6220, 0x8124});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0x10);
+    CHECK_EQ(c.v_registers[0xF], 1);
+    c = Load({0x6110, 0x6220, 0x8124});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0x30);
+    CHECK_EQ(c.v_registers[0xF], 0);
+}
+
+TEST(OP_8xy4_flag_wins_over_result_in_VF)
+{
+    chip8 &c = Load({0x6FF0, 0x6220, 0x8F24});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[0xF], 1);
+}
+
+TEST(OP_8xy5_compares_values_not_indices)
+{
+    // x=1 < y=2 as indices, but V1 > V2 as values
+    chip8 &c = Load({0x6105, 0x6203, 0x8125});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[1], 0x02);
+    CHECK_EQ(c.v_registers[0xF], 1);
+
+    c = Load({0x6503, 0x6205, 0x8525});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[5], 0xFE);
+    CHECK_EQ(c.v_registers[0xF], 0);
+}
+
+TEST(OP_8xy5_equal_values_do_not_borrow)
+{
+    for (chip8::Dispatch dispatch : {chip8::Dispatch::Tables, chip8::Dispatch::Direct})
+    {
+        chip8 &c = Load({0x6107, 0x6207, 0x8125});
+        c.dispatch = dispatch;
+        Step(c, 3);
+        CHECK_EQ(c.v_registers[1], 0x00);
+        CHECK_EQ(c.v_registers[0xF], 1);
+    }
+}
+
+TEST(OP_8xy6_shifts_right_from_Vy)
+{
+    chip8 &c = Load({0x6205, 0x8126});
+    Step(c, 2);
+    CHECK_EQ(c.v_registers[1], 0x02);
+    CHECK_EQ(c.v_registers[0xF], 1);
+}
+
+TEST(OP_8xy7_compares_values_not_indices)
+{
+    // x=2 > y=1 as indices, but V1 > V2 as values
+    chip8 &c = Load({0x6105, 0x6203, 0x8217});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[2], 0x02);
+    CHECK_EQ(c.v_registers[0xF], 1);
+
+    c = Load({0x6103, 0x6205, 0x8217});
+    Step(c, 3);
+    CHECK_EQ(c.v_registers[2], 0xFE);
+    CHECK_EQ(c.v_registers[0xF], 0);
+}
+
+TEST(OP_8xy7_equal_values_do_not_borrow)
+{
+    for (chip8::Dispatch dispatch : {chip8::Dispatch::Tables, chip8::Dispatch::Direct})
+    {
+        chip8 &c = Load({0x6107, 0x6207, 0x8217});
+        c.dispatch = dispatch;
+        Step(c, 3);
+        CHECK_EQ(c.v_registers[2], 0x00);
+        CHECK_EQ(c.v_registers[0xF], 1);
+    }
+}
+
+TEST(OP_8xyE_shifts_left_from_Vy)
+{
+    chip8 &c = Load({0x6281, 0x812E});
+    Step(c, 2);
+    CHECK_EQ(c.v_registers[1], 0x02);
+    CHECK_EQ(c.v_registers[0xF], 1);
+}
+
+TEST(OP_9xy0_skips_when_registers_differ)
+{
+    chip8 &c = Load({0x6107, 0x6208, 0x9120});
+    Step(c, 3);
+    CHECK_EQ(c.pc, 0x208);
+    c = Load({0x6107, 0x6207, 0x9120});
+    Step(c, 3);
+    CHECK_EQ(c.pc, 0x206);
+}
+
+TEST(OP_Annn_sets_index)
+{
+    chip8 &c = Load({0xA123});
+    Step(c);
+    CHECK_EQ(c.index, 0x123);
+}
+
+TEST(OP_Bnnn_jumps_relative_to_V0)
+{
+    chip8 &c = Load({0x6010, 0xB300});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x310);
+}
+
+TEST(OP_Cxkk_masks_and_follows_seed)
+{
+    chip8 &c = Load({0xC00F, 0xC1FF});
+    Step(c, 2);
+    CHECK_EQ(c.v_registers[0] & 0xF0, 0);
+    uint8_t first = c.v_registers[1];
+
+    c = Load({0xC00F, 0xC1FF});
+    Step(c, 2);
+    CHECK_EQ(c.v_registers[1], first);
+}
+
+TEST(OP_Dxyn_draws_and_reports_collision)
+{
+    // Font "0" (F0 90 90 90 F0) at (1, 2), then again to erase it
+    chip8 &c = Load({0x6000, 0xF029, 0x6101, 0x6202, 0xD125, 0xD125});
+    Step(c, 5);
+    CHECK(Pixel(c, 1, 2));
+    CHECK(Pixel(c, 4, 2));
+    CHECK(!Pixel(c, 5, 2));
+    CHECK(Pixel(c, 1, 3));
+    CHECK(!Pixel(c, 2, 3));
+    CHECK_EQ(c.v_registers[0xF], 0);
+    Step(c);
+    CHECK(!Pixel(c, 1, 2));
+    CHECK_EQ(c.v_registers[0xF], 1);
+}
+
+TEST(OP_Dxyn_clips_at_edges_and_wraps_start)
+{
+    chip8 &c = Load({0x6000, 0xF029, 0x613E, 0x621E, 0xD125});
+    Step(c, 5);
+    CHECK(Pixel(c, 62, 30));
+    CHECK(Pixel(c, 63, 30));
+    CHECK(!Pixel(c, 0, 31)); // no spill into the next row
+    CHECK(!Pixel(c, 0, 0));  // or back to the top
+
+    c = Load({0x6000, 0xF029, 0x6142, 0x6222, 0xD125});
+    Step(c, 5);
+    CHECK(Pixel(c, 2, 2)); // 66 % 64, 34 % 32
+}
+
+TEST(OP_Ex9E_skips_when_key_down)
+{
+    chip8 &c = Load({0x6A07, 0xEA9E});
+    c.keypad[7] = 1;
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x206);
+    c = Load({0x6A07, 0xEA9E});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x204);
+}
+
+TEST(OP_ExA1_skips_when_key_up)
+{
+    chip8 &c = Load({0x6A07, 0xEAA1});
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x206);
+    c = Load({0x6A07, 0xEAA1});
+    c.keypad[7] = 1;
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x204);
+}
+
+TEST(OP_Ex9E_masks_key_index)
+{
+    chip8 &c = Load({0x6A17, 0xEA9E});
+    c.keypad[7] = 1;
+    Step(c, 2);
+    CHECK_EQ(c.pc, 0x206);
+}
+
+TEST(OP_Fx07_reads_delay_timer)
+{
+    chip8 &c = Load({0x6010, 0xF015, 0xF107});
+    Step(c, 3);
+    // set to 0x10, decremented once after Fx15 ran
+    CHECK_EQ(c.v_registers[1], 0x0F);
+}
+
+TEST(OP_Fx0A_waits_for_key)
+{
+    chip8 &c = Load({0xF30A});
+    Step(c, 3);
+    CHECK_EQ(c.pc, 0x200);
+    c.keypad[0xB] = 1;
+    Step(c);
+    CHECK_EQ(c.pc, 0x202);
+    CHECK_EQ(c.v_registers[3], 0xB);
+}
+
+TEST(OP_Fx15_Fx18_set_timers_which_tick_per_cycle)
+{
+    chip8 &c = Load({0x6005, 0xF015, 0xF018, 0x0000});
+    Step(c, 3);
+    CHECK_EQ(c.delay_timer, 3);
+    CHECK_EQ(c.sound_timer, 4);
+}
+
+TEST(OP_Fx1E_adds_to_index)
+{
+    chip8 &c = Load({0xA100, 0x6022, 0xF01E});
+    Step(c, 3);
+    CHECK_EQ(c.index, 0x122);
+}
+
+TEST(OP_Fx29_points_at_font_digit)
+{
+    chip8 &c = Load({0x600A, 0xF029});
+    Step(c, 2);
+    CHECK_EQ(c.index, chip8::FONT_START + 5 * 0xA);
+}
+
+TEST(OP_Fx33_writes_bcd)
+{
+    chip8 &c = Load({0x60EA, 0xA300, 0xF033});
+    Step(c, 3);
+    CHECK_EQ(c.memory[0x300], 2);
+    CHECK_EQ(c.memory[0x301], 3);
+    CHECK_EQ(c.memory[0x302], 4);
+}
+
+TEST(OP_Fx55_Fx65_store_and_load_registers)
+{
+    chip8 &c = Load({0x6011, 0x6122, 0x6233, 0xA300, 0xF155, 0x6000, 0x6100, 0x6200, 0xF265});
+    Step(c, 9);
+    CHECK_EQ(c.memory[0x300], 0x11);
+    CHECK_EQ(c.memory[0x301], 0x22);
+    CHECK_EQ(c.memory[0x302], 0x00); // only V0..V1 stored
+    CHECK_EQ(c.v_registers[0], 0x11);
+    CHECK_EQ(c.v_registers[1], 0x22);
+    CHECK_EQ(c.v_registers[2], 0x00);
+    CHECK_EQ(c.index, 0x300); // I is left alone
+}
+
+TEST(OP_Fx55_wraps_at_end_of_memory)
+{
+    chip8 &c = Load({0x6077, 0x6188, 0xAFFF, 0xF155});
+    Step(c, 4);
+    CHECK_EQ(c.memory[0xFFF], 0x77);
+    CHECK_EQ(c.memory[0x000], 0x88);
+}
+
+TEST(OP_NULL_for_undocumented_opcodes)
+{
+    // 0x0000 used to decode as CLS through the low nibble
+    chip8 &c = Load({0x0000, 0x0120, 0xE0A2, 0x812F, 0xF0FF});
+    c.video[0] = 0xFFFFFFFF;
+    c.keypad[0] = 1;
+    Step(c, 5);
+    CHECK(Pixel(c, 0, 0));
+    CHECK_EQ(c.pc, 0x20A);
+    CHECK_EQ(c.v_registers[1], 0);
+}
+
+TEST(QUIRK_SHIFT_shifts_Vx_in_place)
+{
+    chip8 &c = Load({0x6005, 0x6181, 0x8016, 0x821E});
+    c.quirks = chip8::QUIRK_SHIFT;
+    Step(c, 4);
+    CHECK_EQ(c.v_registers[0], 0x02); // 5 >> 1, V1 ignored
+    CHECK_EQ(c.v_registers[2], 0x00); // 0 << 1, V1 ignored
+    CHECK_EQ(c.v_registers[0xF], 0);
+}
+
+TEST(QUIRK_LOAD_STORE_advances_I)
+{
+    chip8 &c = Load({0xA300, 0xF255, 0xF165});
+    c.quirks = chip8::QUIRK_LOAD_STORE;
+    Step(c, 2);
+    CHECK_EQ(c.index, 0x303);
+    Step(c);
+    CHECK_EQ(c.index, 0x305);
+}
+
+TEST(QUIRK_LOAD_STORE_watchpoints_see_the_bytes_written)
+{
+    // The stop is tested after I has moved on to 0x303, it must still cover 0x300-0x302
+    for (uint8_t quirks : {uint8_t(0), uint8_t(chip8::QUIRK_LOAD_STORE)})
+    {
+        chip8 &c = Load({0xA300, 0xF255, 0x1204});
+        c.quirks = quirks;
+        c.ClearWatchpoints();
+        c.SetWatchpoint(0x301, 1);
+        chip8::RunResult result = c.Run(10);
+        CHECK_EQ(static_cast<int>(result.reason), static_cast<int>(chip8::StopReason::Watchpoint));
+        CHECK_EQ(result.address, 0x301);
+        CHECK_EQ(result.executed, 2);
+        c.ClearWatchpoints();
+    }
+}
+
+TEST(QUIRK_JUMP_adds_Vx)
+{
+    chip8 &c = Load({0x6004, 0x6310, 0xB300});
+    c.quirks = chip8::QUIRK_JUMP;
+    Step(c, 3);
+    CHECK_EQ(c.pc, 0x310);
+}
+
+TEST(QUIRK_VF_RESET_clears_VF_on_logic)
+{
+    chip8 &c = Load({0x6F07, 0x8011, 0x6F07, 0x8012, 0x6F07, 0x8013});
+    c.quirks = chip8::QUIRK_VF_RESET;
+    for (int i = 0; i < 3; ++i)
+    {
+        Step(c, 2);
+        CHECK_EQ(c.v_registers[0xF], 0);
+    }
+}
+
+TEST(QUIRK_WRAP_wraps_sprites_around_edges)
+{
+    // 8 wide row at (60, 31), height 2: both halves and both rows wrap
+    chip8 &c = Load({0x603C, 0x611F, 0xA300, 0xD012});
+    c.memory[0x300] = 0xFF;
+    c.memory[0x301] = 0x81;
+    c.quirks = chip8::QUIRK_WRAP;
+    Step(c, 4);
+    CHECK(Pixel(c, 63, 31));
+    CHECK(Pixel(c, 3, 31));
+    CHECK(Pixel(c, 60, 0));
+    CHECK(!Pixel(c, 63, 0));
+    CHECK(Pixel(c, 3, 0));
+    uint64_t digest = c.video_digest;
+    c.Rehash();
+    CHECK_EQ(c.video_digest, digest);
+}
+
+int main()
+{
+    return RunTests("opcodes");
+}
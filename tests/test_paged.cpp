@@ -0,0 +1,137 @@
+// Copy-on-write states: forks share pages, only written pages are copied, round trips are exact.
+#include <cstring>
+#include <initializer_list>
+
+#include "check.h"
+#include "chip8.h"
+#include "paged.h"
+
+static chip8 &Load(std::initializer_list<uint16_t> program)
+{
+    static chip8 c(1);
+    c.Reset(1);
+    uint16_t address = chip8::DATA_START;
+    for (uint16_t op : program)
+    {
+        c.memory[address++] = op >> 8u;
+        c.memory[address++] = op & 0xFFu;
+    }
+    c.Rehash();
+    return c;
+}
+
+TEST(fork_shares_every_page)
+{
+    chip8 &c = Load({0x6042, 0xA500, 0xF055});
+    PagedState parent;
+    c.Save(parent);
+    PagedState child = parent;
+    for (int page = 0; page < PagedState::PAGES; ++page)
+    {
+        CHECK(child.Shares(parent, page));
+        CHECK_EQ(parent.pages[page]->refs.load(), 2);
+    }
+    CHECK_EQ(child.Read(0x200), 0x60);
+    CHECK_EQ(child.pc, parent.pc);
+}
+
+TEST(store_copies_only_its_page)
+{
+    // Fx55 at 0x5FF..0x600 straddles pages 5 and 6
+    chip8 &c = Load({0x6042, 0x6143, 0xA5FF, 0xF155});
+    PagedState parent;
+    c.Save(parent);
+
+    PagedState child = parent;
+    c.Restore(parent);
+    c.Cycle();
+    c.Cycle();
+    c.Cycle();
+    c.Save(child); // three instructions, no stores yet
+    for (int page = 0; page < PagedState::PAGES; ++page)
+    {
+        CHECK(child.Shares(parent, page));
+    }
+
+    PagedState grandchild = child;
+    c.Cycle();
+    c.Save(grandchild);
+    for (int page = 0; page < PagedState::PAGES; ++page)
+    {
+        CHECK_EQ(grandchild.Shares(child, page), page != 5 && page != 6);
+    }
+    CHECK_EQ(grandchild.Read(0x5FF), 0x42);
+    CHECK_EQ(grandchild.Read(0x600), 0x43);
+    CHECK_EQ(child.Read(0x5FF), 0x00);
+    CHECK_EQ(parent.pages[5]->refs.load(), 2); // parent and child, the grandchild has its own
+}
+
+TEST(round_trip_matches_flat_snapshot)
+{
+    chip8 &c = Load({0x6000, 0xF029, 0x6105, 0xD115, 0xC0FF, 0xA300, 0xF155, 0x7101, 0x1206});
+    for (int i = 0; i < 1000; ++i)
+    {
+        c.Cycle();
+    }
+    static chip8::Snapshot flat;
+    c.Save(flat);
+    PagedState paged;
+    c.Save(paged);
+    uint64_t digest = c.Digest();
+
+    static chip8 other(2);
+    other.Restore(paged);
+    static chip8::Snapshot back;
+    other.Save(back);
+    CHECK(memcmp(&flat, &back, sizeof(flat)) == 0);
+    CHECK_EQ(other.Digest(), digest);
+
+    // Random numbers continue identically
+    c.Cycle();
+    c.Cycle();
+    other.Cycle();
+    other.Cycle();
+    CHECK_EQ(other.Digest(), c.Digest());
+}
+
+TEST(restore_with_loaded_copies_written_pages)
+{
+    chip8 &c = Load({0x6042, 0xA500, 0xF055, 0x1206});
+    PagedState parent;
+    c.Save(parent);
+    for (int i = 0; i < 3; ++i)
+    {
+        c.Cycle();
+    }
+    CHECK_EQ(c.memory[0x500], 0x42);
+
+    // The store dirtied page 5, restoring relative to parent must undo it
+    c.Restore(parent, &parent);
+    CHECK_EQ(c.memory[0x500], 0x00);
+    CHECK_EQ(c.pc, 0x200);
+    CHECK_EQ(c.dirty_pages, 0);
+}
+
+TEST(move_and_release)
+{
+    chip8 &c = Load({0x1200});
+    PagedState a;
+    c.Save(a);
+    PagedState::Page *page = a.pages[2];
+    {
+        PagedState b = a;
+        CHECK_EQ(page->refs.load(), 2);
+        PagedState moved = std::move(b);
+        CHECK_EQ(page->refs.load(), 2);
+        CHECK(b.pages[2] == nullptr);
+    }
+    CHECK_EQ(page->refs.load(), 1);
+    PagedState &same = a;
+    a = same; // self assignment keeps the reference
+    CHECK_EQ(page->refs.load(), 1);
+}
+
+int main()
+{
+    return RunTests("paged");
+}
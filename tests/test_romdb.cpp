@@ -0,0 +1,132 @@
+// RomDb: SHA-1 against the standard vectors, parsing, lookup and what an entry does to a machine.
+#include <cstring>
+#include <string>
+
+#include "check.h"
+#include "chip8.h"
+#include "romdb.h"
+
+static std::string Hex(uint8_t const *bytes, size_t size)
+{
+    std::string text;
+    char digits[3];
+    for (size_t i = 0; i < size; ++i)
+    {
+        snprintf(digits, sizeof(digits), "%02x", bytes[i]);
+        text += digits;
+    }
+    return text;
+}
+
+static std::string Sha1(std::string const &data)
+{
+    uint8_t digest[RomDb::DIGEST_SIZE];
+    RomDb::Sha1(reinterpret_cast<uint8_t const *>(data.data()), data.size(), digest);
+    return Hex(digest, sizeof(digest));
+}
+
+static bool Parse(RomDb &db, std::string const &text, std::string *error = nullptr)
+{
+    return db.Parse(text.data(), text.size(), error);
+}
+
+static uint8_t const ROM[] = {0x60, 0x01, 0x12, 0x00};
+
+TEST(sha1_matches_standard_vectors)
+{
+    CHECK(Sha1("") == "da39a3ee5e6b4b0d3255bfef95601890afd80709");
+    CHECK(Sha1("abc") == "a9993e364706816aba3e25717850c26c9cd0d89d");
+    // 56 bytes, the length no longer fits the first padding block
+    CHECK(Sha1("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq") ==
+          "84983e441c3bd26ebaae4aa1f95129e5e54670f1");
+    CHECK(Sha1(std::string(1000000, 'a')) == "34aa973cd4c4daa4f61eeb2bdbad27316534016f");
+}
+
+TEST(finds_entries_by_rom_hash)
+{
+    uint8_t digest[RomDb::DIGEST_SIZE];
+    RomDb::Sha1(ROM, sizeof(ROM), digest);
+    std::string text = "# test database\n"
+                       "\n"
+                       "0000000000000000000000000000000000000000 ipf=5 name=Zero\n" +
+                       Hex(digest, sizeof(digest)) +
+                       " ipf=30 quirks=shift,wrap palette=33ff66,101010 keys=0123426486ABCDEF name=Space Game \r\n"
+                       "ffffffffffffffffffffffffffffffffffffffff\n";
+    RomDb db;
+    CHECK(Parse(db, text));
+    CHECK_EQ(db.Size(), 3);
+
+    RomDb::Entry const *entry = db.Find(ROM, sizeof(ROM));
+    CHECK(entry != nullptr);
+    if (!entry)
+        return;
+    CHECK(strcmp(db.Name(*entry), "Space Game") == 0);
+    CHECK_EQ(entry->instructions_per_frame, 30);
+    CHECK_EQ(entry->quirks, chip8::QUIRK_SHIFT | chip8::QUIRK_WRAP);
+    CHECK_EQ(entry->flags, RomDb::HAS_PALETTE | RomDb::HAS_KEYS);
+    CHECK_EQ(entry->foreground, 0x33FF66);
+    CHECK_EQ(entry->background, 0x101010);
+    CHECK_EQ(entry->keys[5], 2);
+    CHECK_EQ(entry->keys[9], 6);
+
+    uint8_t unknown[] = {0x12, 0x00};
+    CHECK(db.Find(unknown, sizeof(unknown)) == nullptr);
+    uint8_t ones[RomDb::DIGEST_SIZE];
+    memset(ones, 0xFF, sizeof(ones));
+    CHECK(db.Find(ones) != nullptr);
+    CHECK(strcmp(db.Name(*db.Find(ones)), "") == 0);
+}
+
+TEST(last_line_for_a_hash_wins)
+{
+    RomDb db;
+    CHECK(Parse(db, "1111111111111111111111111111111111111111 ipf=5\n"
+                    "2222222222222222222222222222222222222222 ipf=6\n"
+                    "1111111111111111111111111111111111111111 ipf=7\n"));
+    CHECK_EQ(db.Size(), 2);
+    uint8_t key[RomDb::DIGEST_SIZE];
+    memset(key, 0x11, sizeof(key));
+    CHECK(db.Find(key) && db.Find(key)->instructions_per_frame == 7);
+}
+
+TEST(malformed_lines_are_rejected_with_their_number)
+{
+    char const *bad[] = {"123 ipf=5", "1111111111111111111111111111111111111111 ipf=0",
+                         "1111111111111111111111111111111111111111 quirks=shift,bogus",
+                         "1111111111111111111111111111111111111111 palette=ffffff",
+                         "1111111111111111111111111111111111111111 keys=0123",
+                         "1111111111111111111111111111111111111111 speed=5",
+                         "1111111111111111111111111111111111111111 ipf"};
+    for (char const *line : bad)
+    {
+        RomDb db;
+        CHECK(Parse(db, "2222222222222222222222222222222222222222 ipf=6\n"));
+        std::string error;
+        CHECK(!Parse(db, std::string("# header\n") + line + "\n", &error));
+        CHECK(error.compare(0, 7, "line 2:") == 0);
+        // Left as it was before the failed parse
+        CHECK_EQ(db.Size(), 1);
+    }
+}
+
+TEST(apply_sets_speed_and_quirks)
+{
+    RomDb db;
+    CHECK(Parse(db, "1111111111111111111111111111111111111111 quirks=jump,vf_reset,load_store\n"
+                    "2222222222222222222222222222222222222222 ipf=11 quirks=none\n"));
+    uint8_t key[RomDb::DIGEST_SIZE];
+    chip8 c(1);
+    memset(key, 0x11, sizeof(key));
+    RomDb::Apply(*db.Find(key), c);
+    CHECK_EQ(c.instructions_per_frame, chip8::INST_EXE); // not given, left alone
+    CHECK_EQ(c.quirks, chip8::QUIRK_JUMP | chip8::QUIRK_VF_RESET | chip8::QUIRK_LOAD_STORE);
+    memset(key, 0x22, sizeof(key));
+    RomDb::Apply(*db.Find(key), c);
+    CHECK_EQ(c.instructions_per_frame, 11);
+    CHECK_EQ(c.quirks, 0);
+}
+
+int main()
+{
+    return RunTests("romdb");
+}
@@ -0,0 +1,165 @@
+// Scheduler: blocked tasks stay parked until a key, every task makes progress, stealing balances.
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "chip8.h"
+#include "scheduler.h"
+
+// LD V0, K then count frames in V1 forever
+static uint8_t const WAIT_ROM[] = {0xF0, 0x0A, 0x71, 0x01, 0x12, 0x02};
+// Counts in V1 forever
+static uint8_t const LOOP_ROM[] = {0x71, 0x01, 0x12, 0x00};
+
+static std::vector<std::unique_ptr<chip8>> Machines(size_t count, uint8_t const *rom, size_t size)
+{
+    std::vector<std::unique_ptr<chip8>> machines;
+    for (size_t i = 0; i < count; ++i)
+    {
+        machines.emplace_back(new chip8(static_cast<uint32_t>(i)));
+        machines.back()->LoadROM(rom, size);
+    }
+    return machines;
+}
+
+// Runs the scheduler in stints until done() holds or a generous deadline passes, so the tests
+// wait as long as a loaded machine needs and no longer. Stints start short and double, workers
+// that don't get a CPU before Stop get longer next time. done() runs with the workers stopped,
+// so it may look at machines. Returns with the scheduler stopped.
+template <typename Done>
+static bool RunUntil(Scheduler &scheduler, Done done)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    std::chrono::milliseconds stint(10);
+    for (;;)
+    {
+        scheduler.Start();
+        std::this_thread::sleep_for(stint);
+        scheduler.Stop();
+        stint = std::min(stint * 2, std::chrono::milliseconds(1000));
+        if (done())
+        {
+            return true;
+        }
+        if (std::chrono::steady_clock::now() > deadline)
+        {
+            return false;
+        }
+    }
+}
+
+TEST(blocked_tasks_cost_nothing_until_a_key)
+{
+    Scheduler::Options options;
+    options.workers = 2;
+    options.pin = false;
+    options.frame_hz = 0;
+    Scheduler scheduler(options);
+    auto machines = Machines(200, WAIT_ROM, sizeof(WAIT_ROM));
+    for (auto &c : machines)
+    {
+        scheduler.Add(c.get());
+    }
+
+    CHECK(RunUntil(scheduler, [&] { return scheduler.Totals().key_waits >= 200; }));
+    // Each blocked exactly once, never rescheduled while waiting, however long they wait
+    RunUntil(scheduler, [] { return true; });
+    CHECK_EQ(scheduler.Totals().key_waits, 200);
+    CHECK_EQ(scheduler.Totals().frames, 0);
+    CHECK_EQ(machines[7]->pc, 0x200);
+
+    for (Scheduler::Task task = 0; task < 100; ++task)
+    {
+        scheduler.SetKey(task, 0xB, true);
+    }
+    CHECK(RunUntil(scheduler, [&] {
+        for (size_t i = 0; i < 100; ++i)
+        {
+            if (machines[i]->v_registers[1] == 0)
+                return false;
+        }
+        return true;
+    }));
+    CHECK_EQ(scheduler.Totals().wakeups, 100);
+    CHECK_EQ(scheduler.Totals().key_waits, 200);
+    CHECK_EQ(machines[7]->v_registers[0], 0xB);
+    CHECK(machines[7]->v_registers[1] > 0);
+    CHECK_EQ(machines[150]->pc, 0x200);
+    CHECK_EQ(machines[150]->v_registers[1], 0);
+}
+
+TEST(key_set_before_blocking_is_not_lost)
+{
+    Scheduler::Options options;
+    options.workers = 1;
+    options.pin = false;
+    options.frame_hz = 0;
+    Scheduler scheduler(options);
+    auto machines = Machines(1, WAIT_ROM, sizeof(WAIT_ROM));
+    Scheduler::Task task = scheduler.Add(machines[0].get());
+    scheduler.SetKey(task, 3, true);
+    CHECK(RunUntil(scheduler, [&] { return machines[0]->v_registers[1] > 0; }));
+    CHECK_EQ(scheduler.Totals().key_waits, 0);
+    CHECK_EQ(machines[0]->v_registers[0], 3);
+}
+
+TEST(idle_workers_steal)
+{
+    Scheduler::Options options;
+    options.workers = 3;
+    options.pin = false;
+    options.frame_hz = 0;
+    Scheduler scheduler(options);
+    auto machines = Machines(64, LOOP_ROM, sizeof(LOOP_ROM));
+    for (auto &c : machines)
+    {
+        scheduler.Add(c.get(), 0);
+    }
+    // Everything starts on worker 0, the others only get work by stealing it
+    CHECK(RunUntil(scheduler, [&] {
+        for (auto &c : machines)
+        {
+            if (c->frames == 0)
+                return false;
+        }
+        return scheduler.Totals().steals > 0;
+    }));
+}
+
+TEST(paced_tasks_run_at_frame_hz)
+{
+    Scheduler::Options options;
+    options.workers = 2;
+    options.pin = false;
+    options.frame_hz = 100;
+    Scheduler scheduler(options);
+    auto machines = Machines(50, LOOP_ROM, sizeof(LOOP_ROM));
+    for (auto &c : machines)
+    {
+        scheduler.Add(c.get());
+    }
+    // A slow machine only delays frames, pacing must never let a task get ahead of 100 Hz
+    auto started = std::chrono::steady_clock::now();
+    CHECK(RunUntil(scheduler, [&] {
+        for (auto &c : machines)
+        {
+            if (c->frames < 10)
+                return false;
+        }
+        return true;
+    }));
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    for (auto &c : machines)
+    {
+        CHECK(c->frames <= seconds * options.frame_hz + 2);
+    }
+    CHECK(scheduler.Totals().sleeps > 0);
+}
+
+int main()
+{
+    return RunTests("scheduler");
+}
@@ -0,0 +1,110 @@
+// State hashing, the concurrent state set and the search finding a known key sequence.
+#include <thread>
+#include <vector>
+
+#include "check.h"
+#include "chip8.h"
+#include "search.h"
+
+// Waits for key 5, then for key 3, then stores V0..V1 at 0x300 (memory[0x301] = 1).
+static const uint8_t COMBINATION[] = {
+    0x60, 0x05, 0xE0, 0x9E, 0x12, 0x02, // 200: V0 = 5, loop until key V0 is down
+    0x60, 0x03, 0xE0, 0x9E, 0x12, 0x08, // 206: V0 = 3, loop until key V0 is down
+    0x61, 0x01, 0xA3, 0x00, 0xF1, 0x55, // 20C: V1 = 1, I = 300, store V0..V1
+    0x12, 0x12,                         // 212: halt
+};
+
+TEST(hash_covers_state_but_not_video)
+{
+    static chip8 a(1), b(1);
+    a.LoadROM(COMBINATION, sizeof(COMBINATION));
+    b.LoadROM(COMBINATION, sizeof(COMBINATION));
+    CHECK(a.Hash() == b.Hash());
+
+    b.video[5] = 0xFFFFFFFF;
+    b.Rehash();
+    CHECK(a.Hash() == b.Hash());
+
+    b.memory[0xFFF] ^= 1;
+    b.Rehash();
+    CHECK(a.Hash() != b.Hash());
+    b.memory[0xFFF] ^= 1;
+    b.Rehash();
+    b.delay_timer = 1;
+    CHECK(a.Hash() != b.Hash());
+    b.delay_timer = 0;
+    b.stack[15] = 0x200;
+    CHECK(a.Hash() != b.Hash());
+}
+
+TEST(state_set_inserts_once_across_threads)
+{
+    StateSet set(16);
+    std::vector<std::thread> threads;
+    std::vector<int> inserted(4);
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([&, t] {
+            for (uint64_t i = 0; i < 10000; ++i)
+            {
+                inserted[t] += set.Insert(i * 0x9E3779B97F4A7C15ull);
+            }
+        });
+    }
+    for (std::thread &thread : threads)
+    {
+        thread.join();
+    }
+    CHECK_EQ(inserted[0] + inserted[1] + inserted[2] + inserted[3], 10000);
+    CHECK(!set.Insert(0));
+    CHECK(!set.Insert(1)); // 0 and 1 share a slot value
+}
+
+TEST(finds_key_sequence)
+{
+    static chip8 start(1);
+    start.LoadROM(COMBINATION, sizeof(COMBINATION));
+
+    Search::Options options;
+    options.depth = 4;
+    options.beam_width = 0;
+    options.threads = 3;
+    options.table_bits = 12;
+    Search search(options);
+    Search::Result result = search.Run(start, {}, [](chip8 const &c) { return c.memory[0x301] == 1; });
+
+    CHECK(result.found);
+    CHECK_EQ(result.actions.size(), 2);
+    if (result.actions.size() == 2)
+    {
+        CHECK_EQ(result.actions[0], 5);
+        CHECK_EQ(result.actions[1], 3);
+    }
+    // Level 1 only has two distinct states (key 5 held or not), every other key is a duplicate.
+    // On level 2 only key 3 after key 5 leads anywhere new.
+    CHECK_EQ(result.expanded, 17 + 2 * 17);
+    CHECK_EQ(result.unique, 2 + 1);
+}
+
+TEST(beam_follows_score)
+{
+    static chip8 start(1);
+    start.LoadROM(COMBINATION, sizeof(COMBINATION));
+
+    Search::Options options;
+    options.depth = 8;
+    options.beam_width = 1;
+    options.threads = 2;
+    options.table_bits = 12;
+    Search search(options);
+    // Rank by progress through the program
+    Search::Result result = search.Run(start, [](chip8 const &c) { return int64_t{c.pc}; },
+                                       [](chip8 const &c) { return c.memory[0x301] == 1; });
+    CHECK(result.found);
+    CHECK_EQ(result.actions.size(), 2);
+}
+
+int main()
+{
+    return RunTests("search");
+}
@@ -0,0 +1,276 @@
+// StateStore: round trips, dedup, growth past the initial mapping, reopening and index recovery.
+#include <csignal>
+#include <cstddef>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "chip8.h"
+#include "statestore.h"
+
+// Draws, counts and calls so memory, video, registers and stack all change
+static uint8_t const ROM[] = {0x60, 0x05, 0xF0, 0x29, 0xD1, 0x25, 0x71, 0x03, 0xA3, 0x00, 0xF1, 0x55, 0x22, 0x10,
+                              0x12, 0x00, 0x00, 0x00, 0x00, 0xEE};
+
+static std::string Path(char const *name)
+{
+    return "/tmp/c8store_" + std::to_string(getpid()) + "_" + name;
+}
+
+static void Remove(std::string const &path)
+{
+    unlink(path.c_str());
+    unlink((path + ".idx").c_str());
+}
+
+static off_t FileSize(std::string const &path)
+{
+    struct stat info{};
+    return stat(path.c_str(), &info) == 0 ? info.st_size : -1;
+}
+
+// Appends states from c until the store holds count records
+static void FillTo(StateStore &store, chip8 &c, uint64_t count)
+{
+    for (int i = 0; i < 100000 && store.Size() < count; ++i)
+    {
+        c.Run(7);
+        store.Append(c);
+    }
+}
+
+TEST(round_trips_every_field)
+{
+    std::string path = Path("round");
+    Remove(path);
+    chip8 c(7);
+    c.LoadROM(ROM, sizeof(ROM));
+    c.Run(1000);
+    c.keypad[3] = 1;
+
+    StateStore store;
+    CHECK(store.Open(path.c_str()));
+    uint64_t record = store.Append(c);
+    CHECK_EQ(record, 0);
+
+    chip8 back(1);
+    CHECK(store.Load(record, back));
+    CHECK_EQ(back.Digest(), c.Digest());
+    CHECK_EQ(back.memory_digest, c.memory_digest);
+    CHECK_EQ(back.keypad[3], 1);
+    CHECK_EQ(store.Get(record).digest, c.Digest());
+    // Same random stream from here on
+    c.Run(500);
+    back.Run(500);
+    CHECK_EQ(back.Digest(), c.Digest());
+    store.Close();
+    Remove(path);
+}
+
+TEST(dedups_and_grows_across_reopen)
+{
+    std::string path = Path("grow");
+    Remove(path);
+    chip8 c(3);
+    c.LoadROM(ROM, sizeof(ROM));
+
+    // Past the initial 1024 records and 2048 index slots, every state twice
+    std::vector<uint64_t> keys;
+    {
+        StateStore store;
+        CHECK(store.Open(path.c_str()));
+        for (int i = 0; i < 3000; ++i)
+        {
+            c.Run(7);
+            keys.push_back(StateStore::Key(c));
+            bool added = false;
+            uint64_t record = store.Append(c, &added);
+            CHECK(added || store.Get(record).digest == c.Digest());
+            uint64_t again = store.Append(c, &added);
+            CHECK(!added);
+            CHECK_EQ(again, record);
+        }
+    }
+
+    StateStore store;
+    CHECK(store.Open(path.c_str()));
+    uint64_t size = store.Size();
+    CHECK(size > 1024);
+    chip8 back(1);
+    for (uint64_t key : keys)
+    {
+        uint64_t record = store.Find(key);
+        CHECK(record != StateStore::NOT_FOUND);
+        if (record == StateStore::NOT_FOUND)
+            break;
+        CHECK(store.Load(record, back));
+        CHECK_EQ(StateStore::Key(back), key);
+    }
+    CHECK_EQ(store.Find(0x1234), StateStore::NOT_FOUND);
+    store.Close();
+
+    // A lost or stale index is rebuilt from the records
+    unlink((path + ".idx").c_str());
+    CHECK(store.Open(path.c_str()));
+    CHECK_EQ(store.Size(), size);
+    CHECK(store.Find(keys[1234]) != StateStore::NOT_FOUND);
+    store.Close();
+    Remove(path);
+}
+
+TEST(keeps_states_that_replay_differently_apart)
+{
+    std::string path = Path("rng");
+    Remove(path);
+    StateStore store;
+    CHECK(store.Open(path.c_str()));
+
+    // Same Digest(), different random streams: RND after loading must not come out the same
+    uint8_t const rnd[] = {0xC0, 0xFF, 0x12, 0x00};
+    chip8 a(1), b(2);
+    a.LoadROM(rnd, sizeof(rnd));
+    b.LoadROM(rnd, sizeof(rnd));
+    CHECK_EQ(a.Digest(), b.Digest());
+    uint64_t first = store.Append(a);
+    bool added = false;
+    uint64_t second = store.Append(b, &added);
+    CHECK(added);
+    CHECK(first != second);
+
+    // Same again with only a key held
+    b.Reset(1);
+    b.LoadROM(rnd, sizeof(rnd));
+    b.keypad[4] = 1;
+    store.Append(b, &added);
+    CHECK(added);
+    CHECK_EQ(store.Size(), 3);
+
+    chip8 back(9);
+    CHECK(store.Load(first, back));
+    back.Cycle();
+    a.Cycle();
+    CHECK_EQ(back.v_registers[0], a.v_registers[0]);
+    store.Close();
+    Remove(path);
+}
+
+TEST(load_rehashes_instead_of_trusting_the_file)
+{
+    std::string path = Path("damaged");
+    Remove(path);
+    chip8 c(5);
+    c.LoadROM(ROM, sizeof(ROM));
+    c.Run(300);
+    {
+        StateStore store;
+        CHECK(store.Open(path.c_str()));
+        store.Append(c);
+    }
+
+    // Records start after the 4 KB header page
+    size_t snapshot = 4096 + offsetof(StateStore::Record, snapshot);
+    FILE *file = fopen(path.c_str(), "r+b");
+    uint64_t bogus = 0x1234;
+    fseek(file, static_cast<long>(snapshot + offsetof(chip8::Snapshot, memory_digest)), SEEK_SET);
+    fwrite(&bogus, sizeof(bogus), 1, file);
+    fclose(file);
+
+    // A wrong cached hash is recomputed away
+    StateStore store;
+    CHECK(store.Open(path.c_str()));
+    chip8 back(1);
+    CHECK(store.Load(0, back));
+    CHECK_EQ(back.Digest(), c.Digest());
+    store.Close();
+
+    // Damaged memory no longer matches the record's digest
+    file = fopen(path.c_str(), "r+b");
+    fseek(file, static_cast<long>(snapshot + offsetof(chip8::Snapshot, memory) + 0x400), SEEK_SET);
+    fputc(0xAA, file);
+    fclose(file);
+    CHECK(store.Open(path.c_str()));
+    CHECK(!store.Load(0, back));
+    store.Close();
+    Remove(path);
+}
+
+TEST(failed_growth_leaves_the_store_usable)
+{
+    // Files can't grow past RLIMIT_FSIZE (EFBIG instead of SIGXFSZ once that is ignored), which
+    // stands in for a full disk
+    std::string path = Path("full");
+    Remove(path);
+    chip8 c(5);
+    c.LoadROM(ROM, sizeof(ROM));
+    rlimit saved{};
+    getrlimit(RLIMIT_FSIZE, &saved);
+    void (*saved_handler)(int) = signal(SIGXFSZ, SIG_IGN);
+
+    StateStore store;
+    CHECK(store.Open(path.c_str()));
+    FillTo(store, c, 512); // the next Append doubles the 1024 slot index
+    CHECK_EQ(store.Size(), 512);
+    uint64_t first = StateStore::Key(c);
+    rlimit limit = saved;
+    limit.rlim_cur = static_cast<rlim_t>(FileSize(path + ".idx"));
+    setrlimit(RLIMIT_FSIZE, &limit);
+    c.Run(7);
+    CHECK_EQ(store.Append(c), StateStore::NOT_FOUND);
+    CHECK_EQ(store.Size(), 512);
+    CHECK_EQ(store.Find(first), 511);
+    setrlimit(RLIMIT_FSIZE, &saved);
+
+    FillTo(store, c, 1024); // the next Append doubles the data file
+    CHECK_EQ(store.Size(), 1024);
+    uint64_t last = StateStore::Key(c);
+    limit.rlim_cur = static_cast<rlim_t>(FileSize(path));
+    setrlimit(RLIMIT_FSIZE, &limit);
+    c.Run(7);
+    CHECK_EQ(store.Append(c), StateStore::NOT_FOUND);
+    setrlimit(RLIMIT_FSIZE, &saved);
+    signal(SIGXFSZ, saved_handler);
+
+    // Everything still mapped, and appending works again once there is room
+    CHECK_EQ(store.Size(), 1024);
+    CHECK_EQ(store.Find(last), 1023);
+    chip8 back(1);
+    CHECK(store.Load(1023, back));
+    CHECK_EQ(StateStore::Key(back), last);
+    bool added = false;
+    CHECK_EQ(store.Append(c, &added), 1024);
+    CHECK(added);
+    store.Close();
+    Remove(path);
+}
+
+TEST(refuses_files_that_are_not_stores)
+{
+    std::string path = Path("junk");
+    Remove(path);
+    FILE *file = fopen(path.c_str(), "wb");
+    std::string junk(8192, 'x');
+    fwrite(junk.data(), 1, junk.size(), file);
+    fclose(file);
+
+    StateStore store;
+    std::string error;
+    CHECK(!store.Open(path.c_str(), &error));
+    CHECK(!error.empty());
+    // Left alone, not trimmed or given an index
+    file = fopen(path.c_str(), "rb");
+    fseek(file, 0, SEEK_END);
+    CHECK_EQ(ftell(file), 8192);
+    fclose(file);
+    CHECK(access((path + ".idx").c_str(), F_OK) != 0);
+    Remove(path);
+}
+
+int main()
+{
+    return RunTests("statestore");
+}
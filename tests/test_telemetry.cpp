@@ -0,0 +1,104 @@
+// Telemetry lines carry the counters, and reach both file and Unix socket sinks.
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "telemetry.h"
+
+static std::string Field(char const *line, char const *key)
+{
+    std::string needle = std::string(" ") + key + "=";
+    char const *at = strstr(line, needle.c_str());
+    if (!at)
+        return "";
+    at += needle.size();
+    return std::string(at, strcspn(at, " \n"));
+}
+
+TEST(format_reports_totals_rates_and_averages)
+{
+    Telemetry telemetry;
+    for (int i = 0; i < 1000; ++i)
+    {
+        telemetry.Add(Telemetry::Instructions, 1);
+        telemetry.Add(Telemetry::CycleNs, 40);
+        telemetry.Add(Telemetry::CycleCalls, 1);
+    }
+    telemetry.Add(Telemetry::Presented, 30);
+    telemetry.Latency(2000000);
+    telemetry.Latency(4000000);
+
+    uint64_t previous[Telemetry::COUNT]{};
+    char line[512];
+    telemetry.Format(line, sizeof(line), 1.0, 0.5, previous);
+    CHECK_EQ(std::stoull(Field(line, "instructions")), 1000);
+    CHECK_EQ(std::stoull(Field(line, "ips")), 2000);
+    CHECK_EQ(std::stoull(Field(line, "cycle_ns")), 40);
+    CHECK_EQ(std::stod(Field(line, "presented_fps")), 60);
+    CHECK_EQ(std::stoull(Field(line, "latency_us")), 3000);
+    CHECK_EQ(std::stoull(Field(line, "latency_max_us")), 4000);
+
+    // The next interval only sees what happened since
+    telemetry.Add(Telemetry::Instructions, 10);
+    telemetry.Format(line, sizeof(line), 2.0, 1.0, previous);
+    CHECK_EQ(std::stoull(Field(line, "instructions")), 1010);
+    CHECK_EQ(std::stoull(Field(line, "ips")), 10);
+    CHECK_EQ(std::stoull(Field(line, "latency_max_us")), 0);
+}
+
+TEST(exports_to_file)
+{
+    char path[] = "/tmp/c8stats_XXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    {
+        Telemetry telemetry;
+        CHECK(telemetry.Open(path, 20));
+        telemetry.Add(Telemetry::Instructions, 5);
+        std::this_thread::sleep_for(std::chrono::milliseconds(70));
+    }
+    FILE *file = fopen(path, "r");
+    char line[512] = {};
+    CHECK(file && fgets(line, sizeof(line), file));
+    CHECK(strncmp(line, "c8stats ", 8) == 0);
+    CHECK_EQ(std::stoull(Field(line, "instructions")), 5);
+    if (file)
+        fclose(file);
+    unlink(path);
+}
+
+TEST(exports_to_unix_socket)
+{
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/c8stats_%d.sock", static_cast<int>(getpid()));
+    std::string target = std::string("unix:") + path;
+
+    Telemetry telemetry;
+    CHECK(telemetry.Open(target.c_str(), 20));
+    telemetry.Add(Telemetry::Frames, 7);
+
+    int client = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    CHECK_EQ(connect(client, reinterpret_cast<sockaddr *>(&address), sizeof(address)), 0);
+
+    char line[512] = {};
+    ssize_t received = recv(client, line, sizeof(line) - 1, 0);
+    CHECK(received > 0);
+    CHECK_EQ(std::stoull(Field(line, "frames")), 7);
+    close(client);
+    telemetry.Close();
+    CHECK(access(path, F_OK) != 0); // socket file removed
+}
+
+int main()
+{
+    return RunTests("telemetry");
+}
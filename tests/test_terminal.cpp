@@ -0,0 +1,91 @@
+// Terminal input: keys, the quit keys and escape sequences, fed through a pipe in place of stdin.
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "terminal.h"
+
+// Runs one ProcessInput over bytes with stdin a pipe holding them, stdout (the terminal's
+// screen setup) discarded. Returns whether it asked to quit, stdin's file flags while the
+// terminal was up go to flags.
+static bool Feed(char const *bytes, uint8_t *keys, int *flags = nullptr)
+{
+    int in[2];
+    if (pipe(in) != 0)
+    {
+        return false;
+    }
+    fflush(stdout);
+    int saved_in = dup(STDIN_FILENO);
+    int saved_out = dup(STDOUT_FILENO);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(in[0], STDIN_FILENO);
+    dup2(null, STDOUT_FILENO);
+
+    bool quit = false;
+    {
+        Terminal term(64, 32);
+        if (flags)
+        {
+            *flags = fcntl(STDIN_FILENO, F_GETFL);
+        }
+        if (write(in[1], bytes, strlen(bytes)) == static_cast<ssize_t>(strlen(bytes)))
+        {
+            quit = term.ProcessInput(keys);
+        }
+    }
+
+    dup2(saved_in, STDIN_FILENO);
+    dup2(saved_out, STDOUT_FILENO);
+    close(saved_in);
+    close(saved_out);
+    close(null);
+    close(in[0]);
+    close(in[1]);
+    return quit;
+}
+
+TEST(keys_after_an_escape_sequence_still_count)
+{
+    // Up arrow (CSI), then w and e in the same read
+    uint8_t keys[16] = {};
+    CHECK(!Feed("\x1b[Awe", keys));
+    CHECK_EQ(keys[0x5], 1);
+    CHECK_EQ(keys[0x6], 1);
+
+    // CSI with parameters, SS3 and Alt+key each swallow only themselves
+    uint8_t more[16] = {};
+    CHECK(!Feed("\x1b[1;5Cq\x1bOPa\x1bxs", more));
+    CHECK_EQ(more[0x4], 1);
+    CHECK_EQ(more[0x7], 1);
+    CHECK_EQ(more[0x8], 1);
+    CHECK_EQ(more[0x0], 0); // the x after ESC was Alt+x
+}
+
+TEST(lone_escape_and_ctrl_c_quit)
+{
+    uint8_t keys[16] = {};
+    CHECK(Feed("w\x1b", keys));
+    CHECK_EQ(keys[0x5], 1);
+    CHECK(Feed("\x03", keys));
+    CHECK(!Feed("x", keys));
+    CHECK_EQ(keys[0x0], 1);
+}
+
+TEST(stdin_is_left_blocking_and_an_empty_read_returns)
+{
+    // O_NONBLOCK on a tty's stdin would be on its stdout too. The write end stays open here, so a
+    // blind read of the empty pipe would hang.
+    uint8_t keys[16] = {};
+    int flags = 0;
+    CHECK(!Feed("", keys, &flags));
+    CHECK_EQ(flags & O_NONBLOCK, 0);
+}
+
+int main()
+{
+    return RunTests("terminal");
+}
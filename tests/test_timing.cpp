@@ -0,0 +1,139 @@
+// Timing::Vip: frames end when their machine cycle budget is spent, whatever the host.
+#include <cstdlib>
+#include <initializer_list>
+
+#include "check.h"
+#include "chip8.h"
+#include "chip8_c.h"
+
+static chip8 &Load(std::initializer_list<uint16_t> program, int cycles_per_frame = chip8::VIP_CYCLES_PER_FRAME)
+{
+    static chip8 c(1);
+    c.Reset(1);
+    c.timing = chip8::Timing::Vip;
+    c.cycles_per_frame = cycles_per_frame;
+    c.dispatch = chip8::Dispatch::Tables;
+    uint8_t rom[64];
+    size_t size = 0;
+    for (uint16_t op : program)
+    {
+        rom[size++] = op >> 8u;
+        rom[size++] = op & 0xFFu;
+    }
+    c.LoadROM(rom, size);
+    return c;
+}
+
+TEST(flat_frames_are_instruction_counts)
+{
+    chip8 &c = Load({0x6000, 0x1200});
+    c.timing = chip8::Timing::Flat;
+    c.instructions_per_frame = 9;
+    c.Frame();
+    CHECK_EQ(c.cycles, 9);
+    CHECK_EQ(c.frame_cycle, 0);
+}
+
+TEST(non_positive_frame_lengths_have_no_frames)
+{
+    // Frame() does nothing, Run still executes its budget
+    for (chip8::Timing timing : {chip8::Timing::Flat, chip8::Timing::Vip})
+    {
+        chip8 &c = Load({0x6000, 0x1200}, 0);
+        c.timing = timing;
+        c.instructions_per_frame = 0;
+        c.Frame();
+        CHECK_EQ(c.cycles, 0);
+        chip8::RunResult result = c.Run(100, chip8::STOP_FRAME);
+        CHECK_EQ(static_cast<int>(result.reason), static_cast<int>(chip8::StopReason::Budget));
+        CHECK_EQ(result.executed, 100);
+        CHECK_EQ(c.frames, 0);
+        CHECK_EQ(c.frame_cycle, 0);
+    }
+}
+
+TEST(c_api_clamps_instructions_per_frame)
+{
+    void *mem = aligned_alloc(chip8_vm_align(), (chip8_vm_size() + chip8_vm_align() - 1) / chip8_vm_align() *
+                                                    chip8_vm_align());
+    chip8_vm *vm = chip8_create(mem, chip8_vm_size(), 1);
+    uint8_t const rom[] = {0x60, 0x00, 0x12, 0x00};
+    chip8_load(vm, rom, sizeof(rom));
+    chip8_set_instructions_per_frame(vm, 0);
+    uint64_t executed = 0;
+    uint16_t address = 0;
+    // Every instruction is a frame
+    CHECK_EQ(chip8_run(vm, 100, CHIP8_ON_FRAME, &executed, &address), CHIP8_STOP_FRAME);
+    CHECK_EQ(executed, 1);
+    chip8_destroy(vm);
+    free(mem);
+}
+
+TEST(frame_ends_once_the_budget_is_spent_and_carries_the_rest)
+{
+    // LD V0 costs 74, JP 80: 13 instructions make 998, the 14th ends the frame 78 over
+    chip8 &c = Load({0x6000, 0x1200}, 1000);
+    c.Frame();
+    CHECK_EQ(c.cycles, 14);
+    CHECK_EQ(c.frame_cycle, 78);
+    CHECK_EQ(c.frames, 1);
+
+    // Over many frames nothing is lost or gained to rounding
+    for (int i = 0; i < 99; ++i)
+    {
+        c.Frame();
+    }
+    uint64_t spent = 74 * ((c.cycles + 1) / 2) + 80 * (c.cycles / 2);
+    CHECK_EQ(spent, 100 * 1000 + c.frame_cycle);
+}
+
+TEST(sprite_cost_scales_with_height)
+{
+    // Rows cost 46 each: DRW 1 row + JP is 220 a pass, DRW 15 rows + JP is 864
+    chip8 &one = Load({0xD001, 0x1200});
+    one.Frame();
+    CHECK_EQ(one.cycles, 24);
+    chip8 &fifteen = Load({0xD00F, 0x1200});
+    fifteen.Frame();
+    CHECK_EQ(fifteen.cycles, 6);
+}
+
+TEST(taken_skips_cost_more)
+{
+    // SE V0, 0 skips (82) onto JP (80), SE V0, 1 doesn't (78)
+    chip8 &taken = Load({0x3000, 0x0000, 0x1200}, 1620);
+    taken.Frame();
+    CHECK_EQ(taken.cycles, 20);
+    chip8 &not_taken = Load({0x3001, 0x1200}, 1620);
+    not_taken.Frame();
+    CHECK_EQ(not_taken.cycles, 21);
+}
+
+TEST(run_and_dispatch_agree_on_frames)
+{
+    // Draws digits of a counter, so costs vary from instruction to instruction
+    std::initializer_list<uint16_t> program = {0x00E0, 0xF029, 0xD115, 0x7001, 0xF155, 0x3005, 0x1200, 0x6000, 0x1200};
+    chip8 &c = Load(program);
+    for (int i = 0; i < 50; ++i)
+    {
+        c.Frame();
+    }
+    uint64_t cycles = c.cycles;
+    uint64_t digest = c.Digest();
+
+    chip8 &direct = Load(program);
+    direct.dispatch = chip8::Dispatch::Direct;
+    for (int i = 0; i < 50; ++i)
+    {
+        chip8::RunResult result = direct.Run(~0ull, chip8::STOP_FRAME);
+        CHECK_EQ(static_cast<int>(result.reason), static_cast<int>(chip8::StopReason::Frame));
+    }
+    CHECK_EQ(direct.cycles, cycles);
+    CHECK_EQ(direct.Digest(), digest);
+    CHECK_EQ(direct.frames, 50);
+}
+
+int main()
+{
+    return RunTests("timing");
+}
@@ -0,0 +1,70 @@
+// Static ROM analysis: prints a block summary, optionally writes a Graphviz CFG and a hints file
+// (RomAnalysis::WriteHints) for the recompiler and other pre-decoding consumers.
+#include <cstdio>
+#include <cstdlib>
+
+#include "analyzer.h"
+#include "chip8.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s <ROM> [cfg.dot] [rom.hints]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static chip8 c(0);
+    size_t size = c.LoadROM(argv[1]);
+    if (!size)
+    {
+        return EXIT_FAILURE;
+    }
+
+    RomAnalysis analysis = RomAnalysis::Analyze(c.memory, size);
+
+    size_t code = 0, data = 0, both = 0, written = 0, indirect = 0, smc = 0, unknown = 0;
+    for (size_t address = chip8::DATA_START; address < chip8::DATA_START + size; ++address)
+    {
+        uint8_t f = analysis.flags[address];
+        code += (f & RomAnalysis::CODE) ? 1 : 0;
+        data += (f & RomAnalysis::DATA) ? 1 : 0;
+        both += ((f & RomAnalysis::CODE) && (f & RomAnalysis::DATA)) ? 1 : 0;
+        written += (f & RomAnalysis::WRITTEN) ? 1 : 0;
+        indirect += (f & RomAnalysis::INDIRECT) ? 1 : 0;
+    }
+    for (RomAnalysis::Block const &block : analysis.blocks)
+    {
+        smc += block.self_modifying ? 1 : 0;
+        unknown += block.unknown_store ? 1 : 0;
+    }
+
+    printf("%s: %zu bytes, %zu blocks\n", argv[1], size, analysis.blocks.size());
+    printf("  code %zu, data %zu (overlapping %zu), unclassified %zu\n", code, data, both, size - code - data + both);
+    printf("  stored-to %zu, self-modifying blocks %zu, blocks storing through unknown I %zu\n", written, smc, unknown);
+    printf("  indirect jumps (Bnnn) %zu\n", indirect);
+
+    if (argc > 2)
+    {
+        FILE *dot = fopen(argv[2], "w");
+        if (!dot)
+        {
+            fprintf(stderr, "Could not write %s\n", argv[2]);
+            return EXIT_FAILURE;
+        }
+        analysis.WriteDot(dot, c.memory);
+        fclose(dot);
+    }
+    if (argc > 3)
+    {
+        FILE *hints = fopen(argv[3], "w");
+        if (!hints)
+        {
+            fprintf(stderr, "Could not write %s\n", argv[3]);
+            return EXIT_FAILURE;
+        }
+        analysis.WriteHints(hints);
+        fclose(hints);
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+// Batch throughput: runs many instances of a ROM across all CPUs with node-local memory and
+// prints instructions per second per NUMA node (see Batch).
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include "batch.h"
+#include "numa.h"
+
+static void Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s <ROM> [--instances N] [--frames N] [--ipf N] [--snapshot N] [--trace N]\n", exe);
+    fprintf(stderr, "       [--workers N] [--no-pin] [--no-local] [--seed N]\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        Usage(argv[0]);
+    }
+
+    Batch::Options options;
+    for (int i = 2; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--instances") == 0 && more)
+            options.instances = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--frames") == 0 && more)
+            options.frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ipf") == 0 && more)
+            options.instructions_per_frame = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--snapshot") == 0 && more)
+            options.snapshot_every = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--trace") == 0 && more)
+            options.trace_capacity = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--workers") == 0 && more)
+            options.workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--no-pin") == 0)
+            options.pin = false;
+        else if (strcmp(argv[i], "--no-local") == 0)
+            options.local = false;
+        else if (strcmp(argv[i], "--seed") == 0 && more)
+            options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        else
+            Usage(argv[0]);
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (rom.empty())
+    {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    Batch::Result result = Batch::Run(rom.data(), rom.size(), options);
+    if (result.nodes.empty())
+    {
+        fprintf(stderr, "Batch failed (ROM too large or out of memory)\n");
+        return EXIT_FAILURE;
+    }
+
+    printf("%zu instances x %d frames, %zu CPUs on %d nodes, %s, %s memory\n", options.instances, options.frames,
+           Topology::Cpus().size(), Topology::Nodes(), result.pinned ? "pinned" : "unpinned",
+           options.local ? "node-local" : "shared");
+    for (Batch::Node const &node : result.nodes)
+    {
+        printf("node %d: %3d workers %8zu instances %8.1f MB  %9.2f M instructions/s  %8.2f M/s per worker\n",
+               node.node, node.workers, node.instances, node.arena_bytes / 1e6, node.instructions / node.seconds / 1e6,
+               node.instructions / node.seconds / 1e6 / node.workers);
+    }
+    printf("total: %.2f M instructions/s in %.3fs\n", result.instructions / result.seconds / 1e6, result.seconds);
+    return EXIT_SUCCESS;
+}
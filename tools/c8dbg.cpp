@@ -0,0 +1,177 @@
+// Line based interactive debugger over the core, no frontend needed.
+//   s [n]          step n instructions (default 1)
+//   c [budget]     continue until a breakpoint / watchpoint / draw, or budget instructions
+//   f              run to the next frame boundary
+//   b <addr>       toggle breakpoint          w <addr> [len]  toggle watchpoint
+//   r              registers                  m <addr> [len]  hex dump memory
+//   u [addr] [n]   disassemble                t [n]           last n traced instructions
+//   k <key> <0|1>  press / release a key      save <file>     dump the trace ring
+//   q              quit
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <iostream>
+
+#include "chip8.h"
+#include "disassembler.h"
+#include "trace.h"
+
+static char const *REASONS[] = {"budget", "frame", "breakpoint", "watchpoint", "draw"};
+
+static void Registers(chip8 const &c)
+{
+    for (int i = 0; i < 16; ++i)
+    {
+        printf("V%X=%02X%s", i, c.v_registers[i], (i % 8 == 7) ? "\n" : " ");
+    }
+    printf("PC=%03X I=%03X SP=%X DT=%02X ST=%02X cycles=%llu frames=%llu\n", c.pc, c.index, c.sp, c.delay_timer,
+           c.sound_timer, static_cast<unsigned long long>(c.cycles), static_cast<unsigned long long>(c.frames));
+}
+
+static void List(chip8 const &c, unsigned address, unsigned count)
+{
+    char text[32];
+    for (unsigned i = 0; i < count; ++i, address += 2)
+    {
+        uint16_t opcode = (c.memory[address & chip8::MEM_END] << 8u) | c.memory[(address + 1) & chip8::MEM_END];
+        Disassembler::Format(opcode, text, sizeof(text));
+        printf("%c%03X  %04X  %s\n", (address & chip8::MEM_END) == c.pc ? '>' : ' ', address & chip8::MEM_END, opcode, text);
+    }
+}
+
+static void Dump(chip8 const &c, unsigned address, unsigned length)
+{
+    for (unsigned i = 0; i < length; ++i)
+    {
+        if (i % 16 == 0)
+        {
+            printf("%s%03X ", i ? "\n" : "", (address + i) & chip8::MEM_END);
+        }
+        printf(" %02X", c.memory[(address + i) & chip8::MEM_END]);
+    }
+    printf("\n");
+}
+
+static void Tail(TraceRing const &ring, size_t count)
+{
+    char text[32];
+    size_t held = ring.Count();
+    for (size_t i = held > count ? held - count : 0; i < held; ++i)
+    {
+        TraceEntry const &e = ring.At(i);
+        Disassembler::Format(e.opcode, text, sizeof(text));
+        printf("%03X  %04X  %-18s ; I=%03X Vx=%02X VF=%02X\n", e.pc, e.opcode, text, e.index, e.vx, e.vf);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s <ROM> [seed] [trace entries]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    uint32_t seed = argc > 2 ? static_cast<uint32_t>(strtoul(argv[2], nullptr, 0)) : 1;
+    size_t capacity = argc > 3 ? strtoull(argv[3], nullptr, 0) : (1u << 20);
+
+    static chip8 c(seed); // ~17 KB, keep it off the stack
+    if (!c.LoadROM(argv[1]))
+    {
+        return EXIT_FAILURE;
+    }
+    TraceRing ring(capacity);
+    c.trace = &ring;
+
+    List(c, c.pc, 1);
+
+    std::string line;
+    while (printf("(c8dbg) "), fflush(stdout), std::getline(std::cin, line))
+    {
+        std::istringstream in(line);
+        std::string cmd;
+        in >> cmd;
+        unsigned a = 0;
+        unsigned b = 0;
+
+        if (cmd.empty() || cmd == "s")
+        {
+            uint64_t n = 1;
+            in >> n;
+            c.Run(n);
+            List(c, c.pc, 1);
+        }
+        else if (cmd == "c")
+        {
+            uint64_t budget = 100000000;
+            in >> budget;
+            chip8::RunResult result = c.Run(budget, chip8::STOP_DRAW);
+            printf("stopped: %s at %03X after %llu\n", REASONS[static_cast<int>(result.reason)], result.address,
+                   static_cast<unsigned long long>(result.executed));
+            List(c, c.pc, 1);
+        }
+        else if (cmd == "f")
+        {
+            c.Frame();
+            List(c, c.pc, 1);
+        }
+        else if (cmd == "b" && (in >> std::hex >> a))
+        {
+            bool on = !chip8::Test(c.breakpoints, a);
+            c.SetBreakpoint(a, on);
+            printf("breakpoint %03X %s\n", a & chip8::MEM_END, on ? "set" : "cleared");
+        }
+        else if (cmd == "w" && (in >> std::hex >> a))
+        {
+            b = 1;
+            in >> std::dec >> b;
+            bool on = !chip8::Test(c.watchpoints, a);
+            c.SetWatchpoint(a, b, on);
+            printf("watchpoint %03X+%u %s\n", a & chip8::MEM_END, b, on ? "set" : "cleared");
+        }
+        else if (cmd == "r")
+        {
+            Registers(c);
+        }
+        else if (cmd == "m" && (in >> std::hex >> a))
+        {
+            b = 64;
+            in >> std::dec >> b;
+            Dump(c, a, b);
+        }
+        else if (cmd == "u")
+        {
+            a = c.pc;
+            b = 10;
+            in >> std::hex >> a >> std::dec >> b;
+            List(c, a, b);
+        }
+        else if (cmd == "t")
+        {
+            size_t n = 20;
+            in >> n;
+            Tail(ring, n);
+        }
+        else if (cmd == "k" && (in >> std::hex >> a >> b))
+        {
+            c.keypad[a & 0xF] = b ? 1 : 0;
+        }
+        else if (cmd == "save")
+        {
+            std::string path;
+            in >> path;
+            printf("%s\n", (!path.empty() && ring.Save(path.c_str())) ? "saved" : "save failed");
+        }
+        else if (cmd == "q")
+        {
+            break;
+        }
+        else
+        {
+            printf("unknown command, see the top of tools/c8dbg.cpp\n");
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Lockstep differential runner: executes a ROM on two backends (see Lockstep::Backend) with the
+// same seed and scripted key presses, and reports the first instruction after which they differ.
+// --quirks sets the quirks of both machines, or of each, to compare two profiles.
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "chip8.h"
+#include "disassembler.h"
+#include "lockstep.h"
+#include "romdb.h"
+
+static int Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s <ROM> <backend> <backend> [instructions] [seed] [--quirks <left>[:<right>]]\n", exe);
+    fprintf(stderr, "  backends: cycle run restore direct\n");
+    fprintf(stderr, "  quirks: none or shift,load_store,jump,vf_reset,wrap (as in the ROM database), the right\n"
+                    "          machine gets the left one's unless given\n");
+    return EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<char const *> args;
+    char const *quirks = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--quirks") == 0 && i + 1 < argc)
+        {
+            quirks = argv[++i];
+        }
+        else
+        {
+            args.push_back(argv[i]);
+        }
+    }
+
+    Lockstep::Backend a{}, b{};
+    if (args.size() < 3 || args.size() > 5 || !Lockstep::Parse(args[1], a) || !Lockstep::Parse(args[2], b))
+    {
+        return Usage(argv[0]);
+    }
+    uint64_t steps = args.size() > 3 ? strtoull(args[3], nullptr, 0) : 1000000;
+    uint32_t seed = args.size() > 4 ? static_cast<uint32_t>(strtoul(args[4], nullptr, 0)) : 1;
+
+    uint8_t left_quirks = 0, right_quirks = 0;
+    if (quirks)
+    {
+        char const *colon = strchr(quirks, ':');
+        size_t left_length = colon ? static_cast<size_t>(colon - quirks) : strlen(quirks);
+        bool known = RomDb::ParseQuirks(quirks, left_length, left_quirks);
+        right_quirks = left_quirks;
+        if (colon)
+        {
+            known = known && RomDb::ParseQuirks(colon + 1, strlen(colon + 1), right_quirks);
+        }
+        if (!known)
+        {
+            fprintf(stderr, "Unknown quirk in %s\n", quirks);
+            return Usage(argv[0]);
+        }
+    }
+
+    static chip8 left(seed), right(seed);
+    if (!left.LoadROM(args[0]) || !right.LoadROM(args[0]))
+    {
+        return EXIT_FAILURE;
+    }
+    left.quirks = left_quirks;
+    right.quirks = right_quirks;
+
+    // One key (or none) per frame's worth of instructions, derived from the seed.
+    auto input = [seed](uint64_t step, chip8 &c) {
+        if (step % chip8::INST_EXE != 0)
+        {
+            return;
+        }
+        uint32_t h = static_cast<uint32_t>(step / chip8::INST_EXE) * 2654435761u ^ seed;
+        h ^= h >> 15;
+        for (auto &key : c.keypad)
+        {
+            key = 0;
+        }
+        if (h & 0x10u)
+        {
+            c.keypad[h & 0xFu] = 1;
+        }
+    };
+
+    Lockstep::Divergence d = Lockstep::Run(
+        left, right, steps, [a](chip8 &c) { Lockstep::Step(a, c); }, [b](chip8 &c) { Lockstep::Step(b, c); }, input);
+
+    if (!d.found)
+    {
+        printf("%s vs %s (quirks %02X / %02X): identical for %llu instructions\n", Lockstep::Name(a), Lockstep::Name(b),
+               left_quirks, right_quirks, static_cast<unsigned long long>(steps));
+        return EXIT_SUCCESS;
+    }
+
+    char text[32];
+    Disassembler::Format(d.opcode, text, sizeof(text));
+    printf("%s vs %s (quirks %02X / %02X): diverged at instruction %llu, %03X %04X %s (%s), first difference in %s",
+           Lockstep::Name(a), Lockstep::Name(b), left_quirks, right_quirks, static_cast<unsigned long long>(d.step), d.pc,
+           d.opcode, text, Disassembler::Handler(d.opcode), d.field);
+    if (d.address)
+    {
+        printf(" at %03X", d.address);
+    }
+    printf("\n");
+    return 2;
+}
@@ -0,0 +1,119 @@
+// Dispatch benchmark: runs ROMs with the nibble tables and with the 65536 entry direct table and
+// prints instructions per second for each. With several ROMs the machines take turns a slice at a
+// time, so the handlers of all of them compete for the instruction cache as they would in a batch.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include "chip8.h"
+
+static void Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s <ROM>... [--instructions N] [--slice N] [--repeat N] [--seed N]\n", exe);
+    exit(EXIT_FAILURE);
+}
+
+struct Options
+{
+    uint64_t instructions = 50000000; // per mode and repeat, split across the ROMs
+    uint64_t slice = 1000;            // instructions a machine runs before the next one's turn
+    int repeat = 3;                   // best of
+    uint32_t seed = 1;
+};
+
+// Runs every machine from power-on, returns instructions per second and the combined digest
+static double Measure(std::vector<std::vector<uint8_t>> const &roms, Options const &options, chip8::Dispatch dispatch,
+                      uint64_t &digest)
+{
+    std::vector<std::unique_ptr<chip8>> machines;
+    for (auto const &rom : roms)
+    {
+        machines.emplace_back(new chip8(options.seed));
+        machines.back()->LoadROM(rom.data(), rom.size());
+        machines.back()->dispatch = dispatch;
+    }
+
+    uint64_t per_machine = options.instructions / machines.size();
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t done = 0; done < per_machine; done += options.slice)
+    {
+        uint64_t budget = per_machine - done < options.slice ? per_machine - done : options.slice;
+        for (auto &c : machines)
+        {
+            c->Run(budget);
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    digest = 0;
+    for (auto &c : machines)
+    {
+        digest = digest * 31 + c->Digest();
+    }
+    return per_machine * machines.size() / seconds;
+}
+
+int main(int argc, char *argv[])
+{
+    Options options;
+    std::vector<std::vector<uint8_t>> roms;
+    for (int i = 1; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--instructions") == 0 && more)
+            options.instructions = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--slice") == 0 && more)
+            options.slice = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--repeat") == 0 && more)
+            options.repeat = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && more)
+            options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        else if (argv[i][0] == '-')
+            Usage(argv[0]);
+        else
+        {
+            std::ifstream file(argv[i], std::ios::binary);
+            roms.emplace_back((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+            if (roms.back().empty() || roms.back().size() > chip8::DATA_END - chip8::DATA_START + 1)
+            {
+                fprintf(stderr, "Could not read %s\n", argv[i]);
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    if (roms.empty() || options.slice == 0 || options.repeat <= 0)
+    {
+        Usage(argv[0]);
+    }
+
+    // Alternating the modes each repeat keeps frequency scaling from favouring one of them
+    double tables = 0, direct = 0;
+    uint64_t tables_digest = 0, direct_digest = 0;
+    for (int r = 0; r < options.repeat; ++r)
+    {
+        double a = Measure(roms, options, chip8::Dispatch::Tables, tables_digest);
+        double b = Measure(roms, options, chip8::Dispatch::Direct, direct_digest);
+        tables = a > tables ? a : tables;
+        direct = b > direct ? b : direct;
+    }
+
+    printf("%zu ROM(s), %llu instructions per run, slice %llu\n", roms.size(),
+           static_cast<unsigned long long>(options.instructions), static_cast<unsigned long long>(options.slice));
+    printf("tables %.1f M/s, direct %.1f M/s (%.2fx)\n", tables / 1e6, direct / 1e6, direct / tables);
+    if (!chip8::direct_compiled)
+    {
+        printf("direct handlers not built (make DIRECT=1), direct ran the tables\n");
+    }
+    if (tables_digest != direct_digest)
+    {
+        printf("DIVERGED: final states differ (%016llx vs %016llx)\n", static_cast<unsigned long long>(tables_digest),
+               static_cast<unsigned long long>(direct_digest));
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,178 @@
+// Shared memory environment server (see EnvServer) and its client benchmark.
+//   c8env serve <ROM> [options]      serve until a client sends shutdown
+//   c8env client [--steps N]         step a running server, print env-steps/s, shut it down
+//   c8env bench <ROM> [options]      both, the server in a child process
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "env.h"
+
+static void Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s serve|bench <ROM> [--instances N] [--workers N] [--frames N] [--ipf N]\n", exe);
+    fprintf(stderr, "       [--reward ADDR] [--done ADDR] [--max-frames N] [--seed N] [--no-pin]\n");
+    fprintf(stderr, "       %s client [--steps N]\n", exe);
+    fprintf(stderr, "       all: [--socket PATH] [--shm NAME]\n");
+    exit(EXIT_FAILURE);
+}
+
+// Random key presses every step, the loop a policy would run, timed end to end
+static int Client(char const *socket_path, char const *shm_name, uint64_t steps)
+{
+    EnvClient client;
+    // The server may still be starting
+    for (int attempt = 0; !client.Connect(socket_path, shm_name); ++attempt)
+    {
+        if (attempt == 200)
+        {
+            fprintf(stderr, "Could not connect to %s / %s\n", socket_path, shm_name);
+            return EXIT_FAILURE;
+        }
+        usleep(10000);
+    }
+
+    size_t instances = client.Instances();
+    uint32_t state = 1;
+    uint64_t dones = 0;
+    double reward = 0;
+    uint64_t checksum = 0;
+    client.Reset();
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t step = 0; step < steps; ++step)
+    {
+        uint16_t *actions = client.Actions();
+        for (size_t i = 0; i < instances; ++i)
+        {
+            state = state * 1664525u + 1013904223u;
+            actions[i] = static_cast<uint16_t>(1u << (state >> 28));
+        }
+        if (!client.Step())
+        {
+            fprintf(stderr, "Server went away at step %llu\n", static_cast<unsigned long long>(step));
+            return EXIT_FAILURE;
+        }
+        // Touch what a policy would read: one byte per frame, every reward and done
+        for (size_t i = 0; i < instances; ++i)
+        {
+            checksum += client.Frame(i)[(step + i) % 256];
+            reward += client.Rewards()[i];
+            dones += client.Dones()[i];
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%zu instances, %llu steps: %.0f env-steps/s (%.1f us per batched step), reward %.0f, episodes ended %llu, "
+           "checksum %llu\n",
+           instances, static_cast<unsigned long long>(steps), steps * instances / seconds, seconds / steps * 1e6, reward,
+           static_cast<unsigned long long>(dones), static_cast<unsigned long long>(checksum));
+    client.Shutdown();
+    return EXIT_SUCCESS;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        Usage(argv[0]);
+    }
+    char const *mode = argv[1];
+    bool serve = strcmp(mode, "serve") == 0;
+    bool bench = strcmp(mode, "bench") == 0;
+    if (!serve && !bench && strcmp(mode, "client") != 0)
+    {
+        Usage(argv[0]);
+    }
+    int first = serve || bench ? 3 : 2;
+    if (argc < first)
+    {
+        Usage(argv[0]);
+    }
+
+    EnvServer::Options options;
+    char const *socket_path = "/tmp/c8env.sock";
+    char const *shm_name = "/c8env";
+    uint64_t steps = 100000;
+    for (int i = first; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--instances") == 0 && more)
+            options.instances = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--workers") == 0 && more)
+            options.workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && more)
+            options.frames_per_step = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ipf") == 0 && more)
+            options.instructions_per_frame = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--reward") == 0 && more)
+            options.reward_address = static_cast<int>(strtol(argv[++i], nullptr, 0));
+        else if (strcmp(argv[i], "--done") == 0 && more)
+            options.done_address = static_cast<int>(strtol(argv[++i], nullptr, 0));
+        else if (strcmp(argv[i], "--max-frames") == 0 && more)
+            options.max_frames = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        else if (strcmp(argv[i], "--seed") == 0 && more)
+            options.seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        else if (strcmp(argv[i], "--no-pin") == 0)
+            options.pin = false;
+        else if (strcmp(argv[i], "--steps") == 0 && more)
+            steps = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--socket") == 0 && more)
+            socket_path = argv[++i];
+        else if (strcmp(argv[i], "--shm") == 0 && more)
+            shm_name = argv[++i];
+        else
+            Usage(argv[0]);
+    }
+
+    if (!serve && !bench)
+    {
+        return Client(socket_path, shm_name, steps);
+    }
+
+    std::ifstream file(argv[2], std::ios::binary);
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (rom.empty())
+    {
+        fprintf(stderr, "Could not read %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    if (bench)
+    {
+        pid_t child = fork();
+        if (child < 0)
+        {
+            perror("fork");
+            return EXIT_FAILURE;
+        }
+        if (child > 0)
+        {
+            int result = Client(socket_path, shm_name, steps);
+            int status = 0;
+            waitpid(child, &status, 0);
+            return result;
+        }
+    }
+
+    EnvServer server;
+    if (!server.Open(socket_path, shm_name, rom.data(), rom.size(), options))
+    {
+        fprintf(stderr, "Could not start the server on %s / %s\n", socket_path, shm_name);
+        return EXIT_FAILURE;
+    }
+    if (serve)
+    {
+        printf("serving %zu instances on %s, observations in %s\n", options.instances, socket_path, shm_name);
+        fflush(stdout);
+    }
+    server.Serve();
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,340 @@
+// Ahead-of-time recompiler: turns a ROM into a C++ translation unit with one function per
+// recovered basic block (see analyzer.h) operating directly on chip8 state, plus the
+// aot_program table aot.h expects. Build and check the result with `make aot ROM=<file>`.
+//
+// Per instruction the generated code does what chip8::Cycle does, in the same order, except:
+//   - operands are constants, so there's no fetch, decode or dispatch
+//   - pc and opcode are only materialised where something can observe them
+//   - timer decrements are batched and flushed before instructions that touch the timers
+// Anything with non-trivial semantics (Dxyn, Cxkk, BCD, loads/stores, ...) calls the same
+// OP_* member the interpreter uses, so the two can't drift apart. Stores end their block so the
+// next block's entry check sees any code they rewrote; self-modifying blocks found by the
+// analysis aren't compiled at all, and neither is anything reached only through Bnnn.
+// Opcodes outside the documented set go through the interpreter's own dispatch table and end
+// the block, since the tables decode them by partial masks (e.g. 0x0000 clears the screen).
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "analyzer.h"
+#include "chip8.h"
+#include "disassembler.h"
+
+namespace
+{
+    uint16_t Fetch(chip8 const &c, uint16_t address)
+    {
+        return (c.memory[address & chip8::MEM_END] << 8u) | c.memory[(address + 1) & chip8::MEM_END];
+    }
+
+    bool TouchesTimers(uint16_t opcode)
+    {
+        if ((opcode & 0xF000u) != 0xF000u)
+        {
+            return false;
+        }
+        uint8_t low = opcode & 0x00FFu;
+        return low == 0x07u || low == 0x15u || low == 0x18u;
+    }
+
+    // Members that read only opcode (not pc) and don't branch
+    char const *Helper(uint16_t opcode)
+    {
+        switch (opcode & 0xF000u)
+        {
+            case 0x0000u:
+                return opcode == 0x00E0u ? "OP_00E0" : nullptr;
+            case 0x8000u:
+                switch (opcode & 0x000Fu)
+                {
+                    case 0x5u: return "OP_8xy5";
+                    case 0x6u: return "OP_8xy6";
+                    case 0x7u: return "OP_8xy7";
+                    case 0xEu: return "OP_8xyE";
+                }
+                return nullptr;
+            case 0xC000u:
+                return "OP_Cxkk";
+            case 0xD000u:
+                return "OP_Dxyn";
+            case 0xF000u:
+                switch (opcode & 0x00FFu)
+                {
+                    case 0x29u: return "OP_Fx29";
+                    case 0x33u: return "OP_Fx33";
+                    case 0x55u: return "OP_Fx55";
+                    case 0x65u: return "OP_Fx65";
+                }
+                return nullptr;
+        }
+        return nullptr;
+    }
+
+    bool IsStore(uint16_t opcode)
+    {
+        return (opcode & 0xF0FFu) == 0xF055u || (opcode & 0xF0FFu) == 0xF033u;
+    }
+
+    bool Documented(uint16_t opcode)
+    {
+        return strcmp(Disassembler::Handler(opcode), "OP_NULL") != 0;
+    }
+
+    // Quirks are per machine, not per ROM, so the generated code checks them like the OP_* members
+    char const *const VF_RESET = "    if (c.quirks & chip8::QUIRK_VF_RESET)\n        c.v_registers[0xF] = 0;\n";
+
+    void EmitBlock(FILE *out, chip8 const &c, RomAnalysis::Block const &block)
+    {
+        fprintf(out, "// %03X-%03X\n", block.start, block.end - 1);
+        fprintf(out, "static uint32_t Block_%03X(chip8 &c)\n{\n", block.start);
+
+        // Entry check: the bytes still say what we compiled.
+        fprintf(out, "    static constexpr uint8_t code[] = {");
+        for (uint16_t address = block.start; address < block.end; ++address)
+        {
+            fprintf(out, "%s0x%02X", address == block.start ? "" : ", ", c.memory[address]);
+        }
+        fprintf(out, "};\n");
+        fprintf(out, "    if (memcmp(&c.memory[0x%03X], code, sizeof(code)) != 0)\n        return 0;\n\n", block.start);
+
+        unsigned ticks = 0; // timer decrements owed
+        unsigned count = 0;
+        auto flush = [&]() {
+            if (ticks)
+            {
+                fprintf(out, "    Tick(c, %u);\n", ticks);
+                ticks = 0;
+            }
+        };
+
+        for (uint16_t address = block.start; address < block.end; address += 2)
+        {
+            uint16_t opcode = Fetch(c, address);
+            unsigned x = (opcode & 0x0F00u) >> 8u;
+            unsigned y = (opcode & 0x00F0u) >> 4u;
+            unsigned kk = opcode & 0x00FFu;
+            unsigned nnn = opcode & 0x0FFFu;
+            uint16_t next = address + 2;
+            bool last = next >= block.end;
+            ++count;
+
+            if (TouchesTimers(opcode))
+            {
+                flush();
+            }
+
+            if (!Documented(opcode))
+            {
+                fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = 0x%03X;\n    ((c).*(c.table[0x%X]))();\n", opcode, next,
+                        opcode >> 12u);
+                ++ticks;
+                flush();
+                fprintf(out, "    return %u;\n}\n\n", count);
+                return;
+            }
+
+            char const *helper = Helper(opcode);
+            if (helper)
+            {
+                fprintf(out, "    c.opcode = 0x%04X;\n    c.%s();\n", opcode, helper);
+            }
+            else if (opcode == 0x00EEu)
+            {
+                fprintf(out, "    c.opcode = 0x00EE;\n    c.sp = (c.sp - 1) & 0xF;\n    c.pc = c.stack[c.sp];\n");
+            }
+            else
+            {
+                fprintf(out, "    // %04X\n", opcode);
+                switch (opcode & 0xF000u)
+                {
+                    case 0x1000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = 0x%03X;\n", opcode, nnn);
+                        break;
+                    case 0x2000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n    c.stack[c.sp & 0xF] = 0x%03X;\n    c.sp = (c.sp + 1) & 0xF;\n    c.pc = 0x%03X;\n",
+                                opcode, next, nnn);
+                        break;
+                    case 0x3000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = (c.v_registers[%u] == 0x%02X) ? 0x%03X : 0x%03X;\n",
+                                opcode, x, kk, next + 2, next);
+                        break;
+                    case 0x4000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = (c.v_registers[%u] != 0x%02X) ? 0x%03X : 0x%03X;\n",
+                                opcode, x, kk, next + 2, next);
+                        break;
+                    case 0x5000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = (c.v_registers[%u] == c.v_registers[%u]) ? 0x%03X : 0x%03X;\n",
+                                opcode, x, y, next + 2, next);
+                        break;
+                    case 0x9000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = (c.v_registers[%u] != c.v_registers[%u]) ? 0x%03X : 0x%03X;\n",
+                                opcode, x, y, next + 2, next);
+                        break;
+                    case 0x6000u:
+                        fprintf(out, "    c.v_registers[%u] = 0x%02X;\n", x, kk);
+                        break;
+                    case 0x7000u:
+                        fprintf(out, "    c.v_registers[%u] += 0x%02X;\n", x, kk);
+                        break;
+                    case 0x8000u:
+                        switch (opcode & 0x000Fu)
+                        {
+                            case 0x0u: fprintf(out, "    c.v_registers[%u] = c.v_registers[%u];\n", x, y); break;
+                            case 0x1u: fprintf(out, "    c.v_registers[%u] |= c.v_registers[%u];\n%s", x, y, VF_RESET); break;
+                            case 0x2u: fprintf(out, "    c.v_registers[%u] &= c.v_registers[%u];\n%s", x, y, VF_RESET); break;
+                            case 0x3u: fprintf(out, "    c.v_registers[%u] ^= c.v_registers[%u];\n%s", x, y, VF_RESET); break;
+                            case 0x4u:
+                                fprintf(out, "    {\n        uint16_t sum = c.v_registers[%u] + c.v_registers[%u];\n"
+                                             "        c.v_registers[%u] = sum & 0xFFu;\n"
+                                             "        c.v_registers[0xF] = (sum > 255U) ? 1 : 0;\n    }\n", x, y, x);
+                                break;
+                            default: break; // unknown 8xy? is OP_NULL
+                        }
+                        break;
+                    case 0xA000u:
+                        fprintf(out, "    c.index = 0x%03X;\n", nnn);
+                        break;
+                    case 0xB000u:
+                        fprintf(out, "    c.opcode = 0x%04X;\n"
+                                     "    c.pc = c.v_registers[(c.quirks & chip8::QUIRK_JUMP) ? %u : 0] + 0x%03X;\n",
+                                opcode, x, nnn);
+                        break;
+                    case 0xE000u:
+                        // keypad lookups go through the member so out of range keys behave the same
+                        if (kk == 0x9Eu || kk == 0xA1u)
+                        {
+                            fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = 0x%03X;\n    c.OP_%s();\n", opcode, next,
+                                    kk == 0x9Eu ? "Ex9E" : "ExA1");
+                        }
+                        break;
+                    case 0xF000u:
+                        switch (kk)
+                        {
+                            case 0x07u: fprintf(out, "    c.v_registers[%u] = c.delay_timer;\n", x); break;
+                            case 0x15u: fprintf(out, "    c.delay_timer = c.v_registers[%u];\n", x); break;
+                            case 0x18u: fprintf(out, "    c.sound_timer = c.v_registers[%u];\n", x); break;
+                            case 0x1Eu: fprintf(out, "    c.index = c.index + c.v_registers[%u];\n", x); break;
+                            case 0x0Au:
+                                fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = 0x%03X;\n    c.OP_Fx0A();\n", opcode, next);
+                                break;
+                            default: break;
+                        }
+                        break;
+                    default:
+                        break; // unknown opcodes are OP_NULL
+                }
+            }
+            ++ticks;
+
+            bool waits = (opcode & 0xF0FFu) == 0xF00Au;
+            if (waits)
+            {
+                // Fx0A rewinds pc while no key is down, leave the block either way.
+                flush();
+                fprintf(out, "    c.opcode = 0x%04X;\n    return %u;\n}\n\n", opcode, count);
+                return;
+            }
+            if (IsStore(opcode) && !last)
+            {
+                flush();
+                fprintf(out, "    c.pc = 0x%03X;\n    return %u;\n}\n\n", next, count);
+                return;
+            }
+            if (last)
+            {
+                // Terminators already set pc (and opcode), fallthrough/end blocks didn't.
+                bool sets_pc = opcode == 0x00EEu || (opcode & 0xF000u) == 0x1000u || (opcode & 0xF000u) == 0x2000u ||
+                               (opcode & 0xF000u) == 0x3000u || (opcode & 0xF000u) == 0x4000u ||
+                               (opcode & 0xF000u) == 0x5000u || (opcode & 0xF000u) == 0x9000u ||
+                               (opcode & 0xF000u) == 0xB000u || (opcode & 0xF0FFu) == 0xE09Eu ||
+                               (opcode & 0xF0FFu) == 0xE0A1u;
+                if (!sets_pc)
+                {
+                    fprintf(out, "    c.opcode = 0x%04X;\n    c.pc = 0x%03X;\n", opcode, next);
+                }
+                flush();
+                fprintf(out, "    return %u;\n}\n\n", count);
+                return;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3 || argc > 4)
+    {
+        fprintf(stderr, "Usage: %s <ROM> <out.cpp> [rom.hints]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    static chip8 c(0);
+    size_t size = c.LoadROM(argv[1]);
+    if (!size)
+    {
+        return EXIT_FAILURE;
+    }
+
+    RomAnalysis analysis;
+    if (argc == 4)
+    {
+        FILE *hints = fopen(argv[3], "r");
+        if (!hints || !RomAnalysis::ReadHints(hints, analysis))
+        {
+            fprintf(stderr, "Could not read hints from %s\n", argv[3]);
+            return EXIT_FAILURE;
+        }
+        fclose(hints);
+    }
+    else
+    {
+        analysis = RomAnalysis::Analyze(c.memory, size);
+    }
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out)
+    {
+        fprintf(stderr, "Could not write %s\n", argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(out, "// Generated by c8recomp from %s, do not edit.\n", argv[1]);
+    fprintf(out, "#include <cstring>\n\n#include \"aot.h\"\n\n");
+    fprintf(out, "static inline void Tick(chip8 &c, unsigned n)\n{\n"
+                 "    c.delay_timer = c.delay_timer > n ? c.delay_timer - n : 0;\n"
+                 "    c.sound_timer = c.sound_timer > n ? c.sound_timer - n : 0;\n}\n\n");
+
+    uint32_t compiled = 0;
+    for (RomAnalysis::Block const &block : analysis.blocks)
+    {
+        if (block.self_modifying)
+        {
+            fprintf(out, "// %03X-%03X left to the interpreter (self-modifying)\n\n", block.start, block.end - 1);
+            continue;
+        }
+        EmitBlock(out, c, block);
+        ++compiled;
+    }
+
+    fprintf(out, "static uint32_t RunBlock(chip8 &c)\n{\n    switch (c.pc)\n    {\n");
+    for (RomAnalysis::Block const &block : analysis.blocks)
+    {
+        if (!block.self_modifying)
+        {
+            fprintf(out, "        case 0x%03X: return Block_%03X(c);\n", block.start, block.start);
+        }
+    }
+    fprintf(out, "    }\n    return 0;\n}\n\n");
+
+    fprintf(out, "static constexpr uint8_t rom[] = {");
+    for (size_t i = 0; i < size; ++i)
+    {
+        fprintf(out, "%s%s0x%02X", i ? "," : "", (i % 16 == 0) ? "\n    " : " ", c.memory[chip8::DATA_START + i]);
+    }
+    fprintf(out, "\n};\n\n");
+    fprintf(out, "AotProgram const aot_program = {rom, sizeof(rom), RunBlock, %u};\n", compiled);
+
+    fclose(out);
+    fprintf(stderr, "%s: %u of %zu blocks compiled\n", argv[2], compiled, analysis.blocks.size());
+    return 0;
+}
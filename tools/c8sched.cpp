@@ -0,0 +1,99 @@
+// Scheduler density: hosts many sessions on a few threads and reports what they cost. --active of
+// them run the ROM at --hz, the rest sit in Fx0A waiting for a key (as an idle session would), and
+// the CPU time used over the run shows that only the active ones are paid for.
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "chip8.h"
+#include "scheduler.h"
+
+static void Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s <ROM> [--tasks N] [--active N] [--workers N] [--hz N] [--seconds N] [--no-pin]\n", exe);
+    exit(EXIT_FAILURE);
+}
+
+static double CpuSeconds()
+{
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        Usage(argv[0]);
+    }
+
+    Scheduler::Options options;
+    size_t tasks = 10000;
+    size_t active = 100;
+    double seconds = 5;
+    for (int i = 2; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--tasks") == 0 && more)
+            tasks = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--active") == 0 && more)
+            active = strtoull(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--workers") == 0 && more)
+            options.workers = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--hz") == 0 && more)
+            options.frame_hz = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && more)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--no-pin") == 0)
+            options.pin = false;
+        else
+            Usage(argv[0]);
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+    std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (rom.empty())
+    {
+        fprintf(stderr, "Could not read %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    static uint8_t const idle[] = {0xF0, 0x0A, 0x12, 0x00}; // LD V0, K; JP 200
+
+    std::vector<std::unique_ptr<chip8>> machines;
+    Scheduler scheduler(options);
+    for (size_t i = 0; i < tasks; ++i)
+    {
+        machines.emplace_back(new chip8(static_cast<uint32_t>(i + 1)));
+        if (i < active)
+            machines.back()->LoadROM(rom.data(), rom.size());
+        else
+            machines.back()->LoadROM(idle, sizeof(idle));
+        scheduler.Add(machines.back().get());
+    }
+
+    double cpu = CpuSeconds();
+    auto start = std::chrono::steady_clock::now();
+    scheduler.Start();
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    scheduler.Stop();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cpu = CpuSeconds() - cpu;
+
+    Scheduler::Stats stats = scheduler.Totals();
+    printf("%zu tasks (%zu active at %d Hz, %zu waiting on a key)\n", tasks, active, options.frame_hz, tasks - active);
+    printf("%.0f frames/s (%.1f per active task), cpu %.1f%% of one core, %.2f us cpu per frame\n",
+           stats.frames / wall, active ? stats.frames / wall / active : 0.0, cpu / wall * 100,
+           stats.frames ? cpu / stats.frames * 1e6 : 0.0);
+    printf("key waits %llu, steals %llu, worker sleeps %llu\n", static_cast<unsigned long long>(stats.key_waits),
+           static_cast<unsigned long long>(stats.steals), static_cast<unsigned long long>(stats.sleeps));
+    return EXIT_SUCCESS;
+}
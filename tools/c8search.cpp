@@ -0,0 +1,103 @@
+// Automated playtesting: searches keypad sequences that make a ROM reach a goal, e.g. a score
+// byte reaching a value, ranking states by another byte (see Search).
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "chip8.h"
+#include "search.h"
+
+static void Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s <ROM> [--goal ADDR=VALUE] [--score ADDR] [--beam N] [--bfs] [--depth N]\n", exe);
+    fprintf(stderr, "       [--frames N] [--ipf N] [--threads N] [--table BITS] [--keys MASK] [--seed N]\n");
+    fprintf(stderr, "  goal: memory[ADDR] >= VALUE, score: memory[ADDR] (higher is better)\n");
+    exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        Usage(argv[0]);
+    }
+
+    Search::Options options;
+    long goal_address = -1, goal_value = 0, score_address = -1;
+    uint32_t seed = 1;
+    int ipf = chip8::INST_EXE;
+    for (int i = 2; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--goal") == 0 && more)
+        {
+            char *end;
+            goal_address = strtol(argv[++i], &end, 0);
+            if (*end != '=')
+            {
+                Usage(argv[0]);
+            }
+            goal_value = strtol(end + 1, nullptr, 0);
+        }
+        else if (strcmp(argv[i], "--score") == 0 && more)
+            score_address = strtol(argv[++i], nullptr, 0);
+        else if (strcmp(argv[i], "--beam") == 0 && more)
+            options.beam_width = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--bfs") == 0)
+            options.beam_width = 0;
+        else if (strcmp(argv[i], "--depth") == 0 && more)
+            options.depth = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && more)
+            options.frames_per_action = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ipf") == 0 && more)
+            ipf = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && more)
+            options.threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--table") == 0 && more)
+            options.table_bits = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--keys") == 0 && more)
+            options.keys = static_cast<uint16_t>(strtoul(argv[++i], nullptr, 16));
+        else if (strcmp(argv[i], "--seed") == 0 && more)
+            seed = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 0));
+        else
+            Usage(argv[0]);
+    }
+
+    static chip8 start(seed);
+    if (!start.LoadROM(argv[1]))
+    {
+        return EXIT_FAILURE;
+    }
+    start.instructions_per_frame = ipf;
+
+    Search::Score score;
+    if (score_address >= 0)
+    {
+        uint16_t address = score_address & chip8::MEM_END;
+        score = [address](chip8 const &c) { return int64_t{c.memory[address]}; };
+    }
+    Search::Goal goal;
+    if (goal_address >= 0)
+    {
+        uint16_t address = goal_address & chip8::MEM_END;
+        goal = [address, goal_value](chip8 const &c) { return c.memory[address] >= goal_value; };
+    }
+
+    Search search(options);
+    Search::Result result = search.Run(start, score, goal);
+
+    printf("%s after %d levels, score %lld, %zu actions:\n", result.found ? "goal reached" : "goal not reached",
+           result.levels, static_cast<long long>(result.score), result.actions.size());
+    for (size_t i = 0; i < result.actions.size(); ++i)
+    {
+        // one character per action: key in hex, '.' for no key
+        putchar(result.actions[i] == Search::NO_KEY ? '.' : "0123456789ABCDEF"[result.actions[i]]);
+    }
+    putchar('\n');
+
+    double rate = result.seconds > 0 ? result.expanded / result.seconds : 0;
+    printf("%llu states (%llu unique) in %.3fs, %.2f M states/s, %.2f M/s per thread (%d threads, %d frames x %d)\n",
+           static_cast<unsigned long long>(result.expanded), static_cast<unsigned long long>(result.unique),
+           result.seconds, rate / 1e6, rate / 1e6 / result.threads, result.threads, options.frames_per_action, ipf);
+    return result.found || !goal ? EXIT_SUCCESS : 2;
+}
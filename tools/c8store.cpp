@@ -0,0 +1,137 @@
+// State store: fills a store from ROM runs and measures how fast states come back out of it.
+//   add   runs --seeds machines for --frames frames, appending the state after every frame
+//   load  restores every record into one machine, cold (after dropping the page cache is up to
+//         the caller) or warm, and checks each against its stored digest
+//   info  record count and size
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "chip8.h"
+#include "statestore.h"
+
+static void Usage(char const *exe)
+{
+    fprintf(stderr, "Usage: %s <store> add <ROM> [--frames N] [--seeds N] [--ipf N]\n", exe);
+    fprintf(stderr, "       %s <store> load [--passes N]\n", exe);
+    fprintf(stderr, "       %s <store> info\n", exe);
+    exit(EXIT_FAILURE);
+}
+
+static double Since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        Usage(argv[0]);
+    }
+    char const *command = argv[2];
+    bool add = strcmp(command, "add") == 0;
+    if (add && argc < 4)
+    {
+        Usage(argv[0]);
+    }
+
+    int frames = 1000;
+    int seeds = 1;
+    int ipf = chip8::INST_EXE;
+    int passes = 1;
+    for (int i = add ? 4 : 3; i < argc; ++i)
+    {
+        bool more = i + 1 < argc;
+        if (strcmp(argv[i], "--frames") == 0 && more)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seeds") == 0 && more)
+            seeds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--ipf") == 0 && more)
+            ipf = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--passes") == 0 && more)
+            passes = atoi(argv[++i]);
+        else
+            Usage(argv[0]);
+    }
+
+    StateStore store;
+    std::string error;
+    auto start = std::chrono::steady_clock::now();
+    if (!store.Open(argv[1], &error))
+    {
+        fprintf(stderr, "%s\n", error.c_str());
+        return EXIT_FAILURE;
+    }
+    double open_ms = Since(start) * 1e3;
+
+    if (add)
+    {
+        std::ifstream file(argv[3], std::ios::binary);
+        std::vector<uint8_t> rom((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (rom.empty())
+        {
+            fprintf(stderr, "Could not read %s\n", argv[3]);
+            return EXIT_FAILURE;
+        }
+
+        uint64_t before = store.Size();
+        start = std::chrono::steady_clock::now();
+        for (int seed = 1; seed <= seeds; ++seed)
+        {
+            chip8 c(static_cast<uint32_t>(seed));
+            c.instructions_per_frame = ipf;
+            c.LoadROM(rom.data(), rom.size());
+            for (int frame = 0; frame < frames; ++frame)
+            {
+                c.Frame();
+                if (store.Append(c) == StateStore::NOT_FOUND)
+                {
+                    fprintf(stderr, "Could not grow %s\n", argv[1]);
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        double seconds = Since(start);
+        uint64_t offered = static_cast<uint64_t>(frames) * seeds;
+        uint64_t added = store.Size() - before;
+        printf("%llu states offered, %llu new, %llu already stored, %.0f appends/s\n",
+               static_cast<unsigned long long>(offered), static_cast<unsigned long long>(added),
+               static_cast<unsigned long long>(offered - added), offered / seconds);
+    }
+    else if (strcmp(command, "load") == 0)
+    {
+        chip8 c(1);
+        uint64_t mismatches = 0;
+        for (int pass = 0; pass < passes; ++pass)
+        {
+            start = std::chrono::steady_clock::now();
+            for (uint64_t record = 0; record < store.Size(); ++record)
+            {
+                mismatches += !store.Load(record, c);
+            }
+            double seconds = Since(start);
+            printf("pass %d: %llu states in %.3f s, %.0f states/s, %.2f GB/s\n", pass,
+                   static_cast<unsigned long long>(store.Size()), seconds, store.Size() / seconds,
+                   store.Size() * sizeof(StateStore::Record) / seconds / 1e9);
+        }
+        if (mismatches)
+        {
+            printf("%llu states did not match their digest\n", static_cast<unsigned long long>(mismatches));
+            return EXIT_FAILURE;
+        }
+    }
+    else if (strcmp(command, "info") != 0)
+    {
+        Usage(argv[0]);
+    }
+
+    printf("%llu records of %zu bytes, opened in %.3f ms\n", static_cast<unsigned long long>(store.Size()),
+           sizeof(StateStore::Record), open_ms);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,63 @@
+// Decodes a trace ring dump (TraceRing::Save) to text, one instruction per line:
+//   <seq> <pc> <opcode> <disassembly>  ; I=<index> Vx=<vx> VF=<vf>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "disassembler.h"
+#include "trace.h"
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "Usage: %s <trace file> [last N]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    FILE *file = fopen(argv[1], "rb");
+    if (!file)
+    {
+        fprintf(stderr, "Could not open %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    char magic[4];
+    uint32_t version = 0;
+    uint64_t count = 0;
+    if (fread(magic, 1, 4, file) != 4 || memcmp(magic, "C8TR", 4) != 0 ||
+        fread(&version, sizeof(version), 1, file) != 1 || version != 1 ||
+        fread(&count, sizeof(count), 1, file) != 1)
+    {
+        fprintf(stderr, "%s is not a chip8 trace\n", argv[1]);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+
+    uint64_t skip = 0;
+    if (argc == 3)
+    {
+        uint64_t last = strtoull(argv[2], nullptr, 0);
+        skip = last < count ? count - last : 0;
+    }
+    fseek(file, static_cast<long>(skip * sizeof(TraceEntry)), SEEK_CUR);
+
+    // Decode in chunks, the file can hold millions of entries.
+    static TraceEntry chunk[4096];
+    char text[32];
+    uint64_t seq = skip;
+    size_t got;
+    while ((got = fread(chunk, sizeof(TraceEntry), 4096, file)) > 0)
+    {
+        for (size_t i = 0; i < got; ++i, ++seq)
+        {
+            TraceEntry const &e = chunk[i];
+            Disassembler::Format(e.opcode, text, sizeof(text));
+            printf("%10llu  %03X  %04X  %-18s ; I=%03X V%X=%02X VF=%02X\n", static_cast<unsigned long long>(seq),
+                   e.pc, e.opcode, text, e.index, (e.opcode & 0x0F00u) >> 8u, e.vx, e.vf);
+        }
+    }
+
+    fclose(file);
+    return 0;
+}